@@ -0,0 +1,140 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+// Genera láminas sintéticas en el formato binario del programa: el número
+// de filas y de columnas (size_t) seguido de las celdas (double) por filas.
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Patrones de temperatura que puede generar el programa
+ */
+typedef enum {
+  PATRON_ALEATORIO,
+  PATRON_BORDES,
+  PATRON_GRADIENTE,
+  PATRON_PUNTO,
+} patron_t;
+
+// Siguiente número de la secuencia splitmix64, así una semilla genera la
+// misma lámina en cualquier sistema
+static uint64_t siguiente_aleatorio(uint64_t* estado) {
+  uint64_t valor = (*estado += 0x9E3779B97F4A7C15ULL);
+  valor = (valor ^ (valor >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  valor = (valor ^ (valor >> 27)) * 0x94D049BB133111EBULL;
+  return valor ^ (valor >> 31);
+}
+
+// Temperatura de la celda (i, j) según el patrón, entre 0 y 100
+static double temperatura(patron_t patron, size_t i, size_t j,
+    size_t n_filas, size_t n_columnas, uint64_t* estado) {
+  const bool borde = i == 0 || j == 0 || i == n_filas - 1
+      || j == n_columnas - 1;
+  switch (patron) {
+    case PATRON_ALEATORIO:
+      return (double) (siguiente_aleatorio(estado) >> 11) * 0x1.0p-53 * 100.0;
+    case PATRON_BORDES:
+      return borde ? 100.0 : 0.0;
+    case PATRON_GRADIENTE:
+      return n_columnas > 1 ? 100.0 * (double) j / (double) (n_columnas - 1)
+          : 0.0;
+    case PATRON_PUNTO: {
+      // Un cuadrado caliente en el centro con un cuarto del lado
+      const size_t alto = n_filas / 4;
+      const size_t ancho = n_columnas / 4;
+      const bool centro = i >= (n_filas - alto) / 2
+          && i < (n_filas + alto) / 2 && j >= (n_columnas - ancho) / 2
+          && j < (n_columnas + ancho) / 2;
+      return centro && !borde ? 100.0 : 0.0;
+    }
+  }
+  return 0.0;
+}
+
+// Convierte el nombre de un patrón, retorna false si no existe
+static bool leer_patron(const char* nombre, patron_t* patron) {
+  static const struct {
+    const char* nombre;
+    patron_t patron;
+  } patrones[] = {
+    {"aleatorio", PATRON_ALEATORIO},
+    {"bordes", PATRON_BORDES},
+    {"gradiente", PATRON_GRADIENTE},
+    {"punto", PATRON_PUNTO},
+  };
+  for (size_t k = 0; k < sizeof(patrones) / sizeof(patrones[0]); ++k) {
+    if (strcmp(nombre, patrones[k].nombre) == 0) {
+      *patron = patrones[k].patron;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Escribe una lámina de filas x columnas con el patrón pedido.
+ *
+ * Uso: generar_lamina ruta filas columnas [patron] [semilla]. El patrón es
+ * aleatorio (por omisión), bordes, gradiente o punto. Las filas se generan
+ * y escriben una a la vez, así se pueden crear láminas más grandes que la
+ * memoria.
+ *
+ * @param argc Número de argumentos de la línea de comandos.
+ * @param argv Arreglo que contiene los argumentos.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 4) {
+    fprintf(stderr, "Uso: %s ruta filas columnas "
+      "[aleatorio|bordes|gradiente|punto] [semilla]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  size_t n_filas = 0;
+  size_t n_columnas = 0;
+  if (sscanf(argv[2], "%zu", &n_filas) != 1
+      || sscanf(argv[3], "%zu", &n_columnas) != 1
+      || n_filas == 0 || n_columnas == 0) {
+    fprintf(stderr, "Error: filas y columnas deben ser positivas\n");
+    return EXIT_FAILURE;
+  }
+  patron_t patron = PATRON_ALEATORIO;
+  if (argc > 4 && !leer_patron(argv[4], &patron)) {
+    fprintf(stderr, "Error: patrón desconocido: %s\n", argv[4]);
+    return EXIT_FAILURE;
+  }
+  uint64_t estado = 1;
+  if (argc > 5 && sscanf(argv[5], "%" SCNu64, &estado) != 1) {
+    fprintf(stderr, "Error: semilla inválida: %s\n", argv[5]);
+    return EXIT_FAILURE;
+  }
+  double* fila = (double*) malloc(n_columnas * sizeof(double));
+  FILE* archivo = fopen(argv[1], "wb");
+  if (fila == NULL || archivo == NULL) {
+    fprintf(stderr, "Error al crear %s: %s\n", argv[1], strerror(errno));
+    free(fila);
+    if (archivo) {
+      fclose(archivo);
+    }
+    return EXIT_FAILURE;
+  }
+  bool error = fwrite(&n_filas, sizeof(size_t), 1, archivo) != 1
+      || fwrite(&n_columnas, sizeof(size_t), 1, archivo) != 1;
+  for (size_t i = 0; i < n_filas && !error; ++i) {
+    for (size_t j = 0; j < n_columnas; ++j) {
+      fila[j] = temperatura(patron, i, j, n_filas, n_columnas, &estado);
+    }
+    error = fwrite(fila, sizeof(double), n_columnas, archivo) != n_columnas;
+  }
+  if (fclose(archivo) != 0) {
+    error = true;
+  }
+  free(fila);
+  if (error) {
+    fprintf(stderr, "Error al escribir %s: %s\n", argv[1], strerror(errno));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
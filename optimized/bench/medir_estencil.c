@@ -0,0 +1,233 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+// Mide cada implementación del estencil aislada del resto del programa, con
+// láminas cuadradas desde las que caben en L1 hasta las que solo caben en
+// memoria principal. El estencil por lotes se mide con CARRILES_LOTE láminas
+// que ocupan entre todas lo mismo que una lámina de las otras mediciones.
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/estencil.h"
+#include "../src/miscelaneos.h"
+
+/**
+ * @brief Tamaños de trabajo a medir, en bytes de las dos matrices
+ */
+static const size_t TAMANOS[] = {
+  (size_t) 16 << 10, (size_t) 128 << 10, (size_t) 1 << 20,
+  (size_t) 8 << 20, (size_t) 64 << 20, (size_t) 512 << 20,
+};
+/**
+ * @brief Implementaciones en double, en el orden de ESTENCIL_ISA
+ */
+static const char* const IMPLEMENTACIONES[] = {
+  "escalar", "sse2", "avx2", "avx512",
+};
+/**
+ * @brief Operaciones de punto flotante por celda: 4 sumas y 1 resta del
+ * laplaciano, la multiplicación, la suma final y el cambio absoluto
+ */
+#define FLOPS_CELDA 8.0
+/**
+ * @brief Coeficiente de las mediciones, estable para el estencil explícito
+ */
+#define COEFICIENTE 0.2
+
+// Evita que el compilador descarte los cambios calculados
+static volatile double sumidero;
+
+// Tiempo monotónico en segundos
+static double ahora(void) {
+  struct timespec tiempo;
+  clock_gettime(CLOCK_MONOTONIC, &tiempo);
+  return (double) tiempo.tv_sec + (double) tiempo.tv_nsec * 1e-9;
+}
+
+// Número aleatorio en [0, 100) con una secuencia xorshift64
+static double aleatorio(uint64_t* estado) {
+  *estado ^= *estado << 13;
+  *estado ^= *estado >> 7;
+  *estado ^= *estado << 17;
+  return (double) (*estado >> 11) * 0x1.0p-53 * 100.0;
+}
+
+// Imprime una fila de resultados. Las celdas cuentan las de todas las
+// láminas que se avanzan a la vez
+static void reportar(const char* implementacion, const char* tipo,
+    size_t n, size_t laminas, size_t bytes_celda, size_t pasadas,
+    double segundos) {
+  const double celdas = (double) (n - 2) * (double) (n - 2)
+      * (double) laminas * (double) pasadas;
+  printf("%s\t%s\t%zu\t%zu\t%zu\t%zu\t%.3f\t%.2f\t%.2f\n", implementacion,
+    tipo, n, n, 2 * n * n * laminas * bytes_celda, pasadas,
+    segundos * 1e9 / celdas,
+    celdas * 2.0 * (double) bytes_celda / segundos * 1e-9,
+    celdas * FLOPS_CELDA / segundos * 1e-9);
+  fflush(stdout);
+}
+
+// Repite pasadas completas del estencil en double hasta superar minimo
+// segundos y reporta el resultado
+static void medir_doble(const char* implementacion, double* matrices[2],
+    size_t n, size_t paso, double minimo) {
+  // Una pasada de calentamiento carga las matrices y las páginas
+  sumidero = calcular_filas(matrices[0], matrices[1], paso, n, 1, n - 1,
+    COEFICIENTE);
+  size_t pasadas = 0;
+  const double inicio = ahora();
+  double segundos = 0.0;
+  do {
+    const size_t actual = pasadas % 2;
+    sumidero = calcular_filas(matrices[actual], matrices[1 - actual], paso,
+      n, 1, n - 1, COEFICIENTE);
+    ++pasadas;
+    segundos = ahora() - inicio;
+  } while (segundos < minimo);
+  reportar(implementacion, "double", n, 1, sizeof(double), pasadas,
+    segundos);
+}
+
+// Igual que medir_doble() pero con el estencil en float
+static void medir_simple(const char* implementacion, float* matrices[2],
+    size_t n, size_t paso, double minimo) {
+  sumidero = calcular_filas_simple(matrices[0], matrices[1], paso, n, 1,
+    n - 1, COEFICIENTE);
+  size_t pasadas = 0;
+  const double inicio = ahora();
+  double segundos = 0.0;
+  do {
+    const size_t actual = pasadas % 2;
+    sumidero = calcular_filas_simple(matrices[actual], matrices[1 - actual],
+      paso, n, 1, n - 1, COEFICIENTE);
+    ++pasadas;
+    segundos = ahora() - inicio;
+  } while (segundos < minimo);
+  reportar(implementacion, "float", n, 1, sizeof(float), pasadas, segundos);
+}
+
+// Igual que medir_doble() pero con CARRILES_LOTE láminas de n x n celdas
+// intercaladas, avanzadas a la vez por el estencil por lotes
+static void medir_lote(const char* implementacion, double* matrices[2],
+    size_t n, double minimo) {
+  double coeficientes[CARRILES_LOTE];
+  double maximos[CARRILES_LOTE];
+  for (size_t k = 0; k < CARRILES_LOTE; ++k) {
+    coeficientes[k] = COEFICIENTE;
+  }
+  calcular_lote(matrices[0], matrices[1], n, n, coeficientes, maximos);
+  sumidero = maximos[0];
+  size_t pasadas = 0;
+  const double inicio = ahora();
+  double segundos = 0.0;
+  do {
+    const size_t actual = pasadas % 2;
+    calcular_lote(matrices[actual], matrices[1 - actual], n, n,
+      coeficientes, maximos);
+    sumidero = maximos[0];
+    ++pasadas;
+    segundos = ahora() - inicio;
+  } while (segundos < minimo);
+  reportar(implementacion, "lote", n, CARRILES_LOTE, sizeof(double), pasadas,
+    segundos);
+}
+
+// Mide todas las implementaciones con una lámina de n x n celdas
+static bool medir_tamano(size_t n, double minimo, uint64_t* estado) {
+  const size_t paso = calcular_paso(n);
+  const size_t flotantes_linea = LINEA_CACHE / sizeof(float);
+  const size_t paso_simple = (n + flotantes_linea - 1) / flotantes_linea
+      * flotantes_linea;
+  double* doble[2] = {reservar_matriz(n, paso), reservar_matriz(n, paso)};
+  float* simple[2] = {
+    (float*) aligned_alloc(LINEA_CACHE, n * paso_simple * sizeof(float)),
+    (float*) aligned_alloc(LINEA_CACHE, n * paso_simple * sizeof(float)),
+  };
+  // Los carriles reparten el mismo tamaño de trabajo entre CARRILES_LOTE
+  // láminas más pequeñas
+  const size_t n_lote = (size_t) sqrt((double) (n * n) / CARRILES_LOTE);
+  double* lote[2] = {
+    reservar_matriz(n_lote * n_lote, CARRILES_LOTE),
+    reservar_matriz(n_lote * n_lote, CARRILES_LOTE),
+  };
+  const bool hay_memoria = doble[0] && doble[1] && simple[0] && simple[1]
+      && lote[0] && lote[1];
+  if (hay_memoria) {
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < paso; ++j) {
+        const double valor = j < n ? aleatorio(estado) : 0.0;
+        doble[0][i * paso + j] = doble[1][i * paso + j] = valor;
+        if (j < paso_simple) {
+          simple[0][i * paso_simple + j] = simple[1][i * paso_simple + j]
+            = (float) valor;
+        }
+      }
+    }
+    for (size_t c = 0; c < n_lote * n_lote * CARRILES_LOTE; ++c) {
+      lote[0][c] = lote[1][c] = aleatorio(estado);
+    }
+    for (size_t k = 0; k < sizeof(IMPLEMENTACIONES)
+        / sizeof(IMPLEMENTACIONES[0]); ++k) {
+      // Se salta la implementación si el procesador no la soporta
+      setenv(ESTENCIL_ENTORNO, IMPLEMENTACIONES[k], 1);
+      seleccionar_estencil();
+      if (strcmp(nombre_estencil(), IMPLEMENTACIONES[k]) != 0) {
+        continue;
+      }
+      medir_doble(IMPLEMENTACIONES[k], doble, n, paso, minimo);
+      // Solo hay versiones en float escalar y avx2
+      if (k == 0 || k == 2) {
+        medir_simple(IMPLEMENTACIONES[k], simple, n, paso_simple, minimo);
+      }
+      medir_lote(IMPLEMENTACIONES[k], lote, n_lote, minimo);
+    }
+  } else {
+    fprintf(stderr, "Error: no hay memoria para láminas de %zux%zu\n", n, n);
+  }
+  free(doble[0]);
+  free(doble[1]);
+  free(simple[0]);
+  free(simple[1]);
+  free(lote[0]);
+  free(lote[1]);
+  return hay_memoria;
+}
+
+/**
+ * @brief Mide el estencil con láminas de tamaño creciente.
+ *
+ * Uso: medir_estencil [bytes_max] [segundos]. Mide los tamaños de trabajo
+ * (las dos matrices en double) de 16 KiB a bytes_max, 512 MiB por omisión,
+ * durante al menos segundos cada uno, 0.2 por omisión. Imprime una tabla
+ * separada por tabuladores con ns por celda, GB/s y GFLOP/s. Los GB/s
+ * suponen que cada celda se lee y se escribe una vez, el mínimo de tráfico.
+ * Las filas de tipo lote cuentan las celdas de todos los carriles.
+ *
+ * @param argc Número de argumentos de la línea de comandos.
+ * @param argv Arreglo que contiene los argumentos.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int main(int argc, char* argv[]) {
+  size_t bytes_max = TAMANOS[sizeof(TAMANOS) / sizeof(TAMANOS[0]) - 1];
+  double minimo = 0.2;
+  if ((argc > 1 && sscanf(argv[1], "%zu", &bytes_max) != 1)
+      || (argc > 2 && (sscanf(argv[2], "%lf", &minimo) != 1
+      || !(minimo > 0.0)))) {
+    fprintf(stderr, "Uso: %s [bytes_max] [segundos]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  printf("implementacion\ttipo\tfilas\tcolumnas\tbytes\tpasadas\tns_celda"
+    "\tGB_s\tGFLOP_s\n");
+  uint64_t estado = 88172645463325252ULL;
+  for (size_t k = 0; k < sizeof(TAMANOS) / sizeof(TAMANOS[0])
+      && TAMANOS[k] <= bytes_max; ++k) {
+    const size_t n = (size_t) sqrt((double) TAMANOS[k] / 16.0);
+    if (!medir_tamano(n, minimo, &estado)) {
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
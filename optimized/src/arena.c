@@ -0,0 +1,117 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include "arena.h"
+
+// Libera las matrices libres más pequeñas mientras los bytes libres superen
+// el presupuesto. Se llama con el mutex tomado
+static void recortar_arena(arena_t* arena) {
+  while (arena->bytes_libres > arena->presupuesto) {
+    bufer_t** menor = NULL;
+    for (bufer_t** anterior = &arena->buferes; *anterior;
+        anterior = &(*anterior)->siguiente) {
+      if ((*anterior)->libre
+          && (menor == NULL || (*anterior)->bytes < (*menor)->bytes)) {
+        menor = anterior;
+      }
+    }
+    bufer_t* bufer = *menor;
+    *menor = bufer->siguiente;
+    arena->bytes_libres -= bufer->bytes;
+    liberar_matriz(bufer->matriz);
+    free(bufer);
+  }
+}
+
+void crear_arena(arena_t* arena, size_t presupuesto) {
+  pthread_mutex_init(&arena->mutex, NULL);
+  arena->buferes = NULL;
+  arena->bytes_libres = 0;
+  arena->presupuesto = presupuesto;
+}
+
+double* tomar_matriz(arena_t* arena, size_t n_filas, size_t paso) {
+  const size_t bytes = n_filas * paso * sizeof(double);
+  if (arena == NULL || arena->presupuesto == 0) {
+    return reservar_matriz(n_filas, paso);
+  }
+  // La libre más pequeña en que quepa
+  pthread_mutex_lock(&arena->mutex);
+  bufer_t* elegido = NULL;
+  for (bufer_t* bufer = arena->buferes; bufer; bufer = bufer->siguiente) {
+    if (bufer->libre && bufer->bytes >= bytes
+        && (elegido == NULL || bufer->bytes < elegido->bytes)) {
+      elegido = bufer;
+    }
+  }
+  if (elegido) {
+    elegido->libre = false;
+    arena->bytes_libres -= elegido->bytes;
+  }
+  pthread_mutex_unlock(&arena->mutex);
+  if (elegido) {
+    return elegido->matriz;
+  }
+
+  // Ninguna alcanza, se reserva una nueva que la arena recordará
+  bufer_t* bufer = (bufer_t*) malloc(sizeof(bufer_t));
+  double* matriz = reservar_matriz(n_filas, paso);
+  if (bufer == NULL || matriz == NULL) {
+    free(bufer);
+    liberar_matriz(matriz);
+    return NULL;
+  }
+  bufer->matriz = matriz;
+  bufer->bytes = bytes;
+  bufer->libre = false;
+  pthread_mutex_lock(&arena->mutex);
+  bufer->siguiente = arena->buferes;
+  arena->buferes = bufer;
+  pthread_mutex_unlock(&arena->mutex);
+  return matriz;
+}
+
+double* tomar_matriz_bordes(arena_t* arena, const double* matriz,
+    size_t n_filas, size_t n_columnas, size_t paso) {
+  double* matriz2 = tomar_matriz(arena, n_filas, paso);
+  if (matriz2 == NULL) {
+    return NULL;
+  }
+  copiar_bordes(matriz, matriz2, n_filas, n_columnas, paso, 0, n_filas);
+  return matriz2;
+}
+
+void devolver_matriz(arena_t* arena, double* matriz) {
+  if (matriz == NULL) {
+    return;
+  }
+  bufer_t* encontrado = NULL;
+  if (arena) {
+    pthread_mutex_lock(&arena->mutex);
+    for (bufer_t* bufer = arena->buferes; bufer && !encontrado;
+        bufer = bufer->siguiente) {
+      if (bufer->matriz == matriz) {
+        encontrado = bufer;
+      }
+    }
+    if (encontrado) {
+      encontrado->libre = true;
+      arena->bytes_libres += encontrado->bytes;
+      recortar_arena(arena);
+    }
+    pthread_mutex_unlock(&arena->mutex);
+  }
+  if (encontrado == NULL) {
+    // Reservada fuera de la arena, por ejemplo al reanudar
+    liberar_matriz(matriz);
+  }
+}
+
+void destruir_arena(arena_t* arena) {
+  while (arena->buferes) {
+    bufer_t* bufer = arena->buferes;
+    arena->buferes = bufer->siguiente;
+    liberar_matriz(bufer->matriz);
+    free(bufer);
+  }
+  arena->bytes_libres = 0;
+  pthread_mutex_destroy(&arena->mutex);
+}
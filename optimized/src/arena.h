@@ -0,0 +1,109 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef ARENA_H
+#define ARENA_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "miscelaneos.h"
+/**
+ * @brief Megabytes de matrices libres que conserva la arena si el usuario
+ * no indica otro presupuesto
+ */
+#define ARENA_MB_OMISION 1024
+/**
+ * @brief Matriz reservada por la arena
+ */
+typedef struct bufer {
+  /**
+   * @brief Inicio de la matriz
+   */
+  double* matriz;
+  /**
+   * @brief Bytes que caben en la matriz
+   */
+  size_t bytes;
+  /**
+   * @brief Indica si se puede entregar a otra lámina
+   */
+  bool libre;
+  /**
+   * @brief Siguiente matriz de la arena
+   */
+  struct bufer* siguiente;
+} bufer_t;
+/**
+ * @brief Matrices de láminas que se reutilizan entre líneas, compartidas
+ * por todos los hilos.
+ *
+ * Cada línea del archivo de trabajo necesita dos matrices del tamaño de su
+ * lámina, y la tubería y los carriles otra por cada lámina resultante. En
+ * vez de reservarlas y liberarlas por cada línea, la arena conserva las
+ * matrices devueltas y entrega la más pequeña en que quepa la siguiente
+ * lámina, sin inicializarla, con sus páginas ya presentes. Cuando los bytes
+ * libres superan el presupuesto se liberan las matrices libres más
+ * pequeñas, así quedan las más grandes que se han visto.
+ */
+typedef struct {
+  /**
+   * @brief Protege la lista y los contadores
+   */
+  pthread_mutex_t mutex;
+  /**
+   * @brief Matrices entregadas y libres, en cualquier orden
+   */
+  bufer_t* buferes;
+  /**
+   * @brief Bytes de las matrices libres
+   */
+  size_t bytes_libres;
+  /**
+   * @brief Bytes que pueden ocupar las matrices libres, 0 desactiva la
+   * arena
+   */
+  size_t presupuesto;
+} arena_t;
+/**
+ * @brief Inicializa una arena vacía.
+ *
+ * @param arena Arena a inicializar.
+ * @param presupuesto Bytes que pueden ocupar las matrices libres.
+ */
+void crear_arena(arena_t* arena, size_t presupuesto);
+/**
+ * @brief Entrega una matriz sin inicializar, como reservar_matriz().
+ *
+ * @param arena Arena creada con crear_arena(), o NULL para reservarla con
+ * reservar_matriz().
+ * @param n_filas Número de filas de la matriz.
+ * @param paso Paso de las filas de la matriz.
+ * @return Matriz o NULL si no se pudo reservar.
+ */
+double* tomar_matriz(arena_t* arena, size_t n_filas, size_t paso);
+/**
+ * @brief Entrega la matriz del estado siguiente con los bordes de matriz,
+ * como crear_matriz_bordes().
+ *
+ * @param arena Arena creada con crear_arena(), o NULL.
+ * @param matriz Matriz con el estado inicial.
+ * @param n_filas Número de filas de la matriz.
+ * @param n_columnas Número de columnas de la matriz.
+ * @param paso Paso de las filas de la matriz.
+ * @return Matriz o NULL si no se pudo reservar.
+ */
+double* tomar_matriz_bordes(arena_t* arena, const double* matriz,
+  size_t n_filas, size_t n_columnas, size_t paso);
+/**
+ * @brief Devuelve una matriz a la arena. Si no salió de la arena se libera
+ * con liberar_matriz(). No hace nada con NULL.
+ *
+ * @param arena Arena creada con crear_arena(), o NULL.
+ * @param matriz Matriz a devolver.
+ */
+void devolver_matriz(arena_t* arena, double* matriz);
+/**
+ * @brief Libera todas las matrices de la arena, que ya deben estar libres.
+ *
+ * @param arena Arena creada con crear_arena().
+ */
+void destruir_arena(arena_t* arena);
+#endif
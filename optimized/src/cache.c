@@ -0,0 +1,192 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <sys/stat.h>
+#include "cache.h"
+
+// Bytes que ocupa la matriz de una imagen
+static size_t bytes_imagen(const imagen_t* imagen) {
+  return imagen->n_filas * imagen->paso * sizeof(double);
+}
+
+// Quita de la lista y libera las imágenes sin referencias que ya no son
+// vigentes o que exceden el presupuesto, de la menos a la más reciente. Se
+// llama con el mutex tomado
+static void descartar_imagenes(cache_t* cache) {
+  // Primero las que ya no son vigentes
+  imagen_t** anterior = &cache->imagenes;
+  while (*anterior) {
+    imagen_t* imagen = *anterior;
+    if (!imagen->vigente && imagen->referencias == 0) {
+      *anterior = imagen->siguiente;
+      cache->bytes -= bytes_imagen(imagen);
+      devolver_matriz(cache->arena, imagen->matriz);
+      free(imagen);
+    } else {
+      anterior = &imagen->siguiente;
+    }
+  }
+  // Luego la menos usada mientras no quepan, buscándola desde el final
+  while (cache->bytes > cache->presupuesto) {
+    imagen_t** descartable = NULL;
+    for (anterior = &cache->imagenes; *anterior;
+        anterior = &(*anterior)->siguiente) {
+      if ((*anterior)->referencias == 0) {
+        descartable = anterior;
+      }
+    }
+    if (descartable == NULL) {
+      // Todas se están copiando, se descartarán al soltarlas
+      break;
+    }
+    imagen_t* imagen = *descartable;
+    *descartable = imagen->siguiente;
+    cache->bytes -= bytes_imagen(imagen);
+    devolver_matriz(cache->arena, imagen->matriz);
+    free(imagen);
+  }
+}
+
+// Copia la imagen en las matrices de trabajo, se llama con una referencia
+// tomada y sin el mutex
+static bool copiar_imagen(cache_t* cache, const imagen_t* imagen,
+    size_t* n_filas, size_t* n_columnas, size_t* paso, double** matriz,
+    double** matriz2) {
+  *n_filas = imagen->n_filas;
+  *n_columnas = imagen->n_columnas;
+  *paso = imagen->paso;
+  *matriz = tomar_matriz(cache->arena, imagen->n_filas, imagen->paso);
+  if (*matriz == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", imagen->ruta);
+    return false;
+  }
+  // El relleno de la imagen ya está en cero, se copia el bloque completo
+  memcpy(*matriz, imagen->matriz, bytes_imagen(imagen));
+  *matriz2 = tomar_matriz_bordes(cache->arena, imagen->matriz,
+    imagen->n_filas, imagen->n_columnas, imagen->paso);
+  if (*matriz2 == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", imagen->ruta);
+    devolver_matriz(cache->arena, *matriz);
+    return false;
+  }
+  return true;
+}
+
+// Suelta la referencia tomada para copiar la imagen
+static void soltar_imagen(cache_t* cache, imagen_t* imagen) {
+  pthread_mutex_lock(&cache->mutex);
+  --imagen->referencias;
+  descartar_imagenes(cache);
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+void crear_cache(cache_t* cache, size_t presupuesto, arena_t* arena) {
+  pthread_mutex_init(&cache->mutex, NULL);
+  cache->imagenes = NULL;
+  cache->bytes = 0;
+  cache->presupuesto = presupuesto;
+  cache->arena = arena;
+}
+
+bool cargar_de_cache(cache_t* cache, const char* ruta, size_t* n_filas,
+    size_t* n_columnas, size_t* paso, double** matriz, double** matriz2,
+    equipo_t* equipo, size_t hilos) {
+  struct stat estado;
+  if (cache->presupuesto == 0 || stat(ruta, &estado) != 0) {
+    // Sin caché, o cargar_matriz() reporta por qué no se puede abrir
+    if (!cargar_matriz(ruta, n_filas, n_columnas, paso, matriz,
+        cache->arena, equipo, hilos)) {
+      return false;
+    }
+    *matriz2 = tomar_matriz_bordes(cache->arena, *matriz, *n_filas,
+      *n_columnas, *paso);
+    if (*matriz2 == NULL) {
+      fprintf(stderr, "Error al crear las matrices de %s\n", ruta);
+      devolver_matriz(cache->arena, *matriz);
+      return false;
+    }
+    return true;
+  }
+  // Buscar la imagen del archivo tal como está ahora
+  pthread_mutex_lock(&cache->mutex);
+  imagen_t* encontrada = NULL;
+  for (imagen_t** anterior = &cache->imagenes; *anterior && !encontrada;
+      anterior = &(*anterior)->siguiente) {
+    imagen_t* imagen = *anterior;
+    if (!imagen->vigente || strcmp(imagen->ruta, ruta) != 0) {
+      continue;
+    }
+    if (imagen->tamano == (size_t) estado.st_size
+        && imagen->modificacion.tv_sec == estado.st_mtim.tv_sec
+        && imagen->modificacion.tv_nsec == estado.st_mtim.tv_nsec) {
+      // Pasa al inicio de la lista por ser la más reciente
+      encontrada = imagen;
+      *anterior = imagen->siguiente;
+      imagen->siguiente = cache->imagenes;
+      cache->imagenes = imagen;
+      ++imagen->referencias;
+      break;
+    }
+    // El archivo cambió desde que se cargó
+    imagen->vigente = false;
+  }
+  descartar_imagenes(cache);
+  pthread_mutex_unlock(&cache->mutex);
+
+  if (encontrada) {
+    const bool copiada = copiar_imagen(cache, encontrada, n_filas,
+      n_columnas, paso, matriz, matriz2);
+    soltar_imagen(cache, encontrada);
+    return copiada;
+  }
+
+  // No está, se carga y se ofrece a la caché
+  if (!cargar_matriz(ruta, n_filas, n_columnas, paso, matriz, cache->arena,
+      equipo, hilos)) {
+    return false;
+  }
+  imagen_t* imagen = NULL;
+  if (*n_filas * *paso * sizeof(double) <= cache->presupuesto
+      && strlen(ruta) < BUFFER_MAX) {
+    imagen = (imagen_t*) calloc(1, sizeof(imagen_t));
+  }
+  if (imagen == NULL) {
+    // No cabe, la matriz cargada es la de trabajo
+    *matriz2 = tomar_matriz_bordes(cache->arena, *matriz, *n_filas,
+      *n_columnas, *paso);
+    if (*matriz2 == NULL) {
+      fprintf(stderr, "Error al crear las matrices de %s\n", ruta);
+      devolver_matriz(cache->arena, *matriz);
+      return false;
+    }
+    return true;
+  }
+  strcpy(imagen->ruta, ruta);
+  imagen->tamano = (size_t) estado.st_size;
+  imagen->modificacion = estado.st_mtim;
+  imagen->n_filas = *n_filas;
+  imagen->n_columnas = *n_columnas;
+  imagen->paso = *paso;
+  imagen->matriz = *matriz;
+  imagen->referencias = 1;
+  imagen->vigente = true;
+  pthread_mutex_lock(&cache->mutex);
+  imagen->siguiente = cache->imagenes;
+  cache->imagenes = imagen;
+  cache->bytes += bytes_imagen(imagen);
+  pthread_mutex_unlock(&cache->mutex);
+
+  const bool copiada = copiar_imagen(cache, imagen, n_filas, n_columnas,
+    paso, matriz, matriz2);
+  soltar_imagen(cache, imagen);
+  return copiada;
+}
+
+void destruir_cache(cache_t* cache) {
+  while (cache->imagenes) {
+    imagen_t* imagen = cache->imagenes;
+    cache->imagenes = imagen->siguiente;
+    devolver_matriz(cache->arena, imagen->matriz);
+    free(imagen);
+  }
+  cache->bytes = 0;
+  pthread_mutex_destroy(&cache->mutex);
+}
@@ -0,0 +1,136 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef CACHE_H
+#define CACHE_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "arena.h"
+#include "equipo.h"
+#include "formato.h"
+#include "miscelaneos.h"
+/**
+ * @brief Megabytes de láminas iniciales que se conservan si el usuario no
+ * indica otro presupuesto
+ */
+#define CACHE_MB_OMISION 1024
+/**
+ * @brief Estado inicial de una lámina tal como quedó al cargarse, con el
+ * mismo paso que las matrices de trabajo
+ */
+typedef struct imagen {
+  /**
+   * @brief Ruta del archivo de la lámina
+   */
+  char ruta[BUFFER_MAX];
+  /**
+   * @brief Tamaño del archivo al cargarlo
+   */
+  size_t tamano;
+  /**
+   * @brief Última modificación del archivo al cargarlo
+   */
+  struct timespec modificacion;
+  /**
+   * @brief Número de filas de la matriz
+   */
+  size_t n_filas;
+  /**
+   * @brief Número de columnas de la matriz
+   */
+  size_t n_columnas;
+  /**
+   * @brief Paso de las filas de la matriz
+   */
+  size_t paso;
+  /**
+   * @brief Matriz con el estado inicial, solo de lectura
+   */
+  double* matriz;
+  /**
+   * @brief Láminas que están copiando la imagen en este momento. Solo se
+   * descarta cuando llega a 0
+   */
+  size_t referencias;
+  /**
+   * @brief Falso si el archivo cambió después de cargarla
+   */
+  bool vigente;
+  /**
+   * @brief Imagen usada antes que esta, la lista va de la más reciente a la
+   * menos reciente
+   */
+  struct imagen* siguiente;
+} imagen_t;
+/**
+ * @brief Caché de láminas iniciales, compartida por todos los hilos.
+ *
+ * Un archivo de trabajo suele nombrar la misma lámina en muchas líneas con
+ * distintos parámetros. La caché la carga una vez y cada línea inicia su
+ * copia de trabajo desde la imagen con un memcpy. Se identifica por ruta,
+ * tamaño y fecha de modificación, y cuando los bytes superan el presupuesto
+ * se descartan las imágenes menos usadas recientemente.
+ */
+typedef struct {
+  /**
+   * @brief Protege la lista y los contadores
+   */
+  pthread_mutex_t mutex;
+  /**
+   * @brief Imágenes de la más a la menos usada recientemente
+   */
+  imagen_t* imagenes;
+  /**
+   * @brief Bytes ocupados por las matrices de las imágenes
+   */
+  size_t bytes;
+  /**
+   * @brief Bytes que pueden ocupar las imágenes, 0 desactiva la caché
+   */
+  size_t presupuesto;
+  /**
+   * @brief Arena de donde salen las imágenes y las matrices de trabajo
+   */
+  arena_t* arena;
+} cache_t;
+/**
+ * @brief Inicializa una caché vacía.
+ *
+ * @param cache Caché a inicializar.
+ * @param presupuesto Bytes que pueden ocupar las imágenes.
+ * @param arena Arena de las matrices, o NULL para reservarlas aparte.
+ */
+void crear_cache(cache_t* cache, size_t presupuesto, arena_t* arena);
+/**
+ * @brief Crea las dos matrices de trabajo de una lámina.
+ *
+ * Las matrices salen de la arena de la caché y se devuelven con
+ * devolver_matriz().
+ *
+ * Si la lámina está en la caché y el archivo no cambió, matriz es una copia
+ * de la imagen. Si no, se carga con cargar_matriz() y se agrega a la caché
+ * cuando cabe en el presupuesto. matriz2 solo recibe los bordes, como en
+ * mapear_matrices().
+ *
+ * @param cache Caché creada con crear_cache().
+ * @param ruta Ruta del archivo de la lámina.
+ * @param n_filas Número de filas de la lámina.
+ * @param n_columnas Número de columnas de la lámina.
+ * @param paso Paso de las filas de las matrices creadas.
+ * @param matriz Matriz con el estado inicial.
+ * @param matriz2 Matriz para el estado siguiente, con los mismos bordes.
+ * @param equipo Equipo estacionado que carga el archivo, NULL para cargarlo
+ * en el hilo que invoca.
+ * @param hilos Hilos del equipo que participan en la carga.
+ * @return true si se cargó la lámina, false en caso de error.
+ */
+bool cargar_de_cache(cache_t* cache, const char* ruta, size_t* n_filas,
+  size_t* n_columnas, size_t* paso, double** matriz, double** matriz2,
+  equipo_t* equipo, size_t hilos);
+/**
+ * @brief Libera todas las imágenes de la caché.
+ *
+ * @param cache Caché creada con crear_cache().
+ */
+void destruir_cache(cache_t* cache);
+#endif
@@ -0,0 +1,339 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <sys/uio.h>
+#include "compresion.h"
+
+/**
+ * @brief Codificador por corridas de un bloque
+ */
+typedef struct {
+  uint8_t* salida;
+  size_t bytes;
+  /**
+   * @brief Posición del byte de control de la corrida literal abierta
+   */
+  size_t control;
+  /**
+   * @brief Bytes de la corrida literal abierta, 0 si no hay una
+   */
+  size_t literales;
+  /**
+   * @brief Ceros que aún no se escriben
+   */
+  size_t ceros;
+} codificador_t;
+
+/**
+ * @brief Lector de los bytes de un bloque codificado por corridas
+ */
+typedef struct {
+  const uint8_t* datos;
+  size_t bytes;
+  size_t posicion;
+  /**
+   * @brief Ceros que faltan de la corrida actual
+   */
+  size_t ceros;
+  /**
+   * @brief Bytes literales que faltan de la corrida actual
+   */
+  size_t literales;
+} lector_bloque_t;
+
+// Escribe el byte de control de la corrida literal abierta
+static void cerrar_literales(codificador_t* codificador) {
+  if (codificador->literales > 0) {
+    codificador->salida[codificador->control] =
+        (uint8_t) (codificador->literales - 1);
+    codificador->literales = 0;
+  }
+}
+
+// Agrega un byte a la corrida literal, abre una si no hay
+static void agregar_literal(codificador_t* codificador, uint8_t byte) {
+  if (codificador->literales == 0) {
+    codificador->control = codificador->bytes++;
+  }
+  codificador->salida[codificador->bytes++] = byte;
+  if (++codificador->literales == 128) {
+    cerrar_literales(codificador);
+  }
+}
+
+// Escribe los ceros pendientes. Un cero suelto cuesta lo mismo como
+// literal y no corta la corrida literal
+static void vaciar_ceros(codificador_t* codificador) {
+  if (codificador->ceros == 1) {
+    agregar_literal(codificador, 0);
+  } else if (codificador->ceros > 1) {
+    cerrar_literales(codificador);
+    while (codificador->ceros > 0) {
+      const size_t corrida = codificador->ceros < 128 ? codificador->ceros
+          : 128;
+      codificador->salida[codificador->bytes++] = (uint8_t) (127 + corrida);
+      codificador->ceros -= corrida;
+    }
+  }
+  codificador->ceros = 0;
+}
+
+// Codifica un byte
+static void codificar_byte(codificador_t* codificador, uint8_t byte) {
+  if (byte == 0) {
+    ++codificador->ceros;
+  } else {
+    vaciar_ceros(codificador);
+    agregar_literal(codificador, byte);
+  }
+}
+
+// Decodifica los siguientes cantidad bytes del bloque. Si el bloque se
+// acaba antes completa con ceros, lo que no ocurre en un bloque validado
+static void leer_bytes(lector_bloque_t* lector, uint8_t* destino,
+    size_t cantidad) {
+  size_t copiados = 0;
+  while (copiados < cantidad) {
+    if (lector->ceros > 0) {
+      const size_t n = lector->ceros < cantidad - copiados ? lector->ceros
+          : cantidad - copiados;
+      memset(destino + copiados, 0, n);
+      lector->ceros -= n;
+      copiados += n;
+    } else if (lector->literales > 0
+        && lector->posicion < lector->bytes) {
+      size_t n = lector->literales < cantidad - copiados ? lector->literales
+          : cantidad - copiados;
+      n = n < lector->bytes - lector->posicion ? n
+          : lector->bytes - lector->posicion;
+      memcpy(destino + copiados, lector->datos + lector->posicion, n);
+      lector->posicion += n;
+      lector->literales -= n;
+      copiados += n;
+    } else if (lector->literales == 0 && lector->posicion < lector->bytes) {
+      const uint8_t control = lector->datos[lector->posicion++];
+      if (control < 128) {
+        lector->literales = (size_t) control + 1;
+      } else {
+        lector->ceros = (size_t) control - 127;
+      }
+    } else {
+      memset(destino + copiados, 0, cantidad - copiados);
+      copiados = cantidad;
+    }
+  }
+}
+
+// Indica si el bloque decodifica exactamente esperados bytes
+static bool validar_bloque(const uint8_t* datos, size_t bytes,
+    size_t esperados) {
+  size_t posicion = 0;
+  size_t decodificados = 0;
+  while (posicion < bytes && decodificados <= esperados) {
+    const uint8_t control = datos[posicion++];
+    if (control < 128) {
+      const size_t literales = (size_t) control + 1;
+      if (literales > bytes - posicion) {
+        return false;
+      }
+      posicion += literales;
+      decodificados += literales;
+    } else {
+      decodificados += (size_t) control - 127;
+    }
+  }
+  return posicion == bytes && decodificados == esperados;
+}
+
+size_t filas_bloque_comprimido(size_t n_columnas) {
+  return n_columnas < CELDAS_BLOQUE_COMPRIMIDO
+      ? CELDAS_BLOQUE_COMPRIMIDO / n_columnas : 1;
+}
+
+size_t cota_bloque_comprimido(size_t celdas) {
+  // A lo sumo un byte de control por cada 128 literales, más los de las
+  // corridas de ceros que separan literales, que ocupan al menos 2 bytes
+  return celdas * sizeof(double) + celdas / 8 + 16;
+}
+
+size_t comprimir_bloque(const double* matriz, size_t paso, size_t filas,
+    size_t n_columnas, uint8_t* destino) {
+  codificador_t codificador = {destino, 0, 0, 0, 0};
+  uint8_t planos[sizeof(double) * CELDAS_GRUPO];
+  uint64_t primera_anterior = 0;
+  for (size_t i = 0; i < filas; ++i) {
+    const double* fila = matriz + i * paso;
+    uint64_t anterior = primera_anterior;
+    for (size_t j = 0; j < n_columnas; j += CELDAS_GRUPO) {
+      const size_t grupo = n_columnas - j < CELDAS_GRUPO ? n_columnas - j
+          : CELDAS_GRUPO;
+      for (size_t k = 0; k < grupo; ++k) {
+        uint64_t bits = 0;
+        memcpy(&bits, fila + j + k, sizeof(double));
+        const uint64_t diferencia = bits - anterior;
+        anterior = bits;
+        if (j + k == 0) {
+          primera_anterior = bits;
+        }
+        // Zigzag: las diferencias negativas pequeñas también quedan con los
+        // bytes altos en cero
+        const uint64_t zigzag = (diferencia << 1) ^ (0 - (diferencia >> 63));
+        for (size_t b = 0; b < sizeof(double); ++b) {
+          planos[b * grupo + k] = (uint8_t) (zigzag >> (8 * b));
+        }
+      }
+      for (size_t m = 0; m < sizeof(double) * grupo; ++m) {
+        codificar_byte(&codificador, planos[m]);
+      }
+    }
+  }
+  vaciar_ceros(&codificador);
+  cerrar_literales(&codificador);
+  return codificador.bytes;
+}
+
+bool abrir_comprimida(const char* ruta, const char* datos, size_t bytes,
+    mapeo_lamina_t* mapeo) {
+  encabezado_comprimido_t encabezado;
+  if (bytes < sizeof(encabezado)) {
+    fprintf(stderr, "Error: la lámina comprimida %s está incompleta\n", ruta);
+    return false;
+  }
+  memcpy(&encabezado, datos, sizeof(encabezado));
+  const size_t filas = (size_t) encabezado.n_filas;
+  const size_t columnas = (size_t) encabezado.n_columnas;
+  const size_t filas_bloque = (size_t) encabezado.filas_bloque;
+  const size_t disponibles = bytes - sizeof(encabezado);
+  if (filas == 0 || columnas == 0 || filas_bloque == 0
+      || filas > SIZE_MAX / sizeof(double) / columnas
+      || (filas + filas_bloque - 1) / filas_bloque
+      > disponibles / sizeof(uint64_t)) {
+    fprintf(stderr, "Error: la lámina comprimida %s tiene un encabezado "
+        "inválido\n", ruta);
+    return false;
+  }
+  // El índice sigue al encabezado, que mide un múltiplo de 8 bytes
+  const size_t bloques = (filas + filas_bloque - 1) / filas_bloque;
+  const uint64_t* fin_bloques = (const uint64_t*) (datos
+      + sizeof(encabezado));
+  const uint8_t* inicio = (const uint8_t*) (datos + sizeof(encabezado)
+      + bloques * sizeof(uint64_t));
+  const size_t total = disponibles - bloques * sizeof(uint64_t);
+  size_t anterior = 0;
+  for (size_t bloque = 0; bloque < bloques; ++bloque) {
+    const size_t primera = bloque * filas_bloque;
+    const size_t filas_actual = filas - primera < filas_bloque
+        ? filas - primera : filas_bloque;
+    if (fin_bloques[bloque] < anterior || fin_bloques[bloque] > total
+        || !validar_bloque(inicio + anterior,
+          (size_t) fin_bloques[bloque] - anterior,
+          filas_actual * columnas * sizeof(double))) {
+      fprintf(stderr, "Error: el bloque %zu de la lámina comprimida %s está "
+          "dañado\n", bloque, ruta);
+      return false;
+    }
+    anterior = (size_t) fin_bloques[bloque];
+  }
+  if (anterior != total) {
+    fprintf(stderr, "Error: la lámina comprimida %s tiene bytes de más\n",
+        ruta);
+    return false;
+  }
+  mapeo->datos = datos;
+  mapeo->bytes = bytes;
+  mapeo->celdas = NULL;
+  mapeo->n_filas = filas;
+  mapeo->n_columnas = columnas;
+  mapeo->filas_bloque = filas_bloque;
+  mapeo->fin_bloques = fin_bloques;
+  mapeo->bloques = inicio;
+  return true;
+}
+
+// Decodifica las filas del bloque que caen en [fila_inicio, fila_fin). Las
+// anteriores se decodifican sin guardarlas, sus diferencias son necesarias
+static void decodificar_bloque(const mapeo_lamina_t* mapeo, size_t bloque,
+    double* matriz, size_t paso, size_t fila_inicio, size_t fila_fin) {
+  const size_t n_columnas = mapeo->n_columnas;
+  const size_t desde = bloque > 0 ? (size_t) mapeo->fin_bloques[bloque - 1]
+      : 0;
+  lector_bloque_t lector = {mapeo->bloques + desde,
+    (size_t) mapeo->fin_bloques[bloque] - desde, 0, 0, 0};
+  const size_t primera = bloque * mapeo->filas_bloque;
+  const size_t ultima = primera + mapeo->filas_bloque < fila_fin
+      ? primera + mapeo->filas_bloque : fila_fin;
+  uint8_t planos[sizeof(double) * CELDAS_GRUPO];
+  uint64_t primera_anterior = 0;
+  for (size_t i = primera; i < ultima; ++i) {
+    double* fila = i >= fila_inicio ? matriz + i * paso : NULL;
+    uint64_t anterior = primera_anterior;
+    for (size_t j = 0; j < n_columnas; j += CELDAS_GRUPO) {
+      const size_t grupo = n_columnas - j < CELDAS_GRUPO ? n_columnas - j
+          : CELDAS_GRUPO;
+      leer_bytes(&lector, planos, sizeof(double) * grupo);
+      for (size_t k = 0; k < grupo; ++k) {
+        uint64_t zigzag = 0;
+        for (size_t b = 0; b < sizeof(double); ++b) {
+          zigzag |= (uint64_t) planos[b * grupo + k] << (8 * b);
+        }
+        anterior += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        if (j + k == 0) {
+          primera_anterior = anterior;
+        }
+        if (fila) {
+          memcpy(fila + j + k, &anterior, sizeof(double));
+        }
+      }
+    }
+    if (fila) {
+      memset(fila + n_columnas, 0, (paso - n_columnas) * sizeof(double));
+    }
+  }
+}
+
+void copiar_filas_comprimidas(const mapeo_lamina_t* mapeo, double* matriz,
+    size_t paso, size_t fila_inicio, size_t fila_fin) {
+  if (fila_inicio >= fila_fin) {
+    return;
+  }
+  const size_t primer_bloque = fila_inicio / mapeo->filas_bloque;
+  const size_t ultimo_bloque = (fila_fin - 1) / mapeo->filas_bloque;
+  for (size_t bloque = primer_bloque; bloque <= ultimo_bloque; ++bloque) {
+    decodificar_bloque(mapeo, bloque, matriz, paso, fila_inicio, fila_fin);
+  }
+}
+
+bool escribir_comprimida(const char* ruta, size_t n_filas,
+    size_t n_columnas, uint8_t* const* bloques, const size_t* bytes) {
+  const size_t filas_bloque = filas_bloque_comprimido(n_columnas);
+  const size_t cantidad = (n_filas + filas_bloque - 1) / filas_bloque;
+  // Un segmento para el encabezado, uno para el índice y uno por bloque
+  uint64_t* fin_bloques = (uint64_t*) malloc(cantidad * sizeof(uint64_t));
+  struct iovec* iov = (struct iovec*) malloc((cantidad + 2)
+      * sizeof(struct iovec));
+  if (fin_bloques == NULL || iov == NULL) {
+    fprintf(stderr, "Error al crear los segmentos de %s\n", ruta);
+    free(fin_bloques);
+    free(iov);
+    return false;
+  }
+  encabezado_comprimido_t encabezado;
+  memcpy(encabezado.magia, MAGIA_COMPRIMIDA, sizeof(encabezado.magia));
+  encabezado.n_filas = n_filas;
+  encabezado.n_columnas = n_columnas;
+  encabezado.filas_bloque = filas_bloque;
+  iov[0].iov_base = &encabezado;
+  iov[0].iov_len = sizeof(encabezado);
+  iov[1].iov_base = fin_bloques;
+  iov[1].iov_len = cantidad * sizeof(uint64_t);
+  size_t total = 0;
+  for (size_t bloque = 0; bloque < cantidad; ++bloque) {
+    total += bytes[bloque];
+    fin_bloques[bloque] = total;
+    iov[bloque + 2].iov_base = bloques[bloque];
+    iov[bloque + 2].iov_len = bytes[bloque];
+  }
+  const bool correcto = escribir_archivo(ruta, iov, cantidad + 2,
+    sizeof(encabezado) + cantidad * sizeof(uint64_t) + total);
+  free(fin_bloques);
+  free(iov);
+  return correcto;
+}
@@ -0,0 +1,107 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef COMPRESION_H
+#define COMPRESION_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "miscelaneos.h"
+/**
+ * @brief Firma al inicio de una lámina comprimida. Un archivo crudo empieza
+ * con el número de filas, que nunca tiene estos bytes en una lámina real
+ */
+#define MAGIA_COMPRIMIDA "LAMINAZ1"
+/**
+ * @brief Celdas aproximadas de cada bloque de filas comprimido
+ */
+#define CELDAS_BLOQUE_COMPRIMIDO (128 * 1024)
+/**
+ * @brief Celdas de cada grupo cuyos bytes se reordenan por planos
+ */
+#define CELDAS_GRUPO 64
+/**
+ * @brief Encabezado de una lámina comprimida.
+ *
+ * Le siguen el fin de cada bloque (uint64_t, en bytes desde el inicio del
+ * primer bloque) y los bloques. Cada bloque codifica filas_bloque filas, o
+ * las que queden en el último, y se decodifica sin los demás.
+ *
+ * Cada celda se guarda como la diferencia entre sus bits y los de la celda a
+ * su izquierda, o los de la primera celda de la fila anterior del bloque si
+ * es la primera de la fila, en zigzag para que las diferencias pequeñas
+ * tengan los bytes altos en cero. Cada fila se parte en grupos de
+ * CELDAS_GRUPO celdas y los 8 bytes de las diferencias del grupo se guardan
+ * por planos, primero el byte 0 de todas, luego el byte 1... Los bytes
+ * resultantes se codifican por corridas: un byte de control c < 128 va
+ * seguido de c + 1 bytes literales, y c >= 128 indica c - 127 ceros.
+ */
+typedef struct {
+  char magia[8];
+  uint64_t n_filas;
+  uint64_t n_columnas;
+  uint64_t filas_bloque;
+} encabezado_comprimido_t;
+/**
+ * @brief Filas de cada bloque para láminas de n_columnas columnas.
+ *
+ * @param n_columnas Columnas de la lámina.
+ * @return Filas por bloque, al menos 1.
+ */
+size_t filas_bloque_comprimido(size_t n_columnas);
+/**
+ * @brief Bytes que puede ocupar un bloque comprimido en el peor caso.
+ *
+ * @param celdas Celdas del bloque.
+ * @return Cota de bytes.
+ */
+size_t cota_bloque_comprimido(size_t celdas);
+/**
+ * @brief Comprime un bloque de filas.
+ *
+ * @param matriz Primera fila del bloque.
+ * @param paso Paso de las filas de la matriz.
+ * @param filas Filas del bloque.
+ * @param n_columnas Columnas de la lámina.
+ * @param destino Memoria de al menos cota_bloque_comprimido() bytes.
+ * @return Bytes escritos en destino.
+ */
+size_t comprimir_bloque(const double* matriz, size_t paso, size_t filas,
+  size_t n_columnas, uint8_t* destino);
+/**
+ * @brief Valida una lámina comprimida ya mapeada y llena su mapeo.
+ *
+ * Revisa el encabezado, el índice y que cada bloque decodifique
+ * exactamente sus celdas, así copiar_filas() ya no puede fallar.
+ *
+ * @param ruta Ruta del archivo, para los mensajes de error.
+ * @param datos Inicio del mapeo.
+ * @param bytes Bytes mapeados.
+ * @param mapeo Mapeo a llenar, celdas queda en NULL.
+ * @return true si la lámina es válida.
+ */
+bool abrir_comprimida(const char* ruta, const char* datos, size_t bytes,
+  mapeo_lamina_t* mapeo);
+/**
+ * @brief Decodifica las filas [fila_inicio, fila_fin) de una lámina
+ * comprimida, con el relleno en cero.
+ *
+ * Solo decodifica los bloques que tocan el rango; un rango que empieza a
+ * la mitad de un bloque decodifica sin guardar las filas previas del bloque.
+ *
+ * @see copiar_filas
+ */
+void copiar_filas_comprimidas(const mapeo_lamina_t* mapeo, double* matriz,
+  size_t paso, size_t fila_inicio, size_t fila_fin);
+/**
+ * @brief Escribe una lámina comprimida a partir de sus bloques.
+ *
+ * @param ruta Ruta del archivo a crear o sobrescribir.
+ * @param n_filas Número de filas de la lámina.
+ * @param n_columnas Número de columnas de la lámina.
+ * @param bloques Bloques de filas_bloque_comprimido() filas, comprimidos
+ * con comprimir_bloque().
+ * @param bytes Bytes de cada bloque.
+ * @return true si se escribió completa, false en caso de error.
+ */
+bool escribir_comprimida(const char* ruta, size_t n_filas,
+  size_t n_columnas, uint8_t* const* bloques, const size_t* bytes);
+#endif
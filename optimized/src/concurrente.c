@@ -0,0 +1,250 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <stdint.h>
+#include "concurrente.h"
+
+// Reporta en orden las láminas pendientes que ya tienen su turno. Se llama
+// con mutex_reporte tomado
+static void reportar_pendientes(planificador_t* planificador) {
+  while (planificador->pendientes && planificador->error == 0
+      && planificador->pendientes->indice == planificador->proximo_reporte
+      && planificador->proximo_reporte < planificador->fin) {
+    pendiente_t* pendiente = planificador->pendientes;
+    planificador->pendientes = pendiente->siguiente;
+    --planificador->cantidad_pendientes;
+    ++planificador->proximo_reporte;
+    planificador->error = reportar_lamina(
+      planificador->archivos->archivo_salida,
+      planificador->archivos->prefijo_ruta_trabajo, &pendiente->lamina,
+      planificador->opciones->comprimir != 0);
+    devolver_matriz(planificador->cache->arena, pendiente->lamina.matriz);
+    devolver_matriz(planificador->cache->arena, pendiente->lamina.matriz2);
+    free(pendiente);
+  }
+  pthread_cond_broadcast(&planificador->reportado);
+}
+
+// Marca que las líneas desde indice no se reportan
+static void terminar_en(planificador_t* planificador, size_t indice) {
+  pthread_mutex_lock(&planificador->mutex_reporte);
+  if (indice < planificador->fin) {
+    planificador->fin = indice;
+  }
+  reportar_pendientes(planificador);
+  pthread_mutex_unlock(&planificador->mutex_reporte);
+}
+
+// Entrega una lámina simulada para reportarla cuando le toque
+static void entregar_lamina(planificador_t* planificador, size_t indice,
+    lamina_t* lamina, int error) {
+  pendiente_t* pendiente = NULL;
+  if (error == 0) {
+    pendiente = (pendiente_t*) malloc(sizeof(pendiente_t));
+    if (pendiente == NULL) {
+      fprintf(stderr, "Error: no hay memoria para el reporte de %s\n",
+        lamina->nombre);
+      error = EXIT_FAILURE;
+    }
+  }
+  if (pendiente == NULL) {
+    devolver_matriz(planificador->cache->arena, lamina->matriz);
+    devolver_matriz(planificador->cache->arena, lamina->matriz2);
+  }
+  pthread_mutex_lock(&planificador->mutex_reporte);
+  if (pendiente) {
+    // Insertar en orden de índice
+    pendiente->indice = indice;
+    pendiente->lamina = *lamina;
+    pendiente_t** anterior = &planificador->pendientes;
+    while (*anterior && (*anterior)->indice < indice) {
+      anterior = &(*anterior)->siguiente;
+    }
+    pendiente->siguiente = *anterior;
+    *anterior = pendiente;
+    ++planificador->cantidad_pendientes;
+  } else if (planificador->error == 0) {
+    planificador->error = error;
+  }
+  reportar_pendientes(planificador);
+  pthread_mutex_unlock(&planificador->mutex_reporte);
+}
+
+// Toma los hilos que usará la lámina: el del carril y uno más por cada
+// CELDAS_POR_HILO celdas, mientras haya libres
+static size_t tomar_hilos(planificador_t* planificador,
+    const lamina_t* lamina) {
+  // El interior se puede dividir en bloques de filas y de columnas, así
+  // que el límite son las celdas internas y no las filas
+  const size_t celdas_internas = lamina->n_filas > 2 && lamina->n_columnas > 2
+      ? (lamina->n_filas - 2) * (lamina->n_columnas - 2) : 0;
+  size_t deseados = lamina->n_filas * lamina->n_columnas / CELDAS_POR_HILO;
+  deseados = deseados < celdas_internas ? deseados : celdas_internas;
+  size_t extra = deseados > 1 ? deseados - 1 : 0;
+  pthread_mutex_lock(&planificador->mutex_hilos);
+  extra = extra < planificador->hilos_libres
+      ? extra : planificador->hilos_libres;
+  planificador->hilos_libres -= extra;
+  pthread_mutex_unlock(&planificador->mutex_hilos);
+  return 1 + extra;
+}
+
+// Devuelve los hilos que tomó una lámina, salvo el del carril
+static void devolver_hilos(planificador_t* planificador, size_t hilos) {
+  pthread_mutex_lock(&planificador->mutex_hilos);
+  planificador->hilos_libres += hilos - 1;
+  pthread_mutex_unlock(&planificador->mutex_hilos);
+}
+
+// Entrega una copia de la lámina al alcanzar el epsilon de una línea
+static int entregar_linea(void* contexto, size_t linea,
+    const lamina_t* lamina) {
+  carril_t* carril = (carril_t*) contexto;
+  lamina_t copia = *lamina;
+  copia.matriz2 = NULL;
+  copia.matriz = tomar_matriz(carril->planificador->cache->arena,
+    lamina->n_filas, lamina->paso);
+  int error = EXIT_SUCCESS;
+  if (copia.matriz == NULL) {
+    fprintf(stderr, "Error: no hay memoria para el reporte de %s\n",
+      lamina->nombre);
+    error = EXIT_FAILURE;
+  } else {
+    memcpy(copia.matriz, lamina->matriz,
+      lamina->n_filas * lamina->paso * sizeof(double));
+  }
+  entregar_lamina(carril->planificador, carril->primera_linea + linea, &copia,
+    error);
+  return error;
+}
+
+// Rutina de cada carril: lee, simula y entrega grupos hasta que no haya más
+static void* atender_carril(void* datos) {
+  carril_t* carril = (carril_t*) datos;
+  planificador_t* planificador = carril->planificador;
+  lamina_t* lamina = &carril->lamina;
+  while (true) {
+    // No adelantarse más de un carril por lámina al reporte, así la memoria
+    // de las láminas terminadas queda acotada
+    pthread_mutex_lock(&planificador->mutex_reporte);
+    while (planificador->cantidad_pendientes >= planificador->carriles
+        && planificador->error == 0 && planificador->fin == SIZE_MAX) {
+      pthread_cond_wait(&planificador->reportado,
+        &planificador->mutex_reporte);
+    }
+    const bool detener = planificador->error != 0
+        || planificador->fin != SIZE_MAX;
+    pthread_mutex_unlock(&planificador->mutex_reporte);
+    if (detener) {
+      break;
+    }
+    // Tomar el siguiente grupo de líneas del archivo de trabajo
+    char ruta_lamina[BUFFER_MAX];
+    pthread_mutex_lock(&planificador->mutex_lectura);
+    carril->primera_linea = planificador->siguiente_indice;
+    bool hay_lamina = leer_grupo(&planificador->lector, &carril->grupo,
+      ruta_lamina, carril->mem_comp.opciones->agrupar_epsilon != 0);
+    planificador->siguiente_indice += carril->grupo.cantidad;
+    pthread_mutex_unlock(&planificador->mutex_lectura);
+    // La lámina se carga fuera del mutex para no detener a los demás
+    if (hay_lamina) {
+      *lamina = carril->grupo.lineas[0];
+      // El carril aún no toma hilos libres, carga solo con el suyo
+      hay_lamina = cargar_de_cache(planificador->cache, ruta_lamina,
+        &lamina->n_filas, &lamina->n_columnas, &lamina->paso, &lamina->matriz,
+        &lamina->matriz2, &carril->mem_comp.equipo, 1);
+    }
+    if (!hay_lamina) {
+      terminar_en(planificador, carril->primera_linea);
+      break;
+    }
+    const size_t hilos = tomar_hilos(planificador, lamina);
+    carril->mem_comp.hilos_lamina = hilos;
+    const int error = procesar_grupo(&carril->grupo, &carril->mem_comp,
+      entregar_linea, carril);
+    devolver_hilos(planificador, hilos);
+    if (error != EXIT_SUCCESS) {
+      // Entregar el error detiene a los demás carriles y libera las matrices
+      entregar_lamina(planificador, carril->primera_linea, lamina, error);
+    } else {
+      devolver_matriz(planificador->cache->arena, lamina->matriz);
+      devolver_matriz(planificador->cache->arena, lamina->matriz2);
+    }
+  }
+  liberar_grupo(&carril->grupo);
+  return NULL;
+}
+
+int simular_concurrente(archivos_t* archivos, const opciones_t* opciones,
+    size_t hilos_usuario, cache_t* cache) {
+  planificador_t planificador;
+  planificador.archivos = archivos;
+  planificador.opciones = opciones;
+  planificador.cache = cache;
+  planificador.carriles = opciones->laminas_concurrentes < hilos_usuario
+      ? opciones->laminas_concurrentes : hilos_usuario;
+  iniciar_lector(&planificador.lector, archivos);
+  planificador.siguiente_indice = 0;
+  planificador.pendientes = NULL;
+  planificador.cantidad_pendientes = 0;
+  planificador.proximo_reporte = 0;
+  planificador.fin = SIZE_MAX;
+  planificador.error = 0;
+  planificador.hilos_libres = hilos_usuario - planificador.carriles;
+  pthread_mutex_init(&planificador.mutex_lectura, NULL);
+  pthread_mutex_init(&planificador.mutex_reporte, NULL);
+  pthread_cond_init(&planificador.reportado, NULL);
+  pthread_mutex_init(&planificador.mutex_hilos, NULL);
+
+  carril_t* carriles = (carril_t*) calloc(planificador.carriles,
+    sizeof(carril_t));
+  if (carriles == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu carriles\n",
+      planificador.carriles);
+    planificador.error = EXIT_FAILURE;
+  }
+  // Cada equipo alcanza para el hilo del carril más todos los libres. Se
+  // calcula antes de crear carriles porque estos ya toman hilos libres
+  const size_t hilos_equipo = planificador.hilos_libres + 1;
+  size_t creados = 0;
+  for (; carriles && creados < planificador.carriles; ++creados) {
+    carril_t* carril = &carriles[creados];
+    carril->planificador = &planificador;
+    carril->mem_comp.lamina = &carril->lamina;
+    carril->mem_comp.opciones = opciones;
+    carril->mem_comp.punto_control = NULL;
+    // Cada carril fija su equipo a las CPUs siguientes a las del anterior
+    if (crear_hilos(&carril->mem_comp, hilos_equipo, creados * hilos_equipo)
+        != EXIT_SUCCESS) {
+      break;
+    }
+    if (pthread_create(&carril->hilo, NULL, atender_carril, carril) != 0) {
+      fprintf(stderr, "Error: could not create secondary thread\n");
+      liberar_hilos(&carril->mem_comp);
+      break;
+    }
+  }
+  if (carriles && creados < planificador.carriles) {
+    // Los carriles que sí se crearon se detienen al ver el error
+    pthread_mutex_lock(&planificador.mutex_reporte);
+    planificador.error = EXIT_FAILURE;
+    pthread_cond_broadcast(&planificador.reportado);
+    pthread_mutex_unlock(&planificador.mutex_reporte);
+  }
+  for (size_t num_carril = 0; num_carril < creados; ++num_carril) {
+    pthread_join(carriles[num_carril].hilo, NULL);
+    liberar_hilos(&carriles[num_carril].mem_comp);
+  }
+  // Láminas posteriores al fin o a un error que no se reportaron
+  while (planificador.pendientes) {
+    pendiente_t* pendiente = planificador.pendientes;
+    planificador.pendientes = pendiente->siguiente;
+    devolver_matriz(cache->arena, pendiente->lamina.matriz);
+    devolver_matriz(cache->arena, pendiente->lamina.matriz2);
+    free(pendiente);
+  }
+  free(carriles);
+  pthread_mutex_destroy(&planificador.mutex_hilos);
+  pthread_cond_destroy(&planificador.reportado);
+  pthread_mutex_destroy(&planificador.mutex_reporte);
+  pthread_mutex_destroy(&planificador.mutex_lectura);
+  return planificador.error;
+}
@@ -0,0 +1,155 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef CONCURRENTE_H
+#define CONCURRENTE_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "grupo.h"
+#include "simul.h"
+/**
+ * @brief Celdas que justifican un hilo más para una lámina. Las láminas más
+ * pequeñas dejan los hilos libres para las grandes
+ */
+#define CELDAS_POR_HILO (64 * 1024)
+/**
+ * @brief Lámina terminada que espera su turno para reportarse
+ */
+typedef struct pendiente {
+  /**
+   * @brief Línea del archivo de trabajo, desde 0
+   */
+  size_t indice;
+  /**
+   * @brief Lámina con el estado de equilibrio
+   */
+  lamina_t lamina;
+  /**
+   * @brief Siguiente lámina pendiente, en orden de indice
+   */
+  struct pendiente* siguiente;
+} pendiente_t;
+/**
+ * @brief Estado compartido por los carriles que simulan láminas a la vez.
+ *
+ * Cada carril toma el siguiente grupo de líneas del archivo de trabajo, lo
+ * simula con su propio equipo y entrega una copia del resultado de cada
+ * línea. Los resultados se reportan en el
+ * orden del archivo de trabajo, aunque terminen en otro orden.
+ */
+typedef struct {
+  /**
+   * @brief Archivos de trabajo y de salida
+   */
+  archivos_t* archivos;
+  /**
+   * @brief Opciones de la línea de comandos
+   */
+  const opciones_t* opciones;
+  /**
+   * @brief Caché de láminas iniciales, compartida por los carriles
+   */
+  cache_t* cache;
+  /**
+   * @brief Cantidad de carriles
+   */
+  size_t carriles;
+  /**
+   * @brief Protege la lectura del archivo de trabajo
+   */
+  pthread_mutex_t mutex_lectura;
+  /**
+   * @brief Lee los grupos de líneas del archivo de trabajo
+   */
+  lector_t lector;
+  /**
+   * @brief Índice de la próxima línea del archivo de trabajo
+   */
+  size_t siguiente_indice;
+  /**
+   * @brief Protege los campos del reporte
+   */
+  pthread_mutex_t mutex_reporte;
+  /**
+   * @brief Avisa a los carriles que se reportó una lámina
+   */
+  pthread_cond_t reportado;
+  /**
+   * @brief Láminas terminadas que aún no se pueden reportar, en orden
+   */
+  pendiente_t* pendientes;
+  /**
+   * @brief Cantidad de láminas en pendientes. Un carril no toma otro grupo
+   * mientras haya carriles o más
+   */
+  size_t cantidad_pendientes;
+  /**
+   * @brief Índice de la próxima lámina a reportar
+   */
+  size_t proximo_reporte;
+  /**
+   * @brief Primera línea que no se reporta, SIZE_MAX mientras no se sepa.
+   * Igual que en la simulación secuencial, se deja de reportar en la primera
+   * lámina que no se pudo cargar
+   */
+  size_t fin;
+  /**
+   * @brief Primer error de un carril, detiene a los demás
+   */
+  int error;
+  /**
+   * @brief Protege hilos_libres
+   */
+  pthread_mutex_t mutex_hilos;
+  /**
+   * @brief Hilos que no son de ningún carril y que puede tomar una lámina
+   * grande, además del suyo
+   */
+  size_t hilos_libres;
+} planificador_t;
+/**
+ * @brief Carril que simula una lámina a la vez con su propio equipo
+ */
+typedef struct {
+  /**
+   * @brief Estado compartido por los carriles
+   */
+  planificador_t* planificador;
+  /**
+   * @brief Lámina que simula el carril
+   */
+  lamina_t lamina;
+  /**
+   * @brief Grupo de líneas que simula el carril
+   */
+  grupo_t grupo;
+  /**
+   * @brief Índice de la primera línea del grupo
+   */
+  size_t primera_linea;
+  /**
+   * @brief Memoria compartida con el equipo del carril
+   */
+  mem_comp_t mem_comp;
+  /**
+   * @brief Hilo que atiende el carril
+   */
+  pthread_t hilo;
+} carril_t;
+/**
+ * @brief Simula varias láminas del archivo de trabajo a la vez.
+ *
+ * Se crean min(laminas_concurrentes, hilos_usuario) carriles. Cada uno
+ * tiene un hilo garantizado y los restantes se reparten al iniciar cada
+ * lámina: una lámina toma un hilo más por cada CELDAS_POR_HILO celdas
+ * mientras haya hilos libres, y los devuelve al terminar. Los reportes se
+ * escriben en el orden del archivo de trabajo.
+ *
+ * @param archivos Archivos de trabajo y de salida ya abiertos.
+ * @param opciones Opciones de la línea de comandos.
+ * @param hilos_usuario Hilos que indicó el usuario.
+ * @param cache Caché de láminas iniciales.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int simular_concurrente(archivos_t* archivos, const opciones_t* opciones,
+  size_t hilos_usuario, cache_t* cache);
+#endif
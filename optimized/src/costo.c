@@ -0,0 +1,139 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#define _POSIX_C_SOURCE 200112L
+#include <float.h>
+#include <time.h>
+#include <unistd.h>
+#include "costo.h"
+#include "estencil.h"
+#include "miscelaneos.h"
+
+// Segundos del reloj monótono
+static double segundos_actuales(void) {
+  struct timespec ahora;
+  clock_gettime(CLOCK_MONOTONIC, &ahora);
+  return (double) ahora.tv_sec + (double) ahora.tv_nsec / 1e9;
+}
+
+// Rutina vacía con que se mide el despacho
+static void* no_calcular(void* datos) {
+  (void) datos;
+  return NULL;
+}
+
+// Segundos que tarda despachar una rutina vacía a hilos hilos del equipo,
+// con una ronda de arranque que no se mide
+static double medir_despacho(equipo_t* equipo, size_t hilos) {
+  char ficticio = 0;
+  despachar_equipo(equipo, no_calcular, &ficticio, 0, hilos);
+  const double inicio = segundos_actuales();
+  for (size_t ronda = 0; ronda < COSTO_RONDAS; ++ronda) {
+    despachar_equipo(equipo, no_calcular, &ficticio, 0, hilos);
+  }
+  return (segundos_actuales() - inicio) / COSTO_RONDAS;
+}
+
+// Segundos por celda del estencil elegido en un bloque de 32 por 256 celdas
+// internas, que cabe en caché como las láminas pequeñas
+static double medir_estencil(void) {
+  const size_t n_filas = 34;
+  const size_t n_columnas = 258;
+  const size_t paso = calcular_paso(n_columnas);
+  double* matriz = reservar_matriz(n_filas, paso);
+  double* matriz2 = reservar_matriz(n_filas, paso);
+  double segundos = 0.0;
+  if (matriz && matriz2) {
+    memset(matriz, 0, n_filas * paso * sizeof(double));
+    memset(matriz2, 0, n_filas * paso * sizeof(double));
+    size_t repeticiones = 0;
+    const double inicio = segundos_actuales();
+    do {
+      calcular_filas(matriz, matriz2, paso, n_columnas, 1, n_filas - 1, 0.1);
+      ++repeticiones;
+      segundos = segundos_actuales() - inicio;
+    } while (segundos < COSTO_SEGUNDOS_ESTENCIL);
+    segundos /= (double) (repeticiones * (n_filas - 2) * (n_columnas - 2));
+  }
+  liberar_matriz(matriz);
+  liberar_matriz(matriz2);
+  return segundos;
+}
+
+// Indica si la variable de entorno vale 1
+static bool entorno_activo(const char* variable) {
+  const char* valor = getenv(variable);
+  return valor && strcmp(valor, "1") == 0;
+}
+
+void medir_costo(costo_t* costo, equipo_t* equipo) {
+  const long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+  costo->procesadores = procesadores > 0 ? (size_t) procesadores : 1;
+  costo->hilos_maximos = equipo->hilos_totales;
+  costo->segundos_celda = medir_estencil();
+  // Un equipo de un hilo nunca se despierta, ejecutar_hilos() calcula en el
+  // hilo que despacha
+  costo->segundos_despacho_minimo = DBL_MAX;
+  costo->segundos_despacho_maximo = DBL_MAX;
+  if (costo->hilos_maximos > 1) {
+    costo->segundos_despacho_minimo = medir_despacho(equipo, 2);
+    costo->segundos_despacho_maximo = costo->hilos_maximos > 2
+        ? medir_despacho(equipo, costo->hilos_maximos)
+        : costo->segundos_despacho_minimo;
+  }
+  if (entorno_activo(ESTADISTICAS_ENTORNO) && costo->hilos_maximos > 1) {
+    fprintf(stderr, "costo\t%.3f ns por celda\t%.3f us despacho de 2 hilos"
+      "\t%.3f us despacho de %zu hilos\t%zu procesadores\n",
+      costo->segundos_celda * 1e9, costo->segundos_despacho_minimo * 1e6,
+      costo->segundos_despacho_maximo * 1e6, costo->hilos_maximos,
+      costo->procesadores);
+  }
+}
+
+// Segundos estimados de una iteración calculada por hilos hilos, en el hilo
+// que despacha si hilos es 0 o 1
+static double estimar_iteracion(const costo_t* costo, size_t celdas,
+    size_t hilos) {
+  const double trabajo = (double) celdas * costo->segundos_celda;
+  if (hilos <= 1) {
+    return trabajo;
+  }
+  if (costo->segundos_despacho_minimo == DBL_MAX
+      || costo->segundos_despacho_maximo == DBL_MAX) {
+    return DBL_MAX;
+  }
+  // Despacho de hilos hilos, interpolado entre las dos medidas
+  double despacho = costo->segundos_despacho_minimo;
+  if (costo->hilos_maximos > 2) {
+    despacho += (costo->segundos_despacho_maximo
+      - costo->segundos_despacho_minimo) * (double) (hilos - 2)
+      / (double) (costo->hilos_maximos - 2);
+  }
+  const size_t paralelos = hilos < costo->procesadores ? hilos
+      : costo->procesadores;
+  return trabajo / (double) paralelos + despacho;
+}
+
+size_t elegir_hilos(const costo_t* costo, size_t celdas, size_t hilos) {
+  double mejor = estimar_iteracion(costo, celdas, 1);
+  size_t elegidos = 1;
+  for (size_t equipo = 2; equipo <= hilos; ++equipo) {
+    const double estimado = estimar_iteracion(costo, celdas, equipo);
+    if (estimado < mejor) {
+      mejor = estimado;
+      elegidos = equipo;
+    }
+  }
+  return elegidos;
+}
+
+void registrar_hilos(const costo_t* costo, const char* nombre, size_t celdas,
+    const char* estrategia, size_t hilos) {
+  if (entorno_activo(ESTADISTICAS_ENTORNO)) {
+    char equipo[BUFFER_MAX] = "sin equipo";
+    if (hilos > 1) {
+      snprintf(equipo, sizeof(equipo), "%zu hilos", hilos);
+    }
+    fprintf(stderr, "%s\t%zu celdas\t%s\t%s\t%.3f us por iteración\n",
+      nombre, celdas, estrategia, equipo,
+      estimar_iteracion(costo, celdas, hilos) * 1e6);
+  }
+}
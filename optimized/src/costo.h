@@ -0,0 +1,76 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef COSTO_H
+#define COSTO_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "equipo.h"
+/**
+ * @brief Veces que se mide el despacho con cada cantidad de hilos
+ */
+#define COSTO_RONDAS 200
+/**
+ * @brief Segundos mínimos que se mide el estencil
+ */
+#define COSTO_SEGUNDOS_ESTENCIL 0.002
+/**
+ * @brief Costos medidos al crear el equipo con los que se elige cuántos
+ * hilos calculan cada lámina.
+ *
+ * Una iteración con h hilos cuesta celdas * segundos_celda / min(h,
+ * procesadores) más un despacho de h hilos, que se interpola entre las dos
+ * medidas. Con un hilo se calcula en el hilo que despacha y cuesta celdas *
+ * segundos_celda, sin despacho.
+ */
+typedef struct {
+  /**
+   * @brief Segundos que tarda el estencil por celda, con las filas en caché
+   */
+  double segundos_celda;
+  /**
+   * @brief Segundos de despachar una rutina vacía a 2 hilos del equipo
+   */
+  double segundos_despacho_minimo;
+  /**
+   * @brief Segundos de despachar una rutina vacía a todo el equipo
+   */
+  double segundos_despacho_maximo;
+  /**
+   * @brief Hilos del equipo
+   */
+  size_t hilos_maximos;
+  /**
+   * @brief Procesadores en línea, los hilos de más no calculan a la vez
+   */
+  size_t procesadores;
+} costo_t;
+/**
+ * @brief Mide el estencil y el despacho del equipo. Debe llamarse después
+ * de seleccionar_estencil() y de crear el equipo.
+ *
+ * @param costo Costos a medir.
+ * @param equipo Equipo con el que se simularán las láminas.
+ */
+void medir_costo(costo_t* costo, equipo_t* equipo);
+/**
+ * @brief Elige cuántos hilos calculan una lámina según su tamaño.
+ *
+ * @param costo Costos medidos con medir_costo().
+ * @param celdas Celdas internas que se calculan en cada iteración.
+ * @param hilos Máximo de hilos que admite la lámina.
+ * @return Hilos que la calculan, 1 para calcularla en el hilo que despacha
+ * sin despertar al equipo.
+ */
+size_t elegir_hilos(const costo_t* costo, size_t celdas, size_t hilos);
+/**
+ * @brief Si ESTADISTICAS_ENTORNO vale 1, imprime en stderr la estrategia y
+ * los hilos de una lámina y el costo estimado de cada iteración.
+ *
+ * @param costo Costos medidos con medir_costo().
+ * @param nombre Nombre de la lámina.
+ * @param celdas Celdas internas de la lámina.
+ * @param estrategia Nombre de la estrategia de la lámina.
+ * @param hilos Hilos que la calculan.
+ */
+void registrar_hilos(const costo_t* costo, const char* nombre, size_t celdas,
+  const char* estrategia, size_t hilos);
+#endif
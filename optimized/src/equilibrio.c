@@ -0,0 +1,336 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <math.h>
+#include "equilibrio.h"
+
+/**
+ * @brief Un nivel de la multimalla: el sistema A x = b en una malla de
+ * filas x columnas celdas, con el anillo del borde en cero.
+ *
+ * A x en la celda (i, j) es 2 * (peso_filas + peso_columnas) * x(i, j)
+ * menos peso_columnas por sus vecinas de la misma fila y peso_filas por sus
+ * vecinas de la misma columna. En el nivel fino ambos pesos son 1.
+ */
+typedef struct {
+  size_t filas;
+  size_t columnas;
+  size_t paso;
+  double peso_filas;
+  double peso_columnas;
+  /**
+   * @brief Si el nivel siguiente tiene la mitad de filas o de columnas
+   * internas que este
+   */
+  bool reduce_filas;
+  bool reduce_columnas;
+  double* x;
+  double* b;
+  /**
+   * @brief Residuo b - A x, que se restringe al nivel siguiente
+   */
+  double* r;
+} nivel_t;
+
+/**
+ * @brief Celdas del nivel grueso de las que se interpola una celda fina en
+ * una dimensión, con sus pesos
+ */
+typedef struct {
+  size_t celda[2];
+  double peso[2];
+} interpolacion_t;
+
+// En una dimensión que se reduce, la celda gruesa k está en la celda fina
+// 2k y las impares se interpolan entre sus dos vecinas gruesas. Las celdas
+// gruesas 0 y la siguiente a la última son el borde, que vale 0
+static interpolacion_t interpolar(size_t indice, bool reduce) {
+  interpolacion_t interpolacion = {{indice, indice}, {1.0, 0.0}};
+  if (reduce) {
+    if (indice % 2 == 0) {
+      interpolacion.celda[0] = interpolacion.celda[1] = indice / 2;
+    } else {
+      interpolacion.celda[0] = (indice - 1) / 2;
+      interpolacion.celda[1] = (indice + 1) / 2;
+      interpolacion.peso[0] = interpolacion.peso[1] = 0.5;
+    }
+  }
+  return interpolacion;
+}
+
+// y = A x en las celdas internas del nivel
+static void aplicar_operador(const nivel_t* nivel, const double* x,
+    double* y) {
+  const size_t paso = nivel->paso;
+  const double diagonal = 2.0 * (nivel->peso_filas + nivel->peso_columnas);
+  for (size_t i = 1; i < nivel->filas - 1; ++i) {
+    const double* fila = x + i * paso;
+    double* destino = y + i * paso;
+    for (size_t j = 1; j < nivel->columnas - 1; ++j) {
+      destino[j] = diagonal * fila[j]
+          - nivel->peso_columnas * (fila[j - 1] + fila[j + 1])
+          - nivel->peso_filas * (fila[j - paso] + fila[j + paso]);
+    }
+  }
+}
+
+// Un barrido de Gauss-Seidel sobre las celdas internas de un color, las
+// (i, j) con (i + j) % 2 == color
+static void suavizar(const nivel_t* nivel, size_t color) {
+  const size_t paso = nivel->paso;
+  const double inverso = 1.0 / (2.0 * (nivel->peso_filas
+      + nivel->peso_columnas));
+  for (size_t i = 1; i < nivel->filas - 1; ++i) {
+    double* fila = nivel->x + i * paso;
+    const double* b = nivel->b + i * paso;
+    for (size_t j = 1 + ((i + 1 + color) & 1); j < nivel->columnas - 1;
+        j += 2) {
+      fila[j] = (b[j] + nivel->peso_columnas * (fila[j - 1] + fila[j + 1])
+          + nivel->peso_filas * (fila[j - paso] + fila[j + paso])) * inverso;
+    }
+  }
+}
+
+// b del nivel grueso = P^T r del nivel fino, donde P es la interpolación.
+// Lo que cae en el anillo del borde no se usa
+static void restringir(const nivel_t* fino, nivel_t* grueso) {
+  memset(grueso->b, 0, grueso->filas * grueso->paso * sizeof(double));
+  for (size_t i = 1; i < fino->filas - 1; ++i) {
+    const interpolacion_t filas = interpolar(i, fino->reduce_filas);
+    const double* r = fino->r + i * fino->paso;
+    for (size_t j = 1; j < fino->columnas - 1; ++j) {
+      const interpolacion_t columnas = interpolar(j, fino->reduce_columnas);
+      for (size_t a = 0; a < 2; ++a) {
+        double* b = grueso->b + filas.celda[a] * grueso->paso;
+        for (size_t c = 0; c < 2; ++c) {
+          b[columnas.celda[c]] += filas.peso[a] * columnas.peso[c] * r[j];
+        }
+      }
+    }
+  }
+}
+
+// x del nivel fino += P x del nivel grueso
+static void prolongar(const nivel_t* grueso, nivel_t* fino) {
+  for (size_t i = 1; i < fino->filas - 1; ++i) {
+    const interpolacion_t filas = interpolar(i, fino->reduce_filas);
+    double* x = fino->x + i * fino->paso;
+    for (size_t j = 1; j < fino->columnas - 1; ++j) {
+      const interpolacion_t columnas = interpolar(j, fino->reduce_columnas);
+      double suma = 0.0;
+      for (size_t a = 0; a < 2; ++a) {
+        const double* origen = grueso->x + filas.celda[a] * grueso->paso;
+        for (size_t c = 0; c < 2; ++c) {
+          suma += filas.peso[a] * columnas.peso[c]
+              * origen[columnas.celda[c]];
+        }
+      }
+      x[j] += suma;
+    }
+  }
+}
+
+// Aproxima x = A^-1 b desde x = 0 con un ciclo V. Los barridos después de
+// la corrección recorren los colores al revés que los de antes, así el
+// ciclo es simétrico y sirve de precondicionador del gradiente conjugado
+static void ciclo_v(nivel_t* niveles, size_t nivel, size_t cantidad) {
+  nivel_t* actual = &niveles[nivel];
+  memset(actual->x, 0, actual->filas * actual->paso * sizeof(double));
+  const bool grueso = nivel + 1 == cantidad;
+  const size_t barridos = grueso ? BARRIDOS_GRUESO : BARRIDOS_NIVEL;
+  for (size_t k = 0; k < barridos; ++k) {
+    suavizar(actual, 0);
+    suavizar(actual, 1);
+  }
+  if (!grueso) {
+    aplicar_operador(actual, actual->x, actual->r);
+    for (size_t i = 1; i < actual->filas - 1; ++i) {
+      for (size_t j = 1; j < actual->columnas - 1; ++j) {
+        const size_t celda = i * actual->paso + j;
+        actual->r[celda] = actual->b[celda] - actual->r[celda];
+      }
+    }
+    restringir(actual, &niveles[nivel + 1]);
+    ciclo_v(niveles, nivel + 1, cantidad);
+    prolongar(&niveles[nivel + 1], actual);
+  }
+  for (size_t k = 0; k < barridos; ++k) {
+    suavizar(actual, 1);
+    suavizar(actual, 0);
+  }
+}
+
+// Crea los niveles gruesos a partir del fino, que ya tiene sus datos. Cada
+// dimensión con al menos 3 celdas internas se reduce a la mitad. Si solo se
+// reduce una, los pesos se ajustan para aproximar P^T A P. La cantidad de
+// niveles queda en cantidad aunque falte memoria, para liberarlos
+static bool crear_niveles(nivel_t* niveles, size_t* cantidad_niveles) {
+  size_t cantidad = 1;
+  bool hay_memoria = true;
+  while (hay_memoria && cantidad < NIVELES_MAX) {
+    nivel_t* fino = &niveles[cantidad - 1];
+    fino->reduce_filas = fino->filas - 2 >= 3;
+    fino->reduce_columnas = fino->columnas - 2 >= 3;
+    if (!fino->reduce_filas && !fino->reduce_columnas) {
+      break;
+    }
+    nivel_t* grueso = &niveles[cantidad];
+    grueso->filas = fino->reduce_filas ? (fino->filas - 2) / 2 + 2
+        : fino->filas;
+    grueso->columnas = fino->reduce_columnas ? (fino->columnas - 2) / 2 + 2
+        : fino->columnas;
+    grueso->paso = calcular_paso(grueso->columnas);
+    grueso->peso_filas = fino->peso_filas;
+    grueso->peso_columnas = fino->peso_columnas;
+    if (fino->reduce_columnas && !fino->reduce_filas) {
+      grueso->peso_columnas /= 2.0;
+      grueso->peso_filas *= 2.0;
+    } else if (fino->reduce_filas && !fino->reduce_columnas) {
+      grueso->peso_filas /= 2.0;
+      grueso->peso_columnas *= 2.0;
+    }
+    grueso->x = crear_matriz(grueso->filas, grueso->paso);
+    grueso->b = crear_matriz(grueso->filas, grueso->paso);
+    grueso->r = crear_matriz(grueso->filas, grueso->paso);
+    ++cantidad;
+    hay_memoria = grueso->x && grueso->b && grueso->r;
+  }
+  niveles[cantidad - 1].reduce_filas = false;
+  niveles[cantidad - 1].reduce_columnas = false;
+  *cantidad_niveles = cantidad;
+  return hay_memoria;
+}
+
+// Producto punto en las celdas internas
+static double producto(const lamina_t* lamina, const double* x,
+    const double* y) {
+  double suma = 0.0;
+  for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+    for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+      suma += x[i * lamina->paso + j] * y[i * lamina->paso + j];
+    }
+  }
+  return suma;
+}
+
+// Mayor valor absoluto en las celdas internas, dividido entre 4: con r el
+// residuo es la mayor diferencia entre una celda y el promedio de sus vecinas
+static double residuo_maximo(const lamina_t* lamina, const double* r) {
+  double mayor = 0.0;
+  for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+    for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+      const double valor = fabs(r[i * lamina->paso + j]);
+      mayor = valor > mayor ? valor : mayor;
+    }
+  }
+  return mayor / 4.0;
+}
+
+// Calcula r = -A u con los bordes de la lámina y retorna el residuo
+static double residuo_lamina(const nivel_t* fino, const lamina_t* lamina,
+    double* r) {
+  aplicar_operador(fino, lamina->matriz, r);
+  for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+    for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+      r[i * lamina->paso + j] = -r[i * lamina->paso + j];
+    }
+  }
+  return residuo_maximo(lamina, r);
+}
+
+int resolver_equilibrio(lamina_t* lamina) {
+  lamina->residuo = 0.0;
+  if (lamina->n_filas < 3 || lamina->n_columnas < 3) {
+    // No hay celdas internas, la lámina ya está en equilibrio
+    return EXIT_SUCCESS;
+  }
+  // Vectores del gradiente conjugado. q es también el residuo del ciclo V
+  // en el nivel fino, que no se usa mientras se precondiciona
+  double* r = crear_matriz(lamina->n_filas, lamina->paso);
+  double* z = crear_matriz(lamina->n_filas, lamina->paso);
+  double* p = crear_matriz(lamina->n_filas, lamina->paso);
+  double* q = crear_matriz(lamina->n_filas, lamina->paso);
+  nivel_t niveles[NIVELES_MAX] = {{
+    lamina->n_filas, lamina->n_columnas, lamina->paso, 1.0, 1.0, false,
+    false, z, r, q,
+  }};
+  size_t cantidad = 1;
+  int error = EXIT_SUCCESS;
+  if (!crear_niveles(niveles, &cantidad) || r == NULL || z == NULL
+      || p == NULL || q == NULL) {
+    fprintf(stderr, "Error: no hay memoria para el equilibrio de %s\n",
+      lamina->nombre);
+    error = EXIT_FAILURE;
+  }
+  const double epsilon = lamina->epsilon;
+  double residuo = error ? 0.0 : residuo_lamina(&niveles[0], lamina, r);
+  double residuo_confirmado = DBL_MAX;
+  double rz = 0.0;
+  bool reiniciar = true;
+  size_t ciclos = 0;
+  while (error == EXIT_SUCCESS && residuo > epsilon
+      && ciclos < ITERACIONES_EQUILIBRIO_MAX) {
+    if (reiniciar) {
+      // Dirección inicial: el residuo precondicionado
+      ciclo_v(niveles, 0, cantidad);
+      memcpy(p, z, lamina->n_filas * lamina->paso * sizeof(double));
+      rz = producto(lamina, r, z);
+      reiniciar = false;
+    }
+    aplicar_operador(&niveles[0], p, q);
+    const double pq = producto(lamina, p, q);
+    if (!(pq > 0.0)) {
+      break;
+    }
+    const double alfa = rz / pq;
+    for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+      for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+        const size_t celda = i * lamina->paso + j;
+        lamina->matriz[celda] += alfa * p[celda];
+        r[celda] -= alfa * q[celda];
+      }
+    }
+    ++ciclos;
+    residuo = residuo_maximo(lamina, r);
+    if (residuo <= epsilon) {
+      // El residuo acumulado se aleja del real por el redondeo, se confirma
+      // con el real y si no alcanza se reinicia desde este. Si el real ya
+      // no baja, epsilon está por debajo del redondeo
+      residuo = residuo_lamina(&niveles[0], lamina, r);
+      if (residuo > epsilon && residuo > residuo_confirmado / 2.0) {
+        break;
+      }
+      residuo_confirmado = residuo;
+      reiniciar = true;
+    } else {
+      ciclo_v(niveles, 0, cantidad);
+      const double rz_nuevo = producto(lamina, r, z);
+      const double beta = rz_nuevo / rz;
+      rz = rz_nuevo;
+      for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+        for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+          const size_t celda = i * lamina->paso + j;
+          p[celda] = z[celda] + beta * p[celda];
+        }
+      }
+    }
+  }
+  if (error == EXIT_SUCCESS) {
+    // Se reporta el residuo real de la lámina resultante
+    residuo = residuo_lamina(&niveles[0], lamina, r);
+    if (residuo > epsilon) {
+      fprintf(stderr, "Aviso: el equilibrio de %s llegó a un residuo de %lg, "
+        "mayor que epsilon %lg\n", lamina->nombre, residuo, epsilon);
+    }
+    lamina->iteraciones = ciclos;
+    lamina->residuo = residuo;
+  }
+  for (size_t nivel = 1; nivel < cantidad; ++nivel) {
+    liberar_matriz(niveles[nivel].x);
+    liberar_matriz(niveles[nivel].b);
+    liberar_matriz(niveles[nivel].r);
+  }
+  liberar_matriz(r);
+  liberar_matriz(z);
+  liberar_matriz(p);
+  liberar_matriz(q);
+  return error;
+}
@@ -0,0 +1,45 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef EQUILIBRIO_H
+#define EQUILIBRIO_H
+#include <stddef.h>
+#include "simul.h"
+/**
+ * @brief Máximo de iteraciones del gradiente conjugado por línea
+ */
+#define ITERACIONES_EQUILIBRIO_MAX 1000
+/**
+ * @brief Máximo de niveles de la multimalla
+ */
+#define NIVELES_MAX 64
+/**
+ * @brief Barridos de Gauss-Seidel rojo-negro antes y después de la
+ * corrección de cada nivel
+ */
+#define BARRIDOS_NIVEL 2
+/**
+ * @brief Barridos de Gauss-Seidel rojo-negro en el nivel más grueso, que
+ * tiene a lo sumo 2x2 celdas internas
+ */
+#define BARRIDOS_GRUESO 16
+/**
+ * @brief Resuelve directamente el estado de equilibrio de la lámina
+ * (--solver=equilibrium).
+ *
+ * El equilibrio no depende del tiempo, la difusividad ni la distancia: cada
+ * celda interna es el promedio de sus cuatro vecinas, con los bordes del
+ * archivo fijos. Se resuelve ese sistema con gradiente conjugado
+ * precondicionado con un ciclo V de multimalla geométrica, partiendo del
+ * estado de matriz, hasta que el residuo no supere epsilon. Con coeficiente
+ * a lo sumo 0.25, un paso más del método explícito cambiaría cada celda a lo
+ * sumo epsilon.
+ *
+ * Deja el resultado en matriz, las iteraciones del gradiente conjugado en
+ * iteraciones y el residuo alcanzado en residuo. Si epsilon está por debajo
+ * del error de redondeo se detiene cuando el residuo deja de bajar y lo
+ * avisa en la salida de error.
+ *
+ * @param lamina Lámina cargada, matriz2 no se usa.
+ * @return EXIT_SUCCESS o EXIT_FAILURE si no hay memoria.
+ */
+int resolver_equilibrio(lamina_t* lamina);
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <stdio.h>
+#include <stdlib.h>
+#include "equipo.h"
+
+/**
+ * @brief Memoria privada de un hilo del equipo
+ */
+typedef struct {
+  equipo_t* equipo;
+  size_t num_hilo;
+} miembro_t;
+
+// Rutina permanente de cada hilo: espera trabajo, lo ejecuta y avisa
+static void* trabajar(void* datos) {
+  miembro_t* miembro = (miembro_t*) datos;
+  equipo_t* equipo = miembro->equipo;
+  const size_t num_hilo = miembro->num_hilo;
+  free(miembro);
+  // Se fija una sola vez, antes del primer despacho
+  if (equipo->afinidad) {
+    fijar_afinidad(equipo->afinidad, equipo->primer_hilo + num_hilo);
+  }
+  size_t generacion = 0;
+  while (true) {
+    // Estacionado hasta el siguiente despacho en el que participe
+    pthread_mutex_lock(&equipo->mutex);
+    while ((equipo->generacion == generacion || num_hilo >= equipo->activos)
+        && !equipo->terminar) {
+      pthread_cond_wait(&equipo->hay_trabajo, &equipo->mutex);
+    }
+    if (equipo->terminar) {
+      pthread_mutex_unlock(&equipo->mutex);
+      break;
+    }
+    generacion = equipo->generacion;
+    pthread_mutex_unlock(&equipo->mutex);
+
+    equipo->rutina(equipo->argumentos + num_hilo * equipo->tamano_argumento);
+
+    // Avisar que terminó, el último despierta al que despachó
+    pthread_mutex_lock(&equipo->mutex);
+    if (--equipo->pendientes == 0) {
+      pthread_cond_signal(&equipo->terminado);
+    }
+    pthread_mutex_unlock(&equipo->mutex);
+  }
+  return NULL;
+}
+
+int crear_equipo(equipo_t* equipo, size_t hilos_totales,
+    const afinidad_t* afinidad, size_t primer_hilo) {
+  equipo->hilos_totales = 0;
+  equipo->afinidad = afinidad;
+  equipo->primer_hilo = primer_hilo;
+  equipo->rutina = NULL;
+  equipo->argumentos = NULL;
+  equipo->tamano_argumento = 0;
+  equipo->generacion = 0;
+  equipo->activos = 0;
+  equipo->pendientes = 0;
+  equipo->terminar = false;
+  pthread_mutex_init(&equipo->mutex, NULL);
+  pthread_cond_init(&equipo->hay_trabajo, NULL);
+  pthread_cond_init(&equipo->terminado, NULL);
+  equipo->hilos = (pthread_t*) calloc(hilos_totales, sizeof(pthread_t));
+  if (equipo->hilos == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu hilos\n", hilos_totales);
+    destruir_equipo(equipo);
+    return EXIT_FAILURE;
+  }
+  for (size_t num_hilo = 0; num_hilo < hilos_totales; ++num_hilo) {
+    miembro_t* miembro = (miembro_t*) malloc(sizeof(miembro_t));
+    if (miembro) {
+      miembro->equipo = equipo;
+      miembro->num_hilo = num_hilo;
+    }
+    if (miembro == NULL || pthread_create(&equipo->hilos[num_hilo], NULL,
+        trabajar, miembro) != 0) {
+      fprintf(stderr, "Error: could not create secondary thread\n");
+      free(miembro);
+      // Solo se terminan los hilos que sí se crearon
+      destruir_equipo(equipo);
+      return EXIT_FAILURE;
+    }
+    ++equipo->hilos_totales;
+  }
+  return EXIT_SUCCESS;
+}
+
+void despachar_equipo(equipo_t* equipo, void* (*rutina)(void*),
+    void* argumentos, size_t tamano_argumento, size_t hilos) {
+  pthread_mutex_lock(&equipo->mutex);
+  equipo->rutina = rutina;
+  equipo->argumentos = (char*) argumentos;
+  equipo->tamano_argumento = tamano_argumento;
+  equipo->activos = hilos < equipo->hilos_totales
+      ? hilos : equipo->hilos_totales;
+  equipo->pendientes = equipo->activos;
+  // Despertar a los hilos y esperar a que terminen
+  ++equipo->generacion;
+  pthread_cond_broadcast(&equipo->hay_trabajo);
+  while (equipo->pendientes > 0) {
+    pthread_cond_wait(&equipo->terminado, &equipo->mutex);
+  }
+  pthread_mutex_unlock(&equipo->mutex);
+}
+
+void destruir_equipo(equipo_t* equipo) {
+  pthread_mutex_lock(&equipo->mutex);
+  equipo->terminar = true;
+  pthread_cond_broadcast(&equipo->hay_trabajo);
+  pthread_mutex_unlock(&equipo->mutex);
+  for (size_t num_hilo = 0; num_hilo < equipo->hilos_totales; ++num_hilo) {
+    pthread_join(equipo->hilos[num_hilo], NULL);
+  }
+  pthread_cond_destroy(&equipo->terminado);
+  pthread_cond_destroy(&equipo->hay_trabajo);
+  pthread_mutex_destroy(&equipo->mutex);
+  free(equipo->hilos);
+  equipo->hilos = NULL;
+  equipo->hilos_totales = 0;
+}
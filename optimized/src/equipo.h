@@ -0,0 +1,112 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef EQUIPO_H
+#define EQUIPO_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "miscelaneos.h"
+/**
+ * @brief Equipo de hilos persistente.
+ *
+ * Los hilos se crean una sola vez y quedan estacionados en una variable de
+ * condición mientras no haya trabajo. Cada despacho los despierta para
+ * ejecutar una rutina y espera a que todos terminen, sin crear ni unir
+ * hilos.
+ */
+typedef struct equipo {
+  /**
+   * @brief Cantidad de hilos del equipo
+   */
+  size_t hilos_totales;
+  /**
+   * @brief Identificadores de los hilos
+   */
+  pthread_t* hilos;
+  /**
+   * @brief Protege los campos del despacho
+   */
+  pthread_mutex_t mutex;
+  /**
+   * @brief Despierta a los hilos cuando hay un despacho nuevo
+   */
+  pthread_cond_t hay_trabajo;
+  /**
+   * @brief Despierta al hilo que despacha cuando terminó el último hilo
+   */
+  pthread_cond_t terminado;
+  /**
+   * @brief Número del despacho actual, cada hilo recuerda el último que hizo
+   */
+  size_t generacion;
+  /**
+   * @brief Hilos que participan en el despacho actual, los de número mayor
+   * siguen estacionados
+   */
+  size_t activos;
+  /**
+   * @brief Hilos que aún no terminan el despacho actual
+   */
+  size_t pendientes;
+  /**
+   * @brief Rutina del despacho actual
+   */
+  void* (*rutina)(void*);
+  /**
+   * @brief Arreglo de argumentos del despacho actual, uno por hilo
+   */
+  char* argumentos;
+  /**
+   * @brief Tamaño en bytes de cada argumento del arreglo
+   */
+  size_t tamano_argumento;
+  /**
+   * @brief Indica a los hilos que deben terminar
+   */
+  bool terminar;
+  /**
+   * @brief CPUs a las que se fijan los hilos, NULL para no fijarlos
+   */
+  const afinidad_t* afinidad;
+  /**
+   * @brief Posición en el mapa de afinidad del hilo 0 del equipo
+   */
+  size_t primer_hilo;
+} equipo_t;
+/**
+ * @brief Crea los hilos del equipo y los deja estacionados.
+ *
+ * Cada hilo se fija al empezar a su CPU del mapa de afinidad, la de la
+ * posición primer_hilo + num_hilo, así conserva la caché y las páginas de
+ * su bloque entre despachos.
+ *
+ * @param equipo Equipo a inicializar.
+ * @param hilos_totales Cantidad de hilos, al menos 1.
+ * @param afinidad Mapa leído con leer_afinidad(), NULL para no fijarlos.
+ * @param primer_hilo Posición en el mapa del hilo 0 del equipo.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int crear_equipo(equipo_t* equipo, size_t hilos_totales,
+  const afinidad_t* afinidad, size_t primer_hilo);
+/**
+ * @brief Ejecuta una rutina en los primeros hilos del equipo y espera a que
+ * terminen.
+ *
+ * El hilo num_hilo recibe argumentos + num_hilo * tamano_argumento, igual
+ * que si se hubiera creado con pthread_create.
+ *
+ * @param equipo Equipo creado con crear_equipo().
+ * @param rutina Rutina que ejecutará cada hilo.
+ * @param argumentos Arreglo con un argumento por hilo.
+ * @param tamano_argumento Tamaño en bytes de cada argumento.
+ * @param hilos Cantidad de hilos que ejecutan la rutina, a lo sumo los del
+ * equipo.
+ */
+void despachar_equipo(equipo_t* equipo, void* (*rutina)(void*),
+  void* argumentos, size_t tamano_argumento, size_t hilos);
+/**
+ * @brief Termina los hilos del equipo y libera sus recursos.
+ *
+ * @param equipo Equipo creado con crear_equipo().
+ */
+void destruir_equipo(equipo_t* equipo);
+#endif
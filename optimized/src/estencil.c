@@ -0,0 +1,508 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "estencil.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ESTENCIL_X86
+#endif
+
+// Implementación elegida por seleccionar_estencil()
+static estencil_t estencil_actual = calcular_filas_escalar;
+static const char* estencil_nombre = "escalar";
+static estencil_simple_t estencil_simple_actual =
+  calcular_filas_simple_escalar;
+static estencil_lote_t estencil_lote_actual = calcular_lote_escalar;
+
+// Calcula una celda en el mismo orden de sumas que la versión original y
+// retorna el máximo actualizado. La usan la versión escalar y las colas de
+// las versiones vectoriales.
+static inline double actualizar_celda(const double* arriba,
+    const double* centro, const double* abajo, double* destino, size_t j,
+    double coeficiente, double maximo) {
+  destino[j] = centro[j] + (coeficiente * (arriba[j] + centro[j + 1]
+      + abajo[j] + centro[j - 1] - (4 * centro[j])));
+  const double cambio_temp = fabs(centro[j] - destino[j]);
+  return cambio_temp > maximo ? cambio_temp : maximo;
+}
+
+// Obtiene el mayor de los valores de un arreglo pequeño
+static inline double maximo_arreglo(const double* valores, size_t cantidad) {
+  double maximo = valores[0];
+  for (size_t k = 1; k < cantidad; ++k) {
+    if (valores[k] > maximo) {
+      maximo = valores[k];
+    }
+  }
+  return maximo;
+}
+
+double calcular_filas_escalar(const double* matriz, double* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  double maximo = 0.0;
+  for (size_t i = fila_inicio; i < fila_final; ++i) {
+    const double* restrict arriba = matriz + (i - 1) * paso;
+    const double* restrict centro = arriba + paso;
+    const double* restrict abajo = centro + paso;
+    double* restrict destino = matriz2 + i * paso;
+    for (size_t j = 1; j < n_columnas - 1; ++j) {
+      maximo = actualizar_celda(arriba, centro, abajo, destino, j,
+        coeficiente, maximo);
+    }
+  }
+  return maximo;
+}
+
+// Igual que actualizar_celda() con almacenamiento en float: la celda se
+// calcula en double y el cambio se mide contra el valor redondeado
+static inline double actualizar_celda_simple(const float* arriba,
+    const float* centro, const float* abajo, float* destino, size_t j,
+    double coeficiente, double maximo) {
+  const double actual = centro[j];
+  destino[j] = (float) (actual + (coeficiente * ((double) arriba[j]
+      + (double) centro[j + 1] + (double) abajo[j] + (double) centro[j - 1]
+      - (4 * actual))));
+  const double cambio_temp = fabs(actual - (double) destino[j]);
+  return cambio_temp > maximo ? cambio_temp : maximo;
+}
+
+double calcular_filas_simple_escalar(const float* matriz, float* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  double maximo = 0.0;
+  for (size_t i = fila_inicio; i < fila_final; ++i) {
+    const float* restrict arriba = matriz + (i - 1) * paso;
+    const float* restrict centro = arriba + paso;
+    const float* restrict abajo = centro + paso;
+    float* restrict destino = matriz2 + i * paso;
+    for (size_t j = 1; j < n_columnas - 1; ++j) {
+      maximo = actualizar_celda_simple(arriba, centro, abajo, destino, j,
+        coeficiente, maximo);
+    }
+  }
+  return maximo;
+}
+
+void calcular_lote_escalar(const double* matriz, double* matriz2,
+    size_t n_filas, size_t n_columnas, const double* coeficientes,
+    double* maximos) {
+  const size_t fila = n_columnas * CARRILES_LOTE;
+  for (size_t k = 0; k < CARRILES_LOTE; ++k) {
+    maximos[k] = 0.0;
+  }
+  for (size_t i = 1; i + 1 < n_filas; ++i) {
+    for (size_t j = 1; j + 1 < n_columnas; ++j) {
+      const size_t celda = (i * n_columnas + j) * CARRILES_LOTE;
+      const double* centro = matriz + celda;
+      const double* arriba = centro - fila;
+      const double* abajo = centro + fila;
+      const double* izquierda = centro - CARRILES_LOTE;
+      const double* derecha = centro + CARRILES_LOTE;
+      double* destino = matriz2 + celda;
+      for (size_t k = 0; k < CARRILES_LOTE; ++k) {
+        destino[k] = centro[k] + (coeficientes[k] * (arriba[k] + derecha[k]
+            + abajo[k] + izquierda[k] - (4 * centro[k])));
+        const double cambio_temp = fabs(centro[k] - destino[k]);
+        maximos[k] = cambio_temp > maximos[k] ? cambio_temp : maximos[k];
+      }
+    }
+  }
+}
+
+#ifdef ESTENCIL_X86
+// Las versiones vectoriales recorren dos filas por pasada: la fila central
+// de una es la vecina de la otra, así se cargan 4 filas para producir 2. Si
+// queda una fila impar se recorre sola. Nunca se usan instrucciones FMA
+// para que el redondeo sea el mismo de la versión escalar.
+
+__attribute__((target("sse2")))
+static double calcular_filas_sse2(const double* matriz, double* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  const __m128d coef = _mm_set1_pd(coeficiente);
+  const __m128d cuatro = _mm_set1_pd(4.0);
+  const __m128d signo = _mm_set1_pd(-0.0);
+  __m128d maximo = _mm_setzero_pd();
+  double maximo_cola = 0.0;
+  const size_t borde = n_columnas - 1;
+  size_t i = fila_inicio;
+  for (; i < fila_final; i += 2) {
+    const bool doble = i + 1 < fila_final;
+    const double* arriba = matriz + (i - 1) * paso;
+    const double* centro0 = arriba + paso;
+    const double* centro1 = centro0 + paso;
+    const double* abajo = centro1 + paso;
+    double* destino0 = matriz2 + i * paso;
+    double* destino1 = destino0 + paso;
+    size_t j = 1;
+    for (; j + 2 <= borde; j += 2) {
+      const __m128d a = _mm_loadu_pd(arriba + j);
+      const __m128d c0 = _mm_loadu_pd(centro0 + j);
+      const __m128d c1 = _mm_loadu_pd(centro1 + j);
+      __m128d s0 = _mm_add_pd(a, _mm_loadu_pd(centro0 + j + 1));
+      s0 = _mm_add_pd(s0, c1);
+      s0 = _mm_add_pd(s0, _mm_loadu_pd(centro0 + j - 1));
+      s0 = _mm_sub_pd(s0, _mm_mul_pd(cuatro, c0));
+      const __m128d n0 = _mm_add_pd(c0, _mm_mul_pd(coef, s0));
+      _mm_storeu_pd(destino0 + j, n0);
+      maximo = _mm_max_pd(maximo, _mm_andnot_pd(signo, _mm_sub_pd(c0, n0)));
+      if (doble) {
+        __m128d s1 = _mm_add_pd(c0, _mm_loadu_pd(centro1 + j + 1));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(abajo + j));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(centro1 + j - 1));
+        s1 = _mm_sub_pd(s1, _mm_mul_pd(cuatro, c1));
+        const __m128d n1 = _mm_add_pd(c1, _mm_mul_pd(coef, s1));
+        _mm_storeu_pd(destino1 + j, n1);
+        maximo = _mm_max_pd(maximo,
+          _mm_andnot_pd(signo, _mm_sub_pd(c1, n1)));
+      }
+    }
+    for (; j < borde; ++j) {
+      maximo_cola = actualizar_celda(arriba, centro0, centro1, destino0, j,
+        coeficiente, maximo_cola);
+      if (doble) {
+        maximo_cola = actualizar_celda(centro0, centro1, abajo, destino1, j,
+          coeficiente, maximo_cola);
+      }
+    }
+  }
+  double carriles[2];
+  _mm_storeu_pd(carriles, maximo);
+  const double maximo_vector = maximo_arreglo(carriles, 2);
+  return maximo_vector > maximo_cola ? maximo_vector : maximo_cola;
+}
+
+__attribute__((target("avx2")))
+static double calcular_filas_avx2(const double* matriz, double* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  const __m256d coef = _mm256_set1_pd(coeficiente);
+  const __m256d cuatro = _mm256_set1_pd(4.0);
+  const __m256d signo = _mm256_set1_pd(-0.0);
+  __m256d maximo = _mm256_setzero_pd();
+  double maximo_cola = 0.0;
+  const size_t borde = n_columnas - 1;
+  size_t i = fila_inicio;
+  for (; i < fila_final; i += 2) {
+    const bool doble = i + 1 < fila_final;
+    const double* arriba = matriz + (i - 1) * paso;
+    const double* centro0 = arriba + paso;
+    const double* centro1 = centro0 + paso;
+    const double* abajo = centro1 + paso;
+    double* destino0 = matriz2 + i * paso;
+    double* destino1 = destino0 + paso;
+    size_t j = 1;
+    for (; j + 4 <= borde; j += 4) {
+      const __m256d a = _mm256_loadu_pd(arriba + j);
+      const __m256d c0 = _mm256_loadu_pd(centro0 + j);
+      const __m256d c1 = _mm256_loadu_pd(centro1 + j);
+      __m256d s0 = _mm256_add_pd(a, _mm256_loadu_pd(centro0 + j + 1));
+      s0 = _mm256_add_pd(s0, c1);
+      s0 = _mm256_add_pd(s0, _mm256_loadu_pd(centro0 + j - 1));
+      s0 = _mm256_sub_pd(s0, _mm256_mul_pd(cuatro, c0));
+      const __m256d n0 = _mm256_add_pd(c0, _mm256_mul_pd(coef, s0));
+      _mm256_storeu_pd(destino0 + j, n0);
+      maximo = _mm256_max_pd(maximo,
+        _mm256_andnot_pd(signo, _mm256_sub_pd(c0, n0)));
+      if (doble) {
+        __m256d s1 = _mm256_add_pd(c0, _mm256_loadu_pd(centro1 + j + 1));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(abajo + j));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(centro1 + j - 1));
+        s1 = _mm256_sub_pd(s1, _mm256_mul_pd(cuatro, c1));
+        const __m256d n1 = _mm256_add_pd(c1, _mm256_mul_pd(coef, s1));
+        _mm256_storeu_pd(destino1 + j, n1);
+        maximo = _mm256_max_pd(maximo,
+          _mm256_andnot_pd(signo, _mm256_sub_pd(c1, n1)));
+      }
+    }
+    for (; j < borde; ++j) {
+      maximo_cola = actualizar_celda(arriba, centro0, centro1, destino0, j,
+        coeficiente, maximo_cola);
+      if (doble) {
+        maximo_cola = actualizar_celda(centro0, centro1, abajo, destino1, j,
+          coeficiente, maximo_cola);
+      }
+    }
+  }
+  double carriles[4];
+  _mm256_storeu_pd(carriles, maximo);
+  const double maximo_vector = maximo_arreglo(carriles, 4);
+  return maximo_vector > maximo_cola ? maximo_vector : maximo_cola;
+}
+
+__attribute__((target("avx512f")))
+static double calcular_filas_avx512(const double* matriz, double* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  const __m512d coef = _mm512_set1_pd(coeficiente);
+  const __m512d cuatro = _mm512_set1_pd(4.0);
+  __m512d maximo = _mm512_setzero_pd();
+  double maximo_cola = 0.0;
+  const size_t borde = n_columnas - 1;
+  size_t i = fila_inicio;
+  for (; i < fila_final; i += 2) {
+    const bool doble = i + 1 < fila_final;
+    const double* arriba = matriz + (i - 1) * paso;
+    const double* centro0 = arriba + paso;
+    const double* centro1 = centro0 + paso;
+    const double* abajo = centro1 + paso;
+    double* destino0 = matriz2 + i * paso;
+    double* destino1 = destino0 + paso;
+    size_t j = 1;
+    for (; j + 8 <= borde; j += 8) {
+      const __m512d a = _mm512_loadu_pd(arriba + j);
+      const __m512d c0 = _mm512_loadu_pd(centro0 + j);
+      const __m512d c1 = _mm512_loadu_pd(centro1 + j);
+      __m512d s0 = _mm512_add_pd(a, _mm512_loadu_pd(centro0 + j + 1));
+      s0 = _mm512_add_pd(s0, c1);
+      s0 = _mm512_add_pd(s0, _mm512_loadu_pd(centro0 + j - 1));
+      s0 = _mm512_sub_pd(s0, _mm512_mul_pd(cuatro, c0));
+      const __m512d n0 = _mm512_add_pd(c0, _mm512_mul_pd(coef, s0));
+      _mm512_storeu_pd(destino0 + j, n0);
+      maximo = _mm512_max_pd(maximo, _mm512_abs_pd(_mm512_sub_pd(c0, n0)));
+      if (doble) {
+        __m512d s1 = _mm512_add_pd(c0, _mm512_loadu_pd(centro1 + j + 1));
+        s1 = _mm512_add_pd(s1, _mm512_loadu_pd(abajo + j));
+        s1 = _mm512_add_pd(s1, _mm512_loadu_pd(centro1 + j - 1));
+        s1 = _mm512_sub_pd(s1, _mm512_mul_pd(cuatro, c1));
+        const __m512d n1 = _mm512_add_pd(c1, _mm512_mul_pd(coef, s1));
+        _mm512_storeu_pd(destino1 + j, n1);
+        maximo = _mm512_max_pd(maximo,
+          _mm512_abs_pd(_mm512_sub_pd(c1, n1)));
+      }
+    }
+    for (; j < borde; ++j) {
+      maximo_cola = actualizar_celda(arriba, centro0, centro1, destino0, j,
+        coeficiente, maximo_cola);
+      if (doble) {
+        maximo_cola = actualizar_celda(centro0, centro1, abajo, destino1, j,
+          coeficiente, maximo_cola);
+      }
+    }
+  }
+  double carriles[8];
+  _mm512_storeu_pd(carriles, maximo);
+  const double maximo_vector = maximo_arreglo(carriles, 8);
+  return maximo_vector > maximo_cola ? maximo_vector : maximo_cola;
+}
+
+// Versión en float: carga 4 float, los convierte a double, calcula con las
+// mismas operaciones que la versión double y redondea al guardar
+__attribute__((target("avx2")))
+static double calcular_filas_simple_avx2(const float* matriz, float* matriz2,
+    size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  const __m256d coef = _mm256_set1_pd(coeficiente);
+  const __m256d cuatro = _mm256_set1_pd(4.0);
+  const __m256d signo = _mm256_set1_pd(-0.0);
+  __m256d maximo = _mm256_setzero_pd();
+  double maximo_cola = 0.0;
+  const size_t borde = n_columnas - 1;
+  for (size_t i = fila_inicio; i < fila_final; ++i) {
+    const float* arriba = matriz + (i - 1) * paso;
+    const float* centro = arriba + paso;
+    const float* abajo = centro + paso;
+    float* destino = matriz2 + i * paso;
+    size_t j = 1;
+    for (; j + 4 <= borde; j += 4) {
+      const __m256d c = _mm256_cvtps_pd(_mm_loadu_ps(centro + j));
+      __m256d s = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(arriba + j)),
+        _mm256_cvtps_pd(_mm_loadu_ps(centro + j + 1)));
+      s = _mm256_add_pd(s, _mm256_cvtps_pd(_mm_loadu_ps(abajo + j)));
+      s = _mm256_add_pd(s, _mm256_cvtps_pd(_mm_loadu_ps(centro + j - 1)));
+      s = _mm256_sub_pd(s, _mm256_mul_pd(cuatro, c));
+      const __m128 n = _mm256_cvtpd_ps(_mm256_add_pd(c,
+        _mm256_mul_pd(coef, s)));
+      _mm_storeu_ps(destino + j, n);
+      maximo = _mm256_max_pd(maximo,
+        _mm256_andnot_pd(signo, _mm256_sub_pd(c, _mm256_cvtps_pd(n))));
+    }
+    for (; j < borde; ++j) {
+      maximo_cola = actualizar_celda_simple(arriba, centro, abajo, destino, j,
+        coeficiente, maximo_cola);
+    }
+  }
+  double carriles[4];
+  _mm256_storeu_pd(carriles, maximo);
+  const double maximo_vector = maximo_arreglo(carriles, 4);
+  return maximo_vector > maximo_cola ? maximo_vector : maximo_cola;
+}
+
+// Versiones por lotes: cada celda es una línea de caché con la misma celda
+// de CARRILES_LOTE láminas, que se recorre en vectores del ancho de la ISA.
+// El máximo de cada carril queda en su posición del vector, sin reducirlo
+
+__attribute__((target("sse2")))
+static void calcular_lote_sse2(const double* matriz, double* matriz2,
+    size_t n_filas, size_t n_columnas, const double* coeficientes,
+    double* maximos) {
+  const size_t fila = n_columnas * CARRILES_LOTE;
+  const __m128d cuatro = _mm_set1_pd(4.0);
+  const __m128d signo = _mm_set1_pd(-0.0);
+  __m128d coef[CARRILES_LOTE / 2];
+  __m128d maximo[CARRILES_LOTE / 2];
+  for (size_t v = 0; v < CARRILES_LOTE / 2; ++v) {
+    coef[v] = _mm_loadu_pd(coeficientes + 2 * v);
+    maximo[v] = _mm_setzero_pd();
+  }
+  for (size_t i = 1; i + 1 < n_filas; ++i) {
+    for (size_t j = 1; j + 1 < n_columnas; ++j) {
+      const size_t celda = (i * n_columnas + j) * CARRILES_LOTE;
+      for (size_t v = 0; v < CARRILES_LOTE / 2; ++v) {
+        const double* centro = matriz + celda + 2 * v;
+        const __m128d c = _mm_loadu_pd(centro);
+        __m128d s = _mm_add_pd(_mm_loadu_pd(centro - fila),
+          _mm_loadu_pd(centro + CARRILES_LOTE));
+        s = _mm_add_pd(s, _mm_loadu_pd(centro + fila));
+        s = _mm_add_pd(s, _mm_loadu_pd(centro - CARRILES_LOTE));
+        s = _mm_sub_pd(s, _mm_mul_pd(cuatro, c));
+        const __m128d n = _mm_add_pd(c, _mm_mul_pd(coef[v], s));
+        _mm_storeu_pd(matriz2 + celda + 2 * v, n);
+        maximo[v] = _mm_max_pd(maximo[v],
+          _mm_andnot_pd(signo, _mm_sub_pd(c, n)));
+      }
+    }
+  }
+  for (size_t v = 0; v < CARRILES_LOTE / 2; ++v) {
+    _mm_storeu_pd(maximos + 2 * v, maximo[v]);
+  }
+}
+
+__attribute__((target("avx2")))
+static void calcular_lote_avx2(const double* matriz, double* matriz2,
+    size_t n_filas, size_t n_columnas, const double* coeficientes,
+    double* maximos) {
+  const size_t fila = n_columnas * CARRILES_LOTE;
+  const __m256d cuatro = _mm256_set1_pd(4.0);
+  const __m256d signo = _mm256_set1_pd(-0.0);
+  __m256d coef[CARRILES_LOTE / 4];
+  __m256d maximo[CARRILES_LOTE / 4];
+  for (size_t v = 0; v < CARRILES_LOTE / 4; ++v) {
+    coef[v] = _mm256_loadu_pd(coeficientes + 4 * v);
+    maximo[v] = _mm256_setzero_pd();
+  }
+  for (size_t i = 1; i + 1 < n_filas; ++i) {
+    for (size_t j = 1; j + 1 < n_columnas; ++j) {
+      const size_t celda = (i * n_columnas + j) * CARRILES_LOTE;
+      for (size_t v = 0; v < CARRILES_LOTE / 4; ++v) {
+        const double* centro = matriz + celda + 4 * v;
+        const __m256d c = _mm256_loadu_pd(centro);
+        __m256d s = _mm256_add_pd(_mm256_loadu_pd(centro - fila),
+          _mm256_loadu_pd(centro + CARRILES_LOTE));
+        s = _mm256_add_pd(s, _mm256_loadu_pd(centro + fila));
+        s = _mm256_add_pd(s, _mm256_loadu_pd(centro - CARRILES_LOTE));
+        s = _mm256_sub_pd(s, _mm256_mul_pd(cuatro, c));
+        const __m256d n = _mm256_add_pd(c, _mm256_mul_pd(coef[v], s));
+        _mm256_storeu_pd(matriz2 + celda + 4 * v, n);
+        maximo[v] = _mm256_max_pd(maximo[v],
+          _mm256_andnot_pd(signo, _mm256_sub_pd(c, n)));
+      }
+    }
+  }
+  for (size_t v = 0; v < CARRILES_LOTE / 4; ++v) {
+    _mm256_storeu_pd(maximos + 4 * v, maximo[v]);
+  }
+}
+
+__attribute__((target("avx512f")))
+static void calcular_lote_avx512(const double* matriz, double* matriz2,
+    size_t n_filas, size_t n_columnas, const double* coeficientes,
+    double* maximos) {
+  const size_t fila = n_columnas * CARRILES_LOTE;
+  const __m512d cuatro = _mm512_set1_pd(4.0);
+  const __m512d coef = _mm512_loadu_pd(coeficientes);
+  __m512d maximo = _mm512_setzero_pd();
+  for (size_t i = 1; i + 1 < n_filas; ++i) {
+    for (size_t j = 1; j + 1 < n_columnas; ++j) {
+      const size_t celda = (i * n_columnas + j) * CARRILES_LOTE;
+      const double* centro = matriz + celda;
+      const __m512d c = _mm512_loadu_pd(centro);
+      __m512d s = _mm512_add_pd(_mm512_loadu_pd(centro - fila),
+        _mm512_loadu_pd(centro + CARRILES_LOTE));
+      s = _mm512_add_pd(s, _mm512_loadu_pd(centro + fila));
+      s = _mm512_add_pd(s, _mm512_loadu_pd(centro - CARRILES_LOTE));
+      s = _mm512_sub_pd(s, _mm512_mul_pd(cuatro, c));
+      const __m512d n = _mm512_add_pd(c, _mm512_mul_pd(coef, s));
+      _mm512_storeu_pd(matriz2 + celda, n);
+      maximo = _mm512_max_pd(maximo, _mm512_abs_pd(_mm512_sub_pd(c, n)));
+    }
+  }
+  _mm512_storeu_pd(maximos, maximo);
+}
+#endif
+
+void seleccionar_estencil(void) {
+  // Implementaciones de la más ancha a la más angosta
+  static const struct {
+    const char* nombre;
+    estencil_t funcion;
+    estencil_lote_t lote;
+  } candidatos[] = {
+#ifdef ESTENCIL_X86
+    {"avx512", calcular_filas_avx512, calcular_lote_avx512},
+    {"avx2", calcular_filas_avx2, calcular_lote_avx2},
+    {"sse2", calcular_filas_sse2, calcular_lote_sse2},
+#endif
+    {"escalar", calcular_filas_escalar, calcular_lote_escalar},
+  };
+  const size_t cantidad = sizeof(candidatos) / sizeof(candidatos[0]);
+  // La versión escalar, que siempre es la última, funciona en cualquier CPU
+  bool soportada[sizeof(candidatos) / sizeof(candidatos[0])] = {false};
+  soportada[cantidad - 1] = true;
+#ifdef ESTENCIL_X86
+  __builtin_cpu_init();
+  soportada[0] = __builtin_cpu_supports("avx512f");
+  soportada[1] = __builtin_cpu_supports("avx2");
+  soportada[2] = __builtin_cpu_supports("sse2");
+#endif
+  // Si el usuario pide una implementación se respeta cuando es soportada
+  const char* pedida = getenv(ESTENCIL_ENTORNO);
+  size_t elegida = cantidad;
+  for (size_t k = 0; k < cantidad && pedida; ++k) {
+    if (strcmp(pedida, candidatos[k].nombre) == 0 && soportada[k]) {
+      elegida = k;
+    }
+  }
+  for (size_t k = 0; k < cantidad && elegida == cantidad; ++k) {
+    if (soportada[k]) {
+      elegida = k;
+    }
+  }
+  estencil_actual = candidatos[elegida].funcion;
+  estencil_lote_actual = candidatos[elegida].lote;
+  estencil_nombre = candidatos[elegida].nombre;
+  estencil_simple_actual = calcular_filas_simple_escalar;
+#ifdef ESTENCIL_X86
+  // avx512 y avx2 son los dos primeros candidatos
+  if (elegida < 2) {
+    estencil_simple_actual = calcular_filas_simple_avx2;
+  }
+#endif
+}
+
+const char* nombre_estencil(void) {
+  return estencil_nombre;
+}
+
+double calcular_filas(const double* matriz, double* matriz2, size_t paso,
+    size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  return estencil_actual(matriz, matriz2, paso, n_columnas, fila_inicio,
+    fila_final, coeficiente);
+}
+
+double calcular_filas_simple(const float* matriz, float* matriz2, size_t paso,
+    size_t n_columnas, size_t fila_inicio, size_t fila_final,
+    double coeficiente) {
+  return estencil_simple_actual(matriz, matriz2, paso, n_columnas,
+    fila_inicio, fila_final, coeficiente);
+}
+
+void calcular_lote(const double* matriz, double* matriz2, size_t n_filas,
+    size_t n_columnas, const double* coeficientes, double* maximos) {
+  estencil_lote_actual(matriz, matriz2, n_filas, n_columnas, coeficientes,
+    maximos);
+}
@@ -0,0 +1,132 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef ESTENCIL_H
+#define ESTENCIL_H
+#include <stddef.h>
+/**
+ * @brief Variable de entorno que permite forzar una implementación del
+ * estencil: escalar, sse2, avx2 o avx512.
+ */
+#define ESTENCIL_ENTORNO "ESTENCIL_ISA"
+/**
+ * @brief Láminas que avanza a la vez el estencil por lotes, tantas como
+ * double caben en una línea de caché
+ */
+#define CARRILES_LOTE 8
+/**
+ * @brief Firma común de las implementaciones del estencil de 5 puntos.
+ *
+ * Calcula matriz2 a partir de matriz para las filas [fila_inicio,
+ * fila_final) y las columnas internas, y en la misma pasada obtiene el
+ * mayor cambio absoluto de temperatura entre ambos estados.
+ *
+ * @param matriz Matriz con el estado actual.
+ * @param matriz2 Matriz donde se escribe el estado siguiente.
+ * @param paso Paso de las filas de ambas matrices.
+ * @param n_columnas Número de columnas de la lámina, incluidos bordes.
+ * @param fila_inicio Primera fila a calcular, debe ser mayor a 0.
+ * @param fila_final Fila siguiente a la última, a lo sumo n_filas - 1.
+ * @param coeficiente Coeficiente de difusión térmica.
+ * @return Mayor cambio de temperatura en las filas calculadas.
+ */
+typedef double (*estencil_t)(const double* matriz, double* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Firma de las implementaciones del estencil con almacenamiento en
+ * float.
+ *
+ * Igual que estencil_t, pero las matrices guardan float. Cada celda se
+ * convierte a double, se calcula en el mismo orden que la versión double y
+ * se redondea a float al guardarla. El cambio se mide contra el valor ya
+ * redondeado, así una celda que no cambia en float tiene cambio 0.
+ *
+ * @see estencil_t
+ */
+typedef double (*estencil_simple_t)(const float* matriz, float* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Firma de las implementaciones del estencil por lotes.
+ *
+ * Las matrices guardan CARRILES_LOTE láminas de la misma forma, sin
+ * relleno: la celda (i, j) de la lámina del carril k está en
+ * matriz[(i * n_columnas + j) * CARRILES_LOTE + k]. Cada carril se calcula
+ * con su coeficiente y en el mismo orden de sumas que estencil_t, así cada
+ * lámina obtiene los mismos valores que si se simulara sola.
+ *
+ * @param matriz Matriz con el estado actual de los carriles.
+ * @param matriz2 Matriz donde se escribe el estado siguiente.
+ * @param n_filas Número de filas de las láminas, incluidos bordes.
+ * @param n_columnas Número de columnas de las láminas, incluidos bordes.
+ * @param coeficientes Coeficiente de difusión térmica de cada carril.
+ * @param maximos Mayor cambio de temperatura de cada carril.
+ */
+typedef void (*estencil_lote_t)(const double* matriz, double* matriz2,
+  size_t n_filas, size_t n_columnas, const double* coeficientes,
+  double* maximos);
+/**
+ * @brief Elige la implementación más ancha que soporta el procesador.
+ *
+ * Si ESTENCIL_ISA está definida y el procesador soporta la implementación
+ * pedida, se usa esa. La versión en float usa avx2 si se eligió avx2 o
+ * avx512, y la escalar en otro caso. Debe llamarse antes de crear los hilos.
+ */
+void seleccionar_estencil(void);
+/**
+ * @brief Retorna el nombre de la implementación elegida.
+ *
+ * @return escalar, sse2, avx2 o avx512.
+ */
+const char* nombre_estencil(void);
+/**
+ * @brief Aplica la implementación elegida a un rango de filas.
+ *
+ * Todas las implementaciones suman en el mismo orden que la versión
+ * escalar, por lo que los resultados son idénticos bit a bit.
+ *
+ * @see estencil_t
+ */
+double calcular_filas(const double* matriz, double* matriz2, size_t paso,
+  size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Implementación escalar de referencia del estencil.
+ *
+ * @see estencil_t
+ */
+double calcular_filas_escalar(const double* matriz, double* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Aplica la implementación en float elegida a un rango de filas.
+ *
+ * @see estencil_simple_t
+ */
+double calcular_filas_simple(const float* matriz, float* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Implementación escalar de referencia del estencil en float.
+ *
+ * @see estencil_simple_t
+ */
+double calcular_filas_simple_escalar(const float* matriz, float* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Aplica la implementación por lotes elegida a todas las celdas
+ * internas de los carriles.
+ *
+ * @see estencil_lote_t
+ */
+void calcular_lote(const double* matriz, double* matriz2, size_t n_filas,
+  size_t n_columnas, const double* coeficientes, double* maximos);
+/**
+ * @brief Implementación escalar de referencia del estencil por lotes.
+ *
+ * @see estencil_lote_t
+ */
+void calcular_lote_escalar(const double* matriz, double* matriz2,
+  size_t n_filas, size_t n_columnas, const double* coeficientes,
+  double* maximos);
+#endif
@@ -0,0 +1,394 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include "estrategia.h"
+
+// El estencil recorre dos filas por pasada, lee cuatro y escribe dos. Las
+// filas muy anchas se recorren por franjas para que esas seis quepan en la
+// mitad de L2 y cada fila se lea de la caché al pasar a la siguiente
+static void calcular_ancho_franja(mem_comp_t* mem_comp) {
+  const size_t doubles_por_linea = LINEA_CACHE / sizeof(double);
+  size_t ancho = tamano_cache_l2() / 2 / (6 * sizeof(double))
+      / doubles_por_linea * doubles_por_linea;
+  mem_comp->ancho_franja = ancho ? ancho : doubles_por_linea;
+}
+
+// Divide el interior de la lámina en una cuadrícula de a lo sumo hilos
+// bloques, uno por hilo. Se prefieren bloques de filas completas y las
+// columnas solo se dividen si faltan filas para ocupar a los hilos
+static void repartir_bloques(const lamina_t* lamina, mem_comp_t* mem_comp,
+    size_t hilos) {
+  const size_t filas_internas = mem_comp->filas_internas;
+  const size_t columnas_internas = lamina->n_columnas > 2
+      ? lamina->n_columnas - 2 : 0;
+  // Cada bloque de columnas tiene al menos una línea de caché por fila
+  const size_t doubles_por_linea = LINEA_CACHE / sizeof(double);
+  size_t maximo_columnas = columnas_internas / doubles_por_linea;
+  maximo_columnas = maximo_columnas ? maximo_columnas : 1;
+  size_t hilos_filas = 0;
+  size_t hilos_columnas = 0;
+  if (columnas_internas > 0) {
+    for (size_t filas = hilos < filas_internas ? hilos : filas_internas;
+        filas > 0; --filas) {
+      size_t columnas = hilos / filas;
+      columnas = columnas < maximo_columnas ? columnas : maximo_columnas;
+      if (filas * columnas > hilos_filas * hilos_columnas) {
+        hilos_filas = filas;
+        hilos_columnas = columnas;
+      }
+    }
+  }
+  mem_comp->hilos_filas = hilos_filas;
+  mem_comp->hilos_columnas = hilos_columnas;
+  mem_comp->hilos_totales = hilos_filas * hilos_columnas;
+  // distribución de filas entre los bloques de filas
+  size_t filas_por_hilo = hilos_filas ? filas_internas / hilos_filas : 0;
+  size_t extra = hilos_filas ? filas_internas % hilos_filas : 0;
+  for (size_t num_hilo = 0; num_hilo < mem_comp->equipo.hilos_totales;
+      ++num_hilo) {
+    mem_priv_t* mem_priv = &mem_comp->mem_priv[num_hilo];
+    if (num_hilo < mem_comp->hilos_totales) {
+      const size_t bloque_filas = num_hilo / hilos_columnas;
+      const size_t bloque_columnas = num_hilo % hilos_columnas;
+      mem_priv->fila_inicio = bloque_filas * filas_por_hilo +
+          (bloque_filas < extra ? bloque_filas : extra) + 1;
+      mem_priv->fila_final = mem_priv->fila_inicio + filas_por_hilo +
+          (bloque_filas < extra ? 1 : 0);
+      // Los cortes entre bloques de columnas caen en un inicio de línea de
+      // caché, así dos hilos nunca escriben la misma línea
+      mem_priv->columna_inicio = bloque_columnas == 0 ? 1
+          : (1 + bloque_columnas * columnas_internas / hilos_columnas)
+          / doubles_por_linea * doubles_por_linea;
+      mem_priv->columna_final = bloque_columnas + 1 == hilos_columnas
+          ? lamina->n_columnas - 1
+          : (1 + (bloque_columnas + 1) * columnas_internas / hilos_columnas)
+          / doubles_por_linea * doubles_por_linea;
+    } else {
+      mem_priv->fila_inicio = mem_priv->fila_final = 1;
+      mem_priv->columna_inicio = mem_priv->columna_final = 1;
+    }
+  }
+  calcular_ancho_franja(mem_comp);
+}
+
+// Un solo bloque con toda la lámina, calculado por el hilo que despacha
+static void repartir_serial(const lamina_t* lamina, mem_comp_t* mem_comp,
+    size_t hilos) {
+  (void) hilos;
+  repartir_bloques(lamina, mem_comp, 1);
+}
+
+// Filas completas, un hilo por fila a lo sumo. cyclic recorre desde
+// fila_inicio de hilos_totales en hilos_totales y dynamic toma trozos
+static void repartir_filas(const lamina_t* lamina, mem_comp_t* mem_comp,
+    size_t hilos) {
+  const size_t filas_internas = mem_comp->filas_internas;
+  mem_comp->hilos_totales = hilos < filas_internas ? hilos : filas_internas;
+  mem_comp->hilos_filas = mem_comp->hilos_totales;
+  mem_comp->hilos_columnas = 1;
+  for (size_t num_hilo = 0; num_hilo < mem_comp->equipo.hilos_totales;
+      ++num_hilo) {
+    mem_priv_t* mem_priv = &mem_comp->mem_priv[num_hilo];
+    if (num_hilo < mem_comp->hilos_totales) {
+      mem_priv->fila_inicio = num_hilo + 1;
+      mem_priv->fila_final = lamina->n_filas - 1;
+      mem_priv->columna_inicio = 1;
+      mem_priv->columna_final = lamina->n_columnas - 1;
+    } else {
+      mem_priv->fila_inicio = mem_priv->fila_final = 1;
+      mem_priv->columna_inicio = mem_priv->columna_final = 1;
+    }
+  }
+  // Filas por trozo para que cada trozo tenga al menos CELDAS_TROZO celdas
+  mem_comp->trozo_minimo = CELDAS_TROZO / lamina->n_columnas;
+  if (mem_comp->trozo_minimo == 0) {
+    mem_comp->trozo_minimo = 1;
+  }
+  calcular_ancho_franja(mem_comp);
+}
+
+// Estrategias de --strategy, en auto serial es la de las láminas que el
+// modelo de costo calcula con un hilo y static-block la de las demás
+static const estrategia_t estrategias[] = {
+  {"serial", repartir_serial, calculo_matriz, true, true},
+  {"static-block", repartir_bloques, calculo_matriz, true, true},
+  {"cyclic", repartir_filas, calculo_ciclico, false, false},
+  {"dynamic", repartir_filas, calculo_dinamico, false, false},
+};
+
+const estrategia_t* buscar_estrategia(const char* nombre) {
+  const size_t cantidad = sizeof(estrategias) / sizeof(estrategias[0]);
+  for (size_t indice = 0; indice < cantidad; ++indice) {
+    if (strcmp(estrategias[indice].nombre, nombre) == 0) {
+      return &estrategias[indice];
+    }
+  }
+  return NULL;
+}
+
+const estrategia_t* elegir_estrategia(const mem_comp_t* mem_comp,
+    const lamina_t* lamina, size_t* hilos) {
+  if (mem_comp->opciones->estrategia) {
+    return mem_comp->opciones->estrategia;
+  }
+  const size_t columnas_internas = lamina->n_columnas > 2
+      ? lamina->n_columnas - 2 : 0;
+  *hilos = elegir_hilos(&mem_comp->costo, mem_comp->filas_internas
+    * columnas_internas, *hilos);
+  return *hilos > 1 ? &estrategias[1] : &estrategias[0];
+}
+
+// Calcula las filas [fila_inicio, fila_final) entre las columnas
+// [columna_inicio, columna_final) por franjas de ancho_franja columnas, en
+// double o en float según --float-storage, y retorna el mayor cambio
+static double calcular_rectangulo(const mem_comp_t* mem_comp,
+    size_t fila_inicio, size_t fila_final, size_t columna_inicio,
+    size_t columna_final) {
+  const lamina_t* lamina = mem_comp->lamina;
+  const bool simple = mem_comp->opciones->almacenamiento_simple != 0;
+  double maximo = 0.0;
+  for (size_t inicio = columna_inicio; inicio < columna_final;
+      inicio += mem_comp->ancho_franja) {
+    const size_t final = inicio + mem_comp->ancho_franja < columna_final
+        ? inicio + mem_comp->ancho_franja : columna_final;
+    // El estencil calcula de la columna 1 a la penúltima de lo que recibe,
+    // se le pasa la franja con una columna de halo por lado
+    const size_t ancho = final - inicio + 2;
+    double cambio_temp = 0.0;
+    if (simple) {
+      cambio_temp = calcular_filas_simple(mem_comp->simple[0] + inicio - 1,
+        mem_comp->simple[1] + inicio - 1, mem_comp->paso_simple, ancho,
+        fila_inicio, fila_final, mem_comp->coeficiente);
+    } else {
+      cambio_temp = calcular_filas(lamina->matriz + inicio - 1,
+        lamina->matriz2 + inicio - 1, lamina->paso, ancho, fila_inicio,
+        fila_final, mem_comp->coeficiente);
+    }
+    if (cambio_temp > maximo) {
+      maximo = cambio_temp;
+    }
+  }
+  return maximo;
+}
+
+void* calculo_matriz(void* mem) {
+  // punteros a structs de memoria privada y compartida
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  // llenar la matriz de lamina_2 segun la relación,ignorando bordes, y
+  // tomar el mayor cambio del bloque en la misma pasada. El bloque del hilo
+  // se calculó al iniciar la lámina
+  mem_priv->p_max_temp = calcular_rectangulo(mem_priv->mem_comp,
+    mem_priv->fila_inicio, mem_priv->fila_final, mem_priv->columna_inicio,
+    mem_priv->columna_final);
+  return NULL;
+}
+
+// Corta el tramo [inicio, final) en pedazos de a lo sumo alto y agrega sus
+// inicios a cortes. Retorna la cantidad de cortes
+static size_t cortar_tramo(size_t* cortes, size_t cantidad, size_t inicio,
+    size_t final, size_t alto) {
+  for (size_t corte = inicio; corte < final; corte += alto) {
+    cortes[cantidad++] = corte;
+  }
+  return cantidad;
+}
+
+bool preparar_teselas(const lamina_t* lamina, mem_comp_t* mem_comp) {
+  teselas_t* teselas = &mem_comp->teselas;
+  const size_t hilos_filas = mem_comp->hilos_filas;
+  const size_t hilos_columnas = mem_comp->hilos_columnas;
+  // Cada bloque agrega a lo sumo una tesela incompleta
+  const size_t columnas_internas = lamina->n_columnas > 2
+      ? lamina->n_columnas - 2 : 0;
+  if (!reservar_teselas(teselas,
+      mem_comp->filas_internas / ALTO_TESELA + hilos_filas,
+      columnas_internas / ANCHO_TESELA + hilos_columnas)) {
+    return false;
+  }
+  // Los bloques de filas empiezan en los hilos 0, hilos_columnas... y los de
+  // columnas en los hilos 0 a hilos_columnas - 1
+  teselas->teselas_filas = 0;
+  for (size_t bloque = 0; bloque < hilos_filas; ++bloque) {
+    const mem_priv_t* primero = &mem_comp->mem_priv[bloque * hilos_columnas];
+    const size_t tesela_inicio = teselas->teselas_filas;
+    teselas->teselas_filas = cortar_tramo(teselas->cortes_filas,
+      teselas->teselas_filas, primero->fila_inicio, primero->fila_final,
+      ALTO_TESELA);
+    for (size_t columna = 0; columna < hilos_columnas; ++columna) {
+      mem_priv_t* mem_priv = &mem_comp->mem_priv[bloque * hilos_columnas
+        + columna];
+      mem_priv->tesela_fila_inicio = tesela_inicio;
+      mem_priv->tesela_fila_final = teselas->teselas_filas;
+    }
+  }
+  teselas->cortes_filas[teselas->teselas_filas] = lamina->n_filas - 1;
+  teselas->teselas_columnas = 0;
+  for (size_t bloque = 0; bloque < hilos_columnas; ++bloque) {
+    const mem_priv_t* primero = &mem_comp->mem_priv[bloque];
+    const size_t tesela_inicio = teselas->teselas_columnas;
+    teselas->teselas_columnas = cortar_tramo(teselas->cortes_columnas,
+      teselas->teselas_columnas, primero->columna_inicio,
+      primero->columna_final, ANCHO_TESELA);
+    for (size_t fila = 0; fila < hilos_filas; ++fila) {
+      mem_priv_t* mem_priv = &mem_comp->mem_priv[fila * hilos_columnas
+        + bloque];
+      mem_priv->tesela_columna_inicio = tesela_inicio;
+      mem_priv->tesela_columna_final = teselas->teselas_columnas;
+    }
+  }
+  teselas->cortes_columnas[teselas->teselas_columnas] = lamina->n_columnas - 1;
+  // Los hilos que no participan no tienen teselas
+  for (size_t num_hilo = mem_comp->hilos_totales;
+      num_hilo < mem_comp->equipo.hilos_totales; ++num_hilo) {
+    mem_priv_t* mem_priv = &mem_comp->mem_priv[num_hilo];
+    mem_priv->tesela_fila_inicio = mem_priv->tesela_fila_final = 0;
+    mem_priv->tesela_columna_inicio = mem_priv->tesela_columna_final = 0;
+  }
+  reiniciar_teselas(teselas);
+  return true;
+}
+
+// Indica si las filas [fila_inicio, fila_final) entre las columnas
+// [columna_inicio, columna_final) son idénticas bit a bit en el estado
+// actual y en el siguiente, en double o en float según --float-storage
+static bool rectangulo_igual(const mem_comp_t* mem_comp, size_t fila_inicio,
+    size_t fila_final, size_t columna_inicio, size_t columna_final) {
+  const lamina_t* lamina = mem_comp->lamina;
+  const bool simple = mem_comp->opciones->almacenamiento_simple != 0;
+  const size_t tamano = simple ? sizeof(float) : sizeof(double);
+  const size_t paso = simple ? mem_comp->paso_simple : lamina->paso;
+  const char* actual = simple ? (const char*) mem_comp->simple[0]
+      : (const char*) lamina->matriz;
+  const char* siguiente = simple ? (const char*) mem_comp->simple[1]
+      : (const char*) lamina->matriz2;
+  for (size_t fila = fila_inicio; fila < fila_final; ++fila) {
+    const size_t inicio = (fila * paso + columna_inicio) * tamano;
+    if (memcmp(actual + inicio, siguiente + inicio,
+        (columna_final - columna_inicio) * tamano) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Calcula las teselas [desde, hasta) de una fila de teselas con una sola
+// llamada al estencil, marca si cambiaron y retorna el mayor cambio. Con un
+// cambio mayor a 0 se marcan todas, aunque alguna no haya cambiado, lo que
+// solo hace que sus vecinas se calculen en la siguiente iteración
+static double calcular_tramo(mem_comp_t* mem_comp, size_t fila, size_t desde,
+    size_t hasta) {
+  teselas_t* teselas = &mem_comp->teselas;
+  const size_t fila_inicio = teselas->cortes_filas[fila];
+  const size_t fila_final = teselas->cortes_filas[fila + 1];
+  const double cambio_temp = calcular_rectangulo(mem_comp, fila_inicio,
+    fila_final, teselas->cortes_columnas[desde],
+    teselas->cortes_columnas[hasta]);
+  for (size_t columna = desde; columna < hasta; ++columna) {
+    // Un cambio de 0 no basta: -0.0 y 0.0 son distintos bit a bit
+    const bool cambio = cambio_temp > 0.0 || !rectangulo_igual(mem_comp,
+      fila_inicio, fila_final, teselas->cortes_columnas[columna],
+      teselas->cortes_columnas[columna + 1]);
+    marcar_tesela(teselas, fila, columna, cambio);
+  }
+  return cambio_temp;
+}
+
+void* calculo_teselas(void* mem) {
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  mem_comp_t* mem_comp = mem_priv->mem_comp;
+  teselas_t* teselas = &mem_comp->teselas;
+  double p_max_temp = 0.0;
+  for (size_t fila = mem_priv->tesela_fila_inicio;
+      fila < mem_priv->tesela_fila_final; ++fila) {
+    size_t columna = mem_priv->tesela_columna_inicio;
+    while (columna < mem_priv->tesela_columna_final) {
+      if (tesela_quieta(teselas, fila, columna)) {
+        marcar_tesela(teselas, fila, columna, false);
+        ++columna;
+        continue;
+      }
+      // Tramo de teselas seguidas que hay que calcular. Las de los extremos
+      // pueden estar en el frente de actividad y se calculan solas para
+      // saber con exactitud si cambiaron, las del medio en una sola llamada
+      size_t final = columna + 1;
+      while (final < mem_priv->tesela_columna_final
+          && !tesela_quieta(teselas, fila, final)) {
+        ++final;
+      }
+      double cambio_temp = calcular_tramo(mem_comp, fila, columna,
+        columna + 1);
+      if (final - columna > 2) {
+        const double medio = calcular_tramo(mem_comp, fila, columna + 1,
+          final - 1);
+        cambio_temp = medio > cambio_temp ? medio : cambio_temp;
+      }
+      if (final - columna > 1) {
+        const double ultima = calcular_tramo(mem_comp, fila, final - 1,
+          final);
+        cambio_temp = ultima > cambio_temp ? ultima : cambio_temp;
+      }
+      if (cambio_temp > p_max_temp) {
+        p_max_temp = cambio_temp;
+      }
+      columna = final;
+    }
+  }
+  mem_priv->p_max_temp = p_max_temp;
+  return NULL;
+}
+
+void* calculo_ciclico(void* mem) {
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  const mem_comp_t* mem_comp = mem_priv->mem_comp;
+  double p_max_temp = 0.0;
+  // Filas repartidas de forma cíclica, de hilos_totales en hilos_totales
+  for (size_t fila = mem_priv->fila_inicio; fila < mem_priv->fila_final;
+      fila += mem_comp->hilos_totales) {
+    const double cambio_temp = calcular_rectangulo(mem_comp, fila, fila + 1,
+      mem_priv->columna_inicio, mem_priv->columna_final);
+    if (cambio_temp > p_max_temp) {
+      p_max_temp = cambio_temp;
+    }
+  }
+  mem_priv->p_max_temp = p_max_temp;
+  return NULL;
+}
+
+// Toma el siguiente trozo de filas libres y retorna cuántas filas tiene,
+// 0 si ya no quedan
+static size_t tomar_trozo(mem_comp_t* mem_comp, size_t fila_final,
+    size_t* inicio) {
+  size_t actual = atomic_load_explicit(&mem_comp->fila_libre,
+    memory_order_relaxed);
+  size_t filas = 0;
+  do {
+    if (actual >= fila_final) {  // Fin de las filas internas
+      return 0;
+    }
+    // Trozo guiado: grande al inicio y cada vez menor
+    const size_t restantes = fila_final - actual;
+    filas = restantes / (2 * mem_comp->hilos_totales);
+    filas = filas < mem_comp->trozo_minimo ? mem_comp->trozo_minimo : filas;
+    filas = filas < restantes ? filas : restantes;
+    // Si otro hilo tomó filas antes, actual se actualiza y se reintenta
+  } while (!atomic_compare_exchange_weak_explicit(&mem_comp->fila_libre,
+      &actual, actual + filas, memory_order_relaxed, memory_order_relaxed));
+  *inicio = actual;
+  return filas;
+}
+
+void* calculo_dinamico(void* mem) {
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  mem_comp_t* mem_comp = mem_priv->mem_comp;
+  double p_max_temp = 0.0;
+  // Mapeo dinámico: cada hilo toma un trozo de filas disponible
+  size_t fila = 0;
+  size_t filas = 0;
+  while ((filas = tomar_trozo(mem_comp, mem_priv->fila_final, &fila)) > 0) {
+    const double cambio_temp = calcular_rectangulo(mem_comp, fila,
+      fila + filas, mem_priv->columna_inicio, mem_priv->columna_final);
+    if (cambio_temp > p_max_temp) {
+      p_max_temp = cambio_temp;
+    }
+  }
+  mem_priv->p_max_temp = p_max_temp;
+  return NULL;
+}
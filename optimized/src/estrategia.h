@@ -0,0 +1,120 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef ESTRATEGIA_H
+#define ESTRATEGIA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "simul.h"
+/**
+ * @brief Celdas mínimas de cada trozo de filas de la estrategia dynamic
+ */
+#define CELDAS_TROZO 4096
+/**
+ * @brief Forma de repartir el cálculo de cada iteración entre los hilos.
+ *
+ * La carga, la reducción del máximo, el equilibrio y el reporte son los
+ * mismos para todas; solo cambia qué celdas calcula cada hilo. Todas
+ * producen los mismos resultados bit a bit.
+ */
+struct estrategia {
+  /**
+   * @brief Nombre que se usa en --strategy
+   */
+  const char* nombre;
+  /**
+   * @brief Reparte la lámina entre a lo sumo hilos hilos. Debe dejar
+   * hilos_totales y las filas y columnas de cada mem_priv del equipo
+   */
+  void (*repartir)(const lamina_t* lamina, mem_comp_t* mem_comp,
+    size_t hilos);
+  /**
+   * @brief Rutina de cada hilo en una iteración, deja su mayor cambio en
+   * p_max_temp
+   */
+  void* (*calcular)(void* mem);
+  /**
+   * @brief Indica si admite --time-block, que necesita bloques de filas
+   * completas
+   */
+  bool bloques_temporales;
+  /**
+   * @brief Indica si admite --skip-quiescent, que necesita que cada hilo
+   * calcule siempre el mismo rectángulo
+   */
+  bool teselas;
+};
+/**
+ * @brief Busca una estrategia por su nombre.
+ *
+ * @param nombre serial, static-block, cyclic o dynamic.
+ * @return La estrategia o NULL si no existe.
+ */
+const estrategia_t* buscar_estrategia(const char* nombre);
+/**
+ * @brief Elige la estrategia de una lámina y cuántos hilos la calculan.
+ *
+ * Si no se pidió una en las opciones (--strategy=auto), el modelo de costo
+ * del equipo elige los hilos con elegir_hilos(): con uno la lámina usa
+ * serial, porque despertar al equipo cuesta más que calcularla, y con más
+ * static-block. Si se pidió una, se usan todos los hilos que admite.
+ *
+ * @param mem_comp Memoria compartida con las opciones y el costo medido.
+ * @param lamina Lámina que se va a simular.
+ * @param hilos Máximo de hilos que admite la lámina, al retornar los que
+ * se le reparten.
+ * @return Estrategia de la lámina.
+ */
+const estrategia_t* elegir_estrategia(const mem_comp_t* mem_comp,
+  const lamina_t* lamina, size_t* hilos);
+/**
+ * @brief Divide los bloques de los hilos en teselas y marca todas como
+ * cambiadas.
+ *
+ * Se llama después de repartir la lámina. Cada bloque se corta en teselas de
+ * a lo sumo ALTO_TESELA por ANCHO_TESELA celdas, así ninguna tesela queda
+ * entre dos hilos.
+ *
+ * @param lamina Lámina que se va a simular.
+ * @param mem_comp Memoria compartida con la lámina ya repartida.
+ * @return true si se prepararon, false si no hay memoria.
+ */
+bool preparar_teselas(const lamina_t* lamina, mem_comp_t* mem_comp);
+/**
+ * @brief Rutina de static-block y serial con --skip-quiescent: calcula las
+ * teselas del bloque del hilo que pueden cambiar.
+ *
+ * Las teselas quietas no se tocan. Una tesela calculada sin cambio mayor a
+ * 0 se compara bit a bit con su estado anterior para saber si cambió.
+ *
+ * @param mem Puntero a la estructura de memoria privada del hilo
+ * @return void* Hay que retornar algo, en este caso NULL
+ */
+void* calculo_teselas(void* mem);
+/**
+ * @brief Rutina de static-block y serial: calcula el bloque del hilo.
+ *
+ * El bloque se recorre por franjas de ancho_franja columnas.
+ *
+ * @param mem Puntero a la estructura de memoria privada del hilo
+ * @return void* Hay que retornar algo, en este caso NULL
+ */
+void* calculo_matriz(void* mem);
+/**
+ * @brief Rutina de cyclic: calcula las filas fila_inicio, fila_inicio +
+ * hilos_totales, fila_inicio + 2 * hilos_totales...
+ *
+ * @param mem Puntero a la estructura de memoria privada del hilo
+ * @return void* Hay que retornar algo, en este caso NULL
+ */
+void* calculo_ciclico(void* mem);
+/**
+ * @brief Rutina de dynamic: toma trozos de filas de fila_libre hasta que se
+ * acaben.
+ *
+ * Los trozos son guiados, grandes al inicio y cada vez menores, con al
+ * menos CELDAS_TROZO celdas.
+ *
+ * @param mem Puntero a la estructura de memoria privada del hilo
+ * @return void* Hay que retornar algo, en este caso NULL
+ */
+void* calculo_dinamico(void* mem);
+#endif
@@ -0,0 +1,174 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include "formato.h"
+
+/**
+ * @brief Tramo de filas que carga un hilo
+ */
+typedef struct {
+  const mapeo_lamina_t* mapeo;
+  double* matriz;
+  size_t paso;
+  size_t fila_inicio;
+  size_t fila_fin;
+} tramo_carga_t;
+
+/**
+ * @brief Tramo de bloques que comprime un hilo
+ */
+typedef struct {
+  const double* matriz;
+  size_t paso;
+  size_t n_filas;
+  size_t n_columnas;
+  size_t filas_bloque;
+  /**
+   * @brief Bloques comprimidos de toda la lámina, el hilo llena los suyos
+   */
+  uint8_t** bloques;
+  /**
+   * @brief Bytes de cada bloque comprimido
+   */
+  size_t* bytes;
+  size_t bloque_inicio;
+  size_t bloque_fin;
+} tramo_compresion_t;
+
+// Hilos que participan, al menos 1 y a lo sumo uno por unidad de trabajo
+static size_t hilos_tramos(const equipo_t* equipo, size_t hilos,
+    size_t unidades) {
+  if (equipo == NULL || hilos == 0) {
+    return 1;
+  }
+  hilos = hilos < equipo->hilos_totales ? hilos : equipo->hilos_totales;
+  return hilos < unidades ? hilos : unidades;
+}
+
+// Rutina de cada hilo de la carga
+static void* cargar_tramo(void* argumento) {
+  tramo_carga_t* tramo = (tramo_carga_t*) argumento;
+  copiar_filas(tramo->mapeo, tramo->matriz, tramo->paso, tramo->fila_inicio,
+    tramo->fila_fin);
+  return NULL;
+}
+
+// Rutina de cada hilo de la compresión. Si falta memoria deja el bloque en
+// NULL y sigue con los demás
+static void* comprimir_tramo(void* argumento) {
+  tramo_compresion_t* tramo = (tramo_compresion_t*) argumento;
+  for (size_t bloque = tramo->bloque_inicio; bloque < tramo->bloque_fin;
+      ++bloque) {
+    const size_t primera = bloque * tramo->filas_bloque;
+    const size_t filas = tramo->n_filas - primera < tramo->filas_bloque
+        ? tramo->n_filas - primera : tramo->filas_bloque;
+    uint8_t* destino = (uint8_t*) malloc(cota_bloque_comprimido(filas
+      * tramo->n_columnas));
+    if (destino == NULL) {
+      tramo->bloques[bloque] = NULL;
+      continue;
+    }
+    tramo->bytes[bloque] = comprimir_bloque(tramo->matriz + primera
+      * tramo->paso, tramo->paso, filas, tramo->n_columnas, destino);
+    // Solo se conserva lo que ocupa comprimido
+    uint8_t* ajustado = (uint8_t*) realloc(destino, tramo->bytes[bloque]
+      ? tramo->bytes[bloque] : 1);
+    tramo->bloques[bloque] = ajustado ? ajustado : destino;
+  }
+  return NULL;
+}
+
+bool cargar_matriz(const char* ruta, size_t* n_filas, size_t* n_columnas,
+    size_t* paso, double** matriz, arena_t* arena, equipo_t* equipo,
+    size_t hilos) {
+  mapeo_lamina_t mapeo;
+  if (!abrir_lamina(ruta, &mapeo)) {
+    return false;
+  }
+  *n_filas = mapeo.n_filas;
+  *n_columnas = mapeo.n_columnas;
+  *paso = calcular_paso(mapeo.n_columnas);
+  *matriz = tomar_matriz(arena, mapeo.n_filas, *paso);
+  if (*matriz == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", ruta);
+    cerrar_lamina(&mapeo);
+    return false;
+  }
+  // Los tramos se reparten en bloques enteros, o en filas si es cruda
+  const size_t filas_unidad = mapeo.filas_bloque ? mapeo.filas_bloque : 1;
+  const size_t unidades = (mapeo.n_filas + filas_unidad - 1) / filas_unidad;
+  hilos = hilos_tramos(equipo, hilos, unidades);
+  tramo_carga_t* tramos = hilos > 1
+      ? (tramo_carga_t*) malloc(hilos * sizeof(tramo_carga_t)) : NULL;
+  if (tramos == NULL) {
+    copiar_filas(&mapeo, *matriz, *paso, 0, mapeo.n_filas);
+  } else {
+    for (size_t k = 0; k < hilos; ++k) {
+      const size_t inicio = k * unidades / hilos * filas_unidad;
+      const size_t fin = (k + 1) * unidades / hilos * filas_unidad;
+      tramos[k].mapeo = &mapeo;
+      tramos[k].matriz = *matriz;
+      tramos[k].paso = *paso;
+      tramos[k].fila_inicio = inicio;
+      tramos[k].fila_fin = fin < mapeo.n_filas ? fin : mapeo.n_filas;
+    }
+    despachar_equipo(equipo, cargar_tramo, tramos, sizeof(tramo_carga_t),
+      hilos);
+    free(tramos);
+  }
+  cerrar_lamina(&mapeo);
+  return true;
+}
+
+bool escribir_lamina(const char* ruta, size_t n_filas, size_t n_columnas,
+    size_t paso, const double* matriz, bool comprimir, equipo_t* equipo,
+    size_t hilos) {
+  if (!comprimir) {
+    return escribir_matriz(ruta, n_filas, n_columnas, paso, matriz);
+  }
+  const size_t filas_bloque = filas_bloque_comprimido(n_columnas);
+  const size_t cantidad = (n_filas + filas_bloque - 1) / filas_bloque;
+  uint8_t** bloques = (uint8_t**) calloc(cantidad, sizeof(uint8_t*));
+  size_t* bytes = (size_t*) calloc(cantidad, sizeof(size_t));
+  hilos = hilos_tramos(equipo, hilos, cantidad);
+  tramo_compresion_t* tramos = (tramo_compresion_t*) malloc(hilos
+    * sizeof(tramo_compresion_t));
+  if (bloques == NULL || bytes == NULL || tramos == NULL) {
+    fprintf(stderr, "Error: no hay memoria para comprimir %s\n", ruta);
+    free(bloques);
+    free(bytes);
+    free(tramos);
+    return false;
+  }
+  for (size_t k = 0; k < hilos; ++k) {
+    tramos[k].matriz = matriz;
+    tramos[k].paso = paso;
+    tramos[k].n_filas = n_filas;
+    tramos[k].n_columnas = n_columnas;
+    tramos[k].filas_bloque = filas_bloque;
+    tramos[k].bloques = bloques;
+    tramos[k].bytes = bytes;
+    tramos[k].bloque_inicio = k * cantidad / hilos;
+    tramos[k].bloque_fin = (k + 1) * cantidad / hilos;
+  }
+  if (hilos > 1) {
+    despachar_equipo(equipo, comprimir_tramo, tramos,
+      sizeof(tramo_compresion_t), hilos);
+  } else {
+    comprimir_tramo(tramos);
+  }
+  bool correcto = true;
+  for (size_t bloque = 0; bloque < cantidad; ++bloque) {
+    correcto = correcto && bloques[bloque] != NULL;
+  }
+  if (correcto) {
+    correcto = escribir_comprimida(ruta, n_filas, n_columnas, bloques, bytes);
+  } else {
+    fprintf(stderr, "Error: no hay memoria para comprimir %s\n", ruta);
+  }
+  for (size_t bloque = 0; bloque < cantidad; ++bloque) {
+    free(bloques[bloque]);
+  }
+  free(bloques);
+  free(bytes);
+  free(tramos);
+  return correcto;
+}
@@ -0,0 +1,54 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef FORMATO_H
+#define FORMATO_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "compresion.h"
+#include "equipo.h"
+#include "miscelaneos.h"
+/**
+ * @brief Carga la matriz de una lámina cruda o comprimida repartiendo las
+ * filas entre los hilos del equipo.
+ *
+ * Igual que mapear_matriz(), pero cada hilo copia o decodifica un tramo de
+ * filas y es el primero en tocar sus páginas. En una lámina comprimida los
+ * tramos empiezan en el inicio de un bloque, así ningún bloque se
+ * decodifica dos veces.
+ *
+ * @param ruta Ruta del archivo de la lámina.
+ * @param n_filas Número de filas leído del encabezado.
+ * @param n_columnas Número de columnas leído del encabezado.
+ * @param paso Paso de las filas de la matriz creada.
+ * @param matriz Matriz con el estado inicial.
+ * @param arena Arena de donde sale la matriz, o NULL.
+ * @param equipo Equipo estacionado que hace la carga, NULL para hacerla en
+ * el hilo que invoca.
+ * @param hilos Hilos del equipo que participan.
+ * @return true si se cargó la lámina, false en caso de error.
+ */
+bool cargar_matriz(const char* ruta, size_t* n_filas, size_t* n_columnas,
+  size_t* paso, double** matriz, arena_t* arena, equipo_t* equipo,
+  size_t hilos);
+/**
+ * @brief Escribe una lámina resultante, cruda o comprimida.
+ *
+ * La cruda se escribe con escribir_matriz(). La comprimida reparte sus
+ * bloques entre los hilos del equipo, cada uno los comprime en su propia
+ * memoria, y se escribe con escribir_comprimida().
+ *
+ * @param ruta Ruta del archivo a crear o sobrescribir.
+ * @param n_filas Número de filas de la matriz.
+ * @param n_columnas Número de columnas de la matriz.
+ * @param paso Paso de las filas de la matriz.
+ * @param matriz Matriz a escribir.
+ * @param comprimir true para escribirla comprimida (--plate-format).
+ * @param equipo Equipo estacionado que comprime, NULL para comprimir en el
+ * hilo que invoca.
+ * @param hilos Hilos del equipo que participan.
+ * @return true si se escribió completa, false en caso de error.
+ */
+bool escribir_lamina(const char* ruta, size_t n_filas, size_t n_columnas,
+  size_t paso, const double* matriz, bool comprimir, equipo_t* equipo,
+  size_t hilos);
+#endif
@@ -0,0 +1,123 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include "grupo.h"
+#include "equilibrio.h"
+
+// Indica si dos líneas solo difieren en epsilon
+static bool mismo_grupo(const lamina_t* primera, const lamina_t* otra) {
+  return strcmp(primera->nombre, otra->nombre) == 0
+      && primera->tiempo == otra->tiempo
+      && primera->difusividad == otra->difusividad
+      && primera->distancia == otra->distancia;
+}
+
+// Agrega una línea al final del grupo
+static bool agregar_linea(grupo_t* grupo, const lamina_t* linea) {
+  if (grupo->cantidad == grupo->capacidad) {
+    const size_t capacidad = grupo->capacidad ? 2 * grupo->capacidad : 16;
+    lamina_t* lineas = (lamina_t*) realloc(grupo->lineas,
+      capacidad * sizeof(lamina_t));
+    if (lineas == NULL) {
+      fprintf(stderr, "Error: no hay memoria para el grupo de %s\n",
+        linea->nombre);
+      return false;
+    }
+    grupo->lineas = lineas;
+    grupo->capacidad = capacidad;
+  }
+  grupo->lineas[grupo->cantidad++] = *linea;
+  return true;
+}
+
+void iniciar_lector(lector_t* lector, archivos_t* archivos) {
+  lector->archivo_trabajo = archivos->archivo_trabajo;
+  lector->prefijo_ruta_trabajo = archivos->prefijo_ruta_trabajo;
+  lector->hay_proxima = false;
+  lector->fin = false;
+}
+
+bool leer_grupo(lector_t* lector, grupo_t* grupo, char* ruta_lamina,
+    bool agrupar) {
+  grupo->cantidad = 0;
+  grupo->max_temp = DBL_MAX;
+  if (!lector->hay_proxima) {
+    lector->hay_proxima = !lector->fin && leer_datos_lamina(&lector->proxima,
+      lector->archivo_trabajo, lector->prefijo_ruta_trabajo,
+      lector->ruta_proxima);
+    if (!lector->hay_proxima) {
+      lector->fin = true;
+      return false;
+    }
+  }
+  // La línea de anticipo inicia el grupo
+  lector->hay_proxima = false;
+  if (!agregar_linea(grupo, &lector->proxima)) {
+    lector->fin = true;
+    return false;
+  }
+  strcpy(ruta_lamina, lector->ruta_proxima);
+  // Se agregan líneas mientras sean del mismo grupo, la primera que no lo
+  // sea queda de anticipo para el siguiente
+  while (agrupar && !lector->fin) {
+    if (!leer_datos_lamina(&lector->proxima, lector->archivo_trabajo,
+        lector->prefijo_ruta_trabajo, lector->ruta_proxima)) {
+      lector->fin = true;
+    } else if (!mismo_grupo(&grupo->lineas[0], &lector->proxima)) {
+      lector->hay_proxima = true;
+      break;
+    } else if (!agregar_linea(grupo, &lector->proxima)) {
+      lector->fin = true;
+    }
+  }
+  return true;
+}
+
+int procesar_grupo(grupo_t* grupo, mem_comp_t* mem_comp,
+    entregar_linea_t entregar, void* contexto) {
+  // Orden de las líneas de mayor a menor epsilon, las de igual epsilon en
+  // el orden del archivo
+  size_t* orden = (size_t*) malloc(grupo->cantidad * sizeof(size_t));
+  if (orden == NULL) {
+    fprintf(stderr, "Error: no hay memoria para el grupo de %s\n",
+      grupo->lineas[0].nombre);
+    return EXIT_FAILURE;
+  }
+  for (size_t linea = 0; linea < grupo->cantidad; ++linea) {
+    size_t posicion = linea;
+    while (posicion > 0 && grupo->lineas[orden[posicion - 1]].epsilon
+        < grupo->lineas[linea].epsilon) {
+      orden[posicion] = orden[posicion - 1];
+      --posicion;
+    }
+    orden[posicion] = linea;
+  }
+  // Una sola simulación, cada epsilon continúa desde el anterior
+  lamina_t* lamina = mem_comp->lamina;
+  const bool equilibrio = mem_comp->opciones->equilibrio != 0;
+  const size_t pasos_bloque = equilibrio ? 1
+      : preparar_lamina(lamina, mem_comp);
+  mem_comp->max_temp = grupo->max_temp;
+  int error = pasos_bloque ? EXIT_SUCCESS : EXIT_FAILURE;
+  for (size_t k = 0; k < grupo->cantidad && error == EXIT_SUCCESS; ++k) {
+    lamina_t* linea = &grupo->lineas[orden[k]];
+    if (linea->iteraciones > 0) {
+      continue;
+    }
+    lamina->epsilon = linea->epsilon;
+    error = equilibrio ? resolver_equilibrio(lamina)
+        : avanzar_lamina(lamina, mem_comp, pasos_bloque);
+    if (error == EXIT_SUCCESS) {
+      linea->iteraciones = lamina->iteraciones;
+      linea->residuo = lamina->residuo;
+      error = entregar(contexto, orden[k], lamina);
+    }
+  }
+  free(orden);
+  return error;
+}
+
+void liberar_grupo(grupo_t* grupo) {
+  free(grupo->lineas);
+  grupo->lineas = NULL;
+  grupo->cantidad = 0;
+  grupo->capacidad = 0;
+}
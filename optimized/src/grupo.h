@@ -0,0 +1,119 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef GRUPO_H
+#define GRUPO_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "simul.h"
+/**
+ * @brief Lee el archivo de trabajo por grupos, con una línea de anticipo
+ */
+typedef struct {
+  /**
+   * @brief Archivo de trabajo
+   */
+  FILE* archivo_trabajo;
+  /**
+   * @brief Prefijo de ruta donde estan los datos
+   */
+  char* prefijo_ruta_trabajo;
+  /**
+   * @brief Línea leída que pertenece al grupo siguiente
+   */
+  lamina_t proxima;
+  /**
+   * @brief Ruta de la lámina de proxima
+   */
+  char ruta_proxima[BUFFER_MAX];
+  /**
+   * @brief Indica si proxima tiene una línea
+   */
+  bool hay_proxima;
+  /**
+   * @brief Indica que el archivo de trabajo ya no tiene líneas válidas
+   */
+  bool fin;
+} lector_t;
+/**
+ * @brief Líneas consecutivas del archivo de trabajo con la misma lámina,
+ * tiempo, difusividad y distancia, que solo difieren en epsilon.
+ *
+ * Las iteraciones de cada epsilon son las de la primera iteración en que el
+ * mayor cambio no lo supera, así que basta simular una vez hasta el menor
+ * epsilon y tomar cada resultado al pasar por su iteración.
+ */
+typedef struct {
+  /**
+   * @brief Datos de cada línea en el orden del archivo, sin matrices.
+   * Las iteraciones se llenan al simular el grupo
+   */
+  lamina_t* lineas;
+  /**
+   * @brief Cantidad de líneas del grupo
+   */
+  size_t cantidad;
+  /**
+   * @brief Líneas reservadas en lineas
+   */
+  size_t capacidad;
+  /**
+   * @brief Mayor cambio de la última iteración al iniciar el grupo, DBL_MAX
+   * salvo que se reanude de un punto de control
+   */
+  double max_temp;
+} grupo_t;
+/**
+ * @brief Rutina que recibe cada línea del grupo cuando la lámina alcanza su
+ * epsilon.
+ *
+ * La lámina tiene los datos de la línea y el estado de equilibrio en
+ * matriz, que solo es válido durante la llamada.
+ *
+ * @param contexto Contexto que se pasó a procesar_grupo().
+ * @param linea Posición de la línea en el grupo.
+ * @param lamina Lámina en equilibrio para la línea.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+typedef int (*entregar_linea_t)(void* contexto, size_t linea,
+  const lamina_t* lamina);
+/**
+ * @brief Inicializa un lector sobre el archivo de trabajo.
+ *
+ * @param lector Lector a inicializar.
+ * @param archivos Archivos de la simulación.
+ */
+void iniciar_lector(lector_t* lector, archivos_t* archivos);
+/**
+ * @brief Lee el siguiente grupo de líneas del archivo de trabajo.
+ *
+ * @param lector Lector creado con iniciar_lector().
+ * @param grupo Grupo donde quedan las líneas, se reutiliza entre llamadas.
+ * @param ruta_lamina Ruta de la lámina del grupo.
+ * @param agrupar Si es falso cada grupo tiene una sola línea.
+ * @return true si se leyó un grupo, false si ya no hay líneas.
+ */
+bool leer_grupo(lector_t* lector, grupo_t* grupo, char* ruta_lamina,
+  bool agrupar);
+/**
+ * @brief Simula la lámina una sola vez para todas las líneas del grupo.
+ *
+ * Los epsilon se recorren de mayor a menor y la simulación continúa desde
+ * el equilibrio del anterior. Cada línea se entrega en la primera iteración
+ * en que el mayor cambio no supera su epsilon, con los mismos resultados que
+ * si se simulara por separado. Las líneas que ya tienen iteraciones, porque
+ * se entregaron antes del punto de control del que se reanuda, se omiten.
+ *
+ * @param grupo Grupo leído con leer_grupo().
+ * @param mem_comp Memoria compartida, su lámina ya tiene las matrices.
+ * @param entregar Rutina que recibe cada línea al alcanzar su epsilon.
+ * @param contexto Primer argumento de entregar.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int procesar_grupo(grupo_t* grupo, mem_comp_t* mem_comp,
+  entregar_linea_t entregar, void* contexto);
+/**
+ * @brief Libera las líneas de un grupo.
+ *
+ * @param grupo Grupo a liberar.
+ */
+void liberar_grupo(grupo_t* grupo);
+#endif
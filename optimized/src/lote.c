@@ -0,0 +1,389 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <stdint.h>
+#include "lote.h"
+
+bool lamina_pequena(const lamina_t* lamina) {
+  const size_t celdas = lamina->n_filas * lamina->n_columnas;
+  return celdas > 0 && 2 * celdas * CARRILES_LOTE * sizeof(double)
+      <= tamano_cache_l2() / 2;
+}
+
+// Agrega las líneas de un grupo a la tanda, todas con el estado inicial de
+// lamina
+static bool agregar_grupo(tanda_t* tanda, const grupo_t* grupo,
+    const lamina_t* lamina) {
+  const size_t cantidad = tanda->cantidad + grupo->cantidad;
+  if (cantidad > tanda->capacidad) {
+    size_t capacidad = tanda->capacidad ? 2 * tanda->capacidad : 64;
+    while (capacidad < cantidad) {
+      capacidad *= 2;
+    }
+    lamina_t* lineas = (lamina_t*) realloc(tanda->lineas,
+      capacidad * sizeof(lamina_t));
+    if (lineas) {
+      tanda->lineas = lineas;
+    }
+    size_t* orden = (size_t*) realloc(tanda->orden,
+      capacidad * sizeof(size_t));
+    if (orden) {
+      tanda->orden = orden;
+    }
+    if (lineas == NULL || orden == NULL) {
+      fprintf(stderr, "Error: no hay memoria para la tanda de %s\n",
+        lamina->nombre);
+      return false;
+    }
+    tanda->capacidad = capacidad;
+  }
+  if (tanda->cantidad_iniciales == tanda->capacidad_iniciales) {
+    const size_t capacidad = tanda->capacidad_iniciales
+        ? 2 * tanda->capacidad_iniciales : 16;
+    double** iniciales = (double**) realloc(tanda->iniciales,
+      capacidad * sizeof(double*));
+    if (iniciales == NULL) {
+      fprintf(stderr, "Error: no hay memoria para la tanda de %s\n",
+        lamina->nombre);
+      return false;
+    }
+    tanda->iniciales = iniciales;
+    tanda->capacidad_iniciales = capacidad;
+  }
+  tanda->iniciales[tanda->cantidad_iniciales++] = lamina->matriz;
+  for (size_t linea = 0; linea < grupo->cantidad; ++linea) {
+    lamina_t* destino = &tanda->lineas[tanda->cantidad++];
+    *destino = grupo->lineas[linea];
+    destino->n_filas = lamina->n_filas;
+    destino->n_columnas = lamina->n_columnas;
+    destino->paso = lamina->paso;
+    destino->matriz = lamina->matriz;
+    destino->matriz2 = NULL;
+  }
+  return true;
+}
+
+// Devuelve los estados iniciales a la arena y deja la tanda vacía
+static void vaciar_tanda(tanda_t* tanda, arena_t* arena) {
+  for (size_t inicial = 0; inicial < tanda->cantidad_iniciales; ++inicial) {
+    devolver_matriz(arena, tanda->iniciales[inicial]);
+  }
+  tanda->cantidad_iniciales = 0;
+  tanda->cantidad = 0;
+}
+
+// Indica si la lámina de una línea va antes que la de otra en la tanda:
+// por filas y luego por columnas
+static bool forma_menor(const lamina_t* linea, const lamina_t* otra) {
+  return linea->n_filas < otra->n_filas || (linea->n_filas == otra->n_filas
+      && linea->n_columnas < otra->n_columnas);
+}
+
+// Ordena las líneas por forma. Por inserción, casi lineal cuando las
+// láminas de igual forma son consecutivas, que es el caso común
+static void ordenar_tanda(tanda_t* tanda) {
+  for (size_t linea = 0; linea < tanda->cantidad; ++linea) {
+    size_t posicion = linea;
+    while (posicion > 0 && forma_menor(&tanda->lineas[linea],
+        &tanda->lineas[tanda->orden[posicion - 1]])) {
+      tanda->orden[posicion] = tanda->orden[posicion - 1];
+      --posicion;
+    }
+    tanda->orden[posicion] = linea;
+  }
+}
+
+// Prepara los carriles para láminas de n_filas por n_columnas, todos en
+// cero
+static bool preparar_carriles(lote_t* lote, size_t n_filas,
+    size_t n_columnas) {
+  const size_t celdas = n_filas * n_columnas;
+  if (lote->capacidad < celdas * CARRILES_LOTE) {
+    // Cada celda ocupa una fila de CARRILES_LOTE doubles, una línea de caché
+    for (size_t k = 0; k < 2; ++k) {
+      liberar_matriz(lote->matrices[k]);
+      lote->matrices[k] = reservar_matriz(celdas, CARRILES_LOTE);
+    }
+    lote->capacidad = celdas * CARRILES_LOTE;
+    if (lote->matrices[0] == NULL || lote->matrices[1] == NULL) {
+      fprintf(stderr, "Error: no hay memoria para los carriles\n");
+      liberar_matriz(lote->matrices[0]);
+      liberar_matriz(lote->matrices[1]);
+      lote->matrices[0] = lote->matrices[1] = NULL;
+      lote->capacidad = 0;
+      return false;
+    }
+  }
+  for (size_t k = 0; k < 2; ++k) {
+    memset(lote->matrices[k], 0, celdas * CARRILES_LOTE * sizeof(double));
+  }
+  lote->n_filas = n_filas;
+  lote->n_columnas = n_columnas;
+  return true;
+}
+
+// Copia el estado inicial de una línea a las dos matrices de un carril. Los
+// bordes no cambian, así que ambas los necesitan
+static void llenar_carril(lote_t* lote, size_t carril, size_t linea) {
+  const lamina_t* lamina = &lote->tanda->lineas[linea];
+  for (size_t i = 0; i < lamina->n_filas; ++i) {
+    const double* fila = lamina->matriz + i * lamina->paso;
+    for (size_t j = 0; j < lamina->n_columnas; ++j) {
+      const size_t celda = (i * lamina->n_columnas + j) * CARRILES_LOTE
+          + carril;
+      lote->matrices[0][celda] = fila[j];
+      lote->matrices[1][celda] = fila[j];
+    }
+  }
+  lote->lineas[carril] = linea;
+  lote->coeficientes[carril] = (lamina->tiempo * lamina->difusividad)
+      /(lamina->distancia * lamina->distancia);
+  lote->iteraciones[carril] = 0;
+}
+
+// Copia el estado actual de un carril a la lámina resultante de su línea y
+// lo deja libre y en cero, así no calcula valores que nadie usa
+static void vaciar_carril(lote_t* lote, size_t carril) {
+  lamina_t* lamina = &lote->tanda->lineas[lote->lineas[carril]];
+  lamina->iteraciones = lote->iteraciones[carril];
+  for (size_t i = 0; i < lamina->n_filas; ++i) {
+    double* fila = lamina->matriz2 + i * lamina->paso;
+    for (size_t j = 0; j < lamina->n_columnas; ++j) {
+      const size_t celda = (i * lamina->n_columnas + j) * CARRILES_LOTE
+          + carril;
+      fila[j] = lote->matrices[0][celda];
+      lote->matrices[0][celda] = 0.0;
+      lote->matrices[1][celda] = 0.0;
+    }
+  }
+  lote->lineas[carril] = SIZE_MAX;
+  lote->coeficientes[carril] = 0.0;
+}
+
+// Rutina de cada hilo: llena sus carriles libres con las líneas de la tanda
+// y los avanza juntos hasta que no queden líneas
+static void* simular_lote(void* datos) {
+  lote_t* lote = (lote_t*) datos;
+  tanda_t* tanda = lote->tanda;
+  for (size_t carril = 0; carril < CARRILES_LOTE; ++carril) {
+    lote->lineas[carril] = SIZE_MAX;
+    lote->coeficientes[carril] = 0.0;
+  }
+  // La primera línea prepara los carriles para su forma
+  lote->n_filas = lote->n_columnas = 0;
+  lote->error = EXIT_SUCCESS;
+  size_t ocupados = 0;
+  // Línea tomada de la tanda que aún no tiene carril
+  size_t espera = SIZE_MAX;
+  bool hay_lineas = true;
+  while (true) {
+    for (size_t carril = 0; carril < CARRILES_LOTE && hay_lineas; ++carril) {
+      if (lote->lineas[carril] != SIZE_MAX) {
+        continue;
+      }
+      if (espera == SIZE_MAX) {
+        const size_t posicion = atomic_fetch_add_explicit(&tanda->siguiente,
+          1, memory_order_relaxed);
+        if (posicion >= tanda->cantidad) {
+          hay_lineas = false;
+          break;
+        }
+        espera = tanda->orden[posicion];
+      }
+      const lamina_t* lamina = &tanda->lineas[espera];
+      if (lamina->n_filas != lote->n_filas
+          || lamina->n_columnas != lote->n_columnas) {
+        // Una lámina de otra forma espera a que terminen los carriles
+        // ocupados
+        if (ocupados > 0) {
+          break;
+        }
+        if (!preparar_carriles(lote, lamina->n_filas, lamina->n_columnas)) {
+          lote->error = EXIT_FAILURE;
+          return NULL;
+        }
+      }
+      llenar_carril(lote, carril, espera);
+      espera = SIZE_MAX;
+      ++ocupados;
+    }
+    if (ocupados == 0) {
+      break;
+    }
+    calcular_lote(lote->matrices[0], lote->matrices[1], lote->n_filas,
+      lote->n_columnas, lote->coeficientes, lote->maximos);
+    intercambiar_matriz(&lote->matrices[0], &lote->matrices[1]);
+    // Cada carril termina en la primera iteración en que su mayor cambio no
+    // supera su epsilon, igual que en avanzar_lamina()
+    for (size_t carril = 0; carril < CARRILES_LOTE; ++carril) {
+      if (lote->lineas[carril] == SIZE_MAX) {
+        continue;
+      }
+      ++lote->iteraciones[carril];
+      if (!(lote->maximos[carril]
+          > tanda->lineas[lote->lineas[carril]].epsilon)) {
+        vaciar_carril(lote, carril);
+        --ocupados;
+      }
+    }
+  }
+  return NULL;
+}
+
+// Simula las líneas de la tanda en los carriles de los hilos del equipo,
+// guarda las láminas resultantes y reporta las filas en el orden del archivo
+static int simular_tanda(tanda_t* tanda, lote_t* lotes, mem_comp_t* mem_comp,
+    archivos_t* archivos, arena_t* arena) {
+  if (tanda->cantidad == 0) {
+    return EXIT_SUCCESS;
+  }
+  // Las láminas resultantes comparten un solo bloque, cada una con el paso
+  // de su estado inicial
+  size_t total = 0;
+  for (size_t linea = 0; linea < tanda->cantidad; ++linea) {
+    total += tanda->lineas[linea].n_filas * tanda->lineas[linea].paso;
+  }
+  if (tanda->capacidad_resultados < total) {
+    liberar_matriz(tanda->resultados);
+    tanda->resultados = reservar_matriz(1, total);
+    tanda->capacidad_resultados = tanda->resultados ? total : 0;
+  }
+  if (tanda->resultados == NULL) {
+    fprintf(stderr, "Error: no hay memoria para los resultados de la "
+      "tanda de %s\n", tanda->lineas[0].nombre);
+    vaciar_tanda(tanda, arena);
+    return EXIT_FAILURE;
+  }
+  double* resultado = tanda->resultados;
+  for (size_t linea = 0; linea < tanda->cantidad; ++linea) {
+    tanda->lineas[linea].matriz2 = resultado;
+    resultado += tanda->lineas[linea].n_filas * tanda->lineas[linea].paso;
+  }
+  ordenar_tanda(tanda);
+  atomic_store_explicit(&tanda->siguiente, 0, memory_order_relaxed);
+  // Un hilo por cada CARRILES_LOTE líneas, a lo sumo el equipo. El despacho
+  // ordena la escritura de siguiente
+  size_t hilos = (tanda->cantidad + CARRILES_LOTE - 1) / CARRILES_LOTE;
+  hilos = hilos < mem_comp->equipo.hilos_totales ? hilos
+      : mem_comp->equipo.hilos_totales;
+  if (hilos <= 1) {
+    simular_lote(&lotes[0]);
+  } else {
+    despachar_equipo(&mem_comp->equipo, simular_lote, lotes, sizeof(lote_t),
+      hilos);
+  }
+  int error = EXIT_SUCCESS;
+  for (size_t num_hilo = 0; num_hilo < hilos; ++num_hilo) {
+    if (lotes[num_hilo].error != EXIT_SUCCESS) {
+      error = EXIT_FAILURE;
+    }
+  }
+  // Se guardan en el orden del archivo, así los archivos con el mismo nombre
+  // se sobrescriben en el mismo orden que sin tandas
+  for (size_t linea = 0; linea < tanda->cantidad && error == EXIT_SUCCESS;
+      ++linea) {
+    lamina_t lamina = tanda->lineas[linea];
+    lamina.matriz = lamina.matriz2;
+    error = guardar_lamina(archivos->prefijo_ruta_trabajo, &lamina,
+      mem_comp->opciones->comprimir != 0, &mem_comp->equipo,
+      mem_comp->equipo.hilos_totales);
+    if (error == EXIT_SUCCESS) {
+      reportar_fila(archivos->archivo_salida, &lamina);
+    }
+  }
+  vaciar_tanda(tanda, arena);
+  return error;
+}
+
+int simular_lotes(archivos_t* archivos, const opciones_t* opciones,
+    size_t hilos_usuario, cache_t* cache) {
+  lamina_t lamina;
+  mem_comp_t mem_comp;
+  mem_comp.lamina = &lamina;
+  mem_comp.opciones = opciones;
+  mem_comp.punto_control = NULL;
+  // El equipo simula las láminas grandes y los carriles de las tandas
+  if (crear_hilos(&mem_comp, hilos_usuario, 0) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  tanda_t tanda;
+  tanda.lineas = NULL;
+  tanda.cantidad = 0;
+  tanda.capacidad = 0;
+  tanda.orden = NULL;
+  atomic_init(&tanda.siguiente, 0);
+  tanda.iniciales = NULL;
+  tanda.cantidad_iniciales = 0;
+  tanda.capacidad_iniciales = 0;
+  tanda.resultados = NULL;
+  tanda.capacidad_resultados = 0;
+  // Los carriles de cada hilo reservan sus matrices con la primera tanda
+  lote_t* lotes = (lote_t*) calloc(hilos_usuario, sizeof(lote_t));
+  if (lotes == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu lotes\n", hilos_usuario);
+    liberar_hilos(&mem_comp);
+    return EXIT_FAILURE;
+  }
+  for (size_t num_hilo = 0; num_hilo < hilos_usuario; ++num_hilo) {
+    lotes[num_hilo].tanda = &tanda;
+  }
+
+  lector_t lector;
+  iniciar_lector(&lector, archivos);
+  guardado_t guardado = {archivos, &mem_comp};
+  grupo_t grupo = {NULL, 0, 0, DBL_MAX};
+  char ruta_lamina[BUFFER_MAX];
+  int error = EXIT_SUCCESS;
+  while (error == EXIT_SUCCESS && leer_grupo(&lector, &grupo, ruta_lamina,
+      opciones->agrupar_epsilon != 0)) {
+    lamina = grupo.lineas[0];
+    if (!cargar_de_cache(cache, ruta_lamina, &lamina.n_filas,
+        &lamina.n_columnas, &lamina.paso, &lamina.matriz, &lamina.matriz2,
+        &mem_comp.equipo, mem_comp.equipo.hilos_totales)) {
+      // Igual que en la simulación secuencial, se deja de reportar en la
+      // primera lámina que no se pudo cargar
+      break;
+    }
+    const bool pequena = lamina_pequena(&lamina);
+    // La tanda se simula antes de una lámina grande o de una línea que ya no
+    // cabe, así el reporte sigue el orden del archivo
+    if (tanda.cantidad > 0 && (!pequena
+        || tanda.cantidad + grupo.cantidad > opciones->lote)) {
+      error = simular_tanda(&tanda, lotes, &mem_comp, archivos, cache->arena);
+    }
+    if (error != EXIT_SUCCESS) {
+      devolver_matriz(cache->arena, lamina.matriz);
+      devolver_matriz(cache->arena, lamina.matriz2);
+    } else if (pequena) {
+      // Los carriles llevan su propio estado siguiente
+      devolver_matriz(cache->arena, lamina.matriz2);
+      if (!agregar_grupo(&tanda, &grupo, &lamina)) {
+        devolver_matriz(cache->arena, lamina.matriz);
+        error = EXIT_FAILURE;
+      }
+    } else {
+      error = procesar_grupo(&grupo, &mem_comp, guardar_linea, &guardado);
+      devolver_matriz(cache->arena, lamina.matriz);
+      devolver_matriz(cache->arena, lamina.matriz2);
+      for (size_t linea = 0; linea < grupo.cantidad && error == 0; ++linea) {
+        reportar_fila(archivos->archivo_salida, &grupo.lineas[linea]);
+      }
+    }
+  }
+  // Las líneas que quedan en la tanda, también las anteriores a una lámina
+  // que no se pudo cargar
+  if (error == EXIT_SUCCESS) {
+    error = simular_tanda(&tanda, lotes, &mem_comp, archivos, cache->arena);
+  }
+  vaciar_tanda(&tanda, cache->arena);
+  for (size_t num_hilo = 0; num_hilo < hilos_usuario; ++num_hilo) {
+    liberar_matriz(lotes[num_hilo].matrices[0]);
+    liberar_matriz(lotes[num_hilo].matrices[1]);
+  }
+  free(lotes);
+  free(tanda.lineas);
+  free(tanda.orden);
+  free(tanda.iniciales);
+  liberar_matriz(tanda.resultados);
+  liberar_grupo(&grupo);
+  liberar_hilos(&mem_comp);
+  return error;
+}
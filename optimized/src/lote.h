@@ -0,0 +1,144 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef LOTE_H
+#define LOTE_H
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "estencil.h"
+#include "grupo.h"
+#include "simul.h"
+/**
+ * @brief Líneas consecutivas del archivo de trabajo con láminas pequeñas que
+ * se simulan juntas, CARRILES_LOTE a la vez por hilo.
+ *
+ * Cada línea ocupa su propio carril, también las de un grupo de epsilon,
+ * que comparten el estado inicial. Las láminas resultantes se guardan y se
+ * reportan en el orden del archivo al terminar la tanda.
+ */
+typedef struct {
+  /**
+   * @brief Datos de cada línea en el orden del archivo. matriz apunta al
+   * estado inicial, compartido por las líneas de un grupo, y matriz2 a su
+   * lámina resultante dentro de resultados
+   */
+  lamina_t* lineas;
+  /**
+   * @brief Cantidad de líneas de la tanda
+   */
+  size_t cantidad;
+  /**
+   * @brief Líneas reservadas en lineas y en orden
+   */
+  size_t capacidad;
+  /**
+   * @brief Índices de las líneas ordenados por forma, las de igual forma en
+   * el orden del archivo
+   */
+  size_t* orden;
+  /**
+   * @brief Próxima posición de orden que no tiene carril
+   */
+  atomic_size_t siguiente;
+  /**
+   * @brief Estados iniciales cargados, se devuelven a la arena al terminar
+   */
+  double** iniciales;
+  /**
+   * @brief Cantidad de estados iniciales
+   */
+  size_t cantidad_iniciales;
+  /**
+   * @brief Estados iniciales que caben en iniciales
+   */
+  size_t capacidad_iniciales;
+  /**
+   * @brief Láminas resultantes de todas las líneas, una tras otra. Crece
+   * según las tandas y se reutiliza
+   */
+  double* resultados;
+  /**
+   * @brief Cantidad de doubles reservados en resultados
+   */
+  size_t capacidad_resultados;
+} tanda_t;
+/**
+ * @brief Carriles de un hilo: la misma celda de CARRILES_LOTE láminas de
+ * igual forma está en una línea de caché, ver estencil_lote_t.
+ *
+ * Cada carril lleva su propio coeficiente, epsilon e iteraciones. Cuando su
+ * lámina alcanza el epsilon se copia a su resultado y el carril toma la
+ * siguiente línea de la tanda con la misma forma.
+ */
+typedef struct {
+  /**
+   * @brief Tanda de la que se toman las líneas
+   */
+  tanda_t* tanda;
+  /**
+   * @brief Estado actual y siguiente de los carriles, crecen según las
+   * láminas y se reutilizan
+   */
+  double* matrices[2];
+  /**
+   * @brief Cantidad de doubles reservados en cada matriz
+   */
+  size_t capacidad;
+  /**
+   * @brief Filas de las láminas de los carriles
+   */
+  size_t n_filas;
+  /**
+   * @brief Columnas de las láminas de los carriles
+   */
+  size_t n_columnas;
+  /**
+   * @brief Línea de la tanda de cada carril, SIZE_MAX si está libre
+   */
+  size_t lineas[CARRILES_LOTE];
+  /**
+   * @brief Coeficiente de difusión térmica de cada carril, 0 si está libre
+   */
+  double coeficientes[CARRILES_LOTE];
+  /**
+   * @brief Mayor cambio de cada carril en la última iteración
+   */
+  double maximos[CARRILES_LOTE];
+  /**
+   * @brief Iteraciones de cada carril
+   */
+  size_t iteraciones[CARRILES_LOTE];
+  /**
+   * @brief EXIT_FAILURE si no hubo memoria para los carriles
+   */
+  int error;
+} lote_t;
+/**
+ * @brief Indica si una lámina es lo bastante pequeña para simularla en
+ * carriles: las dos matrices de CARRILES_LOTE láminas como ella deben caber
+ * en la mitad de la caché L2.
+ *
+ * @param lamina Lámina ya cargada.
+ * @return true si la lámina se puede simular en carriles.
+ */
+bool lamina_pequena(const lamina_t* lamina);
+/**
+ * @brief Simula el archivo de trabajo agrupando las láminas pequeñas en
+ * tandas de hasta opciones->lote líneas.
+ *
+ * Las líneas consecutivas con láminas pequeñas (ver lamina_pequena()) se
+ * acumulan en una tanda. Una lámina grande, o una línea que ya no cabe,
+ * simula la tanda: sus líneas se ordenan por forma y cada hilo del equipo
+ * avanza CARRILES_LOTE a la vez con calcular_lote(). Las láminas grandes se
+ * simulan con todo el equipo como en simular_secuencial(). Las iteraciones
+ * y las láminas resultantes son las mismas que al simular cada línea con
+ * procesar_lamina().
+ *
+ * @param archivos Archivos de trabajo y de salida ya abiertos.
+ * @param opciones Opciones de la línea de comandos.
+ * @param hilos_usuario Hilos que indicó el usuario.
+ * @param cache Caché de láminas iniciales.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int simular_lotes(archivos_t* archivos, const opciones_t* opciones,
+  size_t hilos_usuario, cache_t* cache);
+#endif
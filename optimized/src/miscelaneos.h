@@ -2,10 +2,90 @@
 #ifndef MISCELANEOS_H
 #define MISCELANEOS_H
 #define BUFFER_MAX 1024
+#define LINEA_CACHE 64
+/**
+ * @brief Variable de entorno que, si vale 1, hace que cada lámina resultante
+ * se sincronice al disco con fdatasync antes de cerrarla.
+ */
+#define SINCRONIZAR_ENTORNO "LAMINA_FDATASYNC"
+/**
+ * @brief Variable de entorno que, si vale 1, imprime en stderr los bytes por
+ * segundo con que se escribió cada lámina resultante.
+ */
+#define ESTADISTICAS_ENTORNO "LAMINA_ESTADISTICAS"
+/**
+ * @brief Variable de entorno con la lista de CPUs, como 0,2,4-7, a las que se
+ * fijan los hilos de cálculo: el hilo k va a la CPU k módulo el largo de la
+ * lista.
+ */
+#define AFINIDAD_ENTORNO "LAMINA_AFINIDAD"
+/**
+ * @brief Máximo de CPUs en la lista de AFINIDAD_ENTORNO
+ */
+#define AFINIDAD_MAX 1024
+/**
+ * @brief Tamaño de una página grande. Las matrices de al menos este tamaño
+ * se alinean a él y se marcan con MADV_HUGEPAGE
+ */
+#define PAGINA_GRANDE (2 * 1024 * 1024)
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <time.h>
+/**
+ * @brief Archivo de una lámina mapeado en memoria
+ */
+typedef struct {
+  /**
+   * @brief Inicio del mapeo, NULL si ya se cerró
+   */
+  const char* datos;
+  /**
+   * @brief Bytes mapeados
+   */
+  size_t bytes;
+  /**
+   * @brief Celdas de la lámina por filas, sin relleno. NULL si la lámina
+   * está comprimida
+   */
+  const double* celdas;
+  /**
+   * @brief Número de filas leído del encabezado
+   */
+  size_t n_filas;
+  /**
+   * @brief Número de columnas leído del encabezado
+   */
+  size_t n_columnas;
+  /**
+   * @brief Filas de cada bloque comprimido, 0 si la lámina es cruda
+   */
+  size_t filas_bloque;
+  /**
+   * @brief Fin de cada bloque comprimido desde el inicio de bloques
+   */
+  const uint64_t* fin_bloques;
+  /**
+   * @brief Inicio del primer bloque comprimido
+   */
+  const uint8_t* bloques;
+} mapeo_lamina_t;
+/**
+ * @brief CPUs a las que se fijan los hilos de cálculo
+ */
+typedef struct {
+  /**
+   * @brief Cantidad de CPUs en cpus, 0 si no se fijan los hilos
+   */
+  size_t cantidad;
+  /**
+   * @brief CPU de cada posición del mapa
+   */
+  int cpus[AFINIDAD_MAX];
+} afinidad_t;
 /**
  * @brief Transforma el tiempo en formato con fecha y hora.
  * 
@@ -16,20 +96,185 @@
  */
 void format_time(const time_t seconds, char* duracion);
 /**
- * @brief Crea una matriz dinámica
+ * @brief Calcula el paso (cantidad de doubles entre el inicio de una fila y
+ * el de la siguiente) para filas de n_columnas celdas.
+ *
+ * El paso se redondea a un múltiplo de una línea de caché, así cada fila
+ * inicia alineada a LINEA_CACHE bytes.
+ *
+ * @param n_columnas Número de columnas de la matriz.
+ * @return Paso de las filas en cantidad de doubles.
+ */
+size_t calcular_paso(const size_t n_columnas);
+/**
+ * @brief Crea una matriz dinámica en un solo bloque contiguo
+ *
+ * La celda (i, j) se encuentra en matriz[i * paso + j]. El bloque está
+ * alineado a LINEA_CACHE e inicializado en cero, incluido el relleno.
  * 
  * @param n_filas Número de filas de la matriz.
+ * @param paso Paso de las filas, obtenido con calcular_paso().
+ * @return Matriz creada o NULL si no se pudo crear.
+ */
+double* crear_matriz(const size_t n_filas, const size_t paso);
+/**
+ * @brief Reserva una matriz igual que crear_matriz() pero sin inicializarla.
+ *
+ * Sirve cuando quien la reserva va a escribir todas las celdas, así el
+ * bloque no se recorre dos veces.
+ *
+ * Las matrices de al menos PAGINA_GRANDE bytes se alinean a ese tamaño y se
+ * marcan con MADV_HUGEPAGE. Como ninguna página se toca aquí, cada una queda
+ * en el nodo NUMA del hilo que la escriba primero.
+ *
+ * @param n_filas Número de filas de la matriz.
+ * @param paso Paso de las filas, obtenido con calcular_paso().
+ * @return Matriz reservada o NULL si no se pudo reservar.
+ */
+double* reservar_matriz(const size_t n_filas, const size_t paso);
+/**
+ * @brief Mapea el archivo binario de una lámina y valida su encabezado.
+ *
+ * El archivo crudo tiene el número de filas y de columnas (size_t) seguido
+ * de las celdas (double) por filas, y su tamaño debe coincidir con el
+ * encabezado. Si empieza con MAGIA_COMPRIMIDA es una lámina comprimida y se
+ * valida con abrir_comprimida().
+ *
+ * @param ruta Ruta del archivo de la lámina.
+ * @param mapeo Mapeo creado, se libera con cerrar_lamina().
+ * @return true si se mapeó la lámina, false en caso de error.
+ */
+bool abrir_lamina(const char* ruta, mapeo_lamina_t* mapeo);
+/**
+ * @brief Copia las filas [fila_inicio, fila_fin) del mapeo a la matriz, con
+ * el relleno en cero.
+ *
+ * Permite que cada hilo cargue sus propias filas y sea el primero en tocar
+ * sus páginas. Si la lámina está comprimida decodifica los bloques del
+ * rango con copiar_filas_comprimidas().
+ *
+ * @param mapeo Mapeo creado con abrir_lamina().
+ * @param matriz Matriz reservada para n_filas filas.
+ * @param paso Paso de las filas de la matriz.
+ * @param fila_inicio Primera fila a copiar.
+ * @param fila_fin Fila siguiente a la última a copiar.
+ */
+void copiar_filas(const mapeo_lamina_t* mapeo, double* matriz, size_t paso,
+  size_t fila_inicio, size_t fila_fin);
+/**
+ * @brief Libera el mapeo de una lámina. No hace nada si ya se liberó.
+ *
+ * @param mapeo Mapeo creado con abrir_lamina().
+ */
+void cerrar_lamina(mapeo_lamina_t* mapeo);
+/**
+ * @brief Carga la matriz de una lámina mapeando su archivo binario.
+ *
+ * El archivo tiene el número de filas y de columnas (size_t) seguido de las
+ * celdas (double) por filas. Se valida que el tamaño del archivo coincida
+ * con el encabezado y la matriz se llena directo desde el mapeo, con el
+ * relleno en cero.
+ *
+ * @param ruta Ruta del archivo de la lámina.
+ * @param n_filas Número de filas leído del encabezado.
+ * @param n_columnas Número de columnas leído del encabezado.
+ * @param paso Paso de las filas de la matriz creada.
+ * @param matriz Matriz con el estado inicial.
+ * @return true si se cargó la lámina, false en caso de error.
+ */
+bool mapear_matriz(const char* ruta, size_t* n_filas, size_t* n_columnas,
+  size_t* paso, double** matriz);
+/**
+ * @brief Crea la matriz del estado siguiente con los bordes de matriz.
+ *
+ * Solo se copian los bordes: el interior se sobrescribe en la primera
+ * iteración antes de leerse. El relleno queda en cero.
+ *
+ * @param matriz Matriz con el estado inicial.
+ * @param n_filas Número de filas de la matriz.
  * @param n_columnas Número de columnas de la matriz.
+ * @param paso Paso de las filas de la matriz.
  * @return Matriz creada o NULL si no se pudo crear.
  */
-double** crear_matriz(const size_t n_filas, const size_t n_columnas);
+double* crear_matriz_bordes(const double* matriz, size_t n_filas,
+  size_t n_columnas, size_t paso);
+/**
+ * @brief Copia los bordes de las filas [fila_inicio, fila_fin) de matriz a
+ * matriz2, como crear_matriz_bordes() pero sobre una matriz ya reservada.
+ *
+ * @param matriz Matriz con el estado inicial.
+ * @param matriz2 Matriz del estado siguiente.
+ * @param n_filas Número de filas de las matrices.
+ * @param n_columnas Número de columnas de las matrices.
+ * @param paso Paso de las filas de las matrices.
+ * @param fila_inicio Primera fila a copiar.
+ * @param fila_fin Fila siguiente a la última a copiar.
+ */
+void copiar_bordes(const double* matriz, double* matriz2, size_t n_filas,
+  size_t n_columnas, size_t paso, size_t fila_inicio, size_t fila_fin);
+/**
+ * @brief Carga las dos matrices de una lámina mapeando su archivo binario.
+ *
+ * Equivale a mapear_matriz() seguida de crear_matriz_bordes().
+ *
+ * @param ruta Ruta del archivo de la lámina.
+ * @param n_filas Número de filas leído del encabezado.
+ * @param n_columnas Número de columnas leído del encabezado.
+ * @param paso Paso de las filas de las matrices creadas.
+ * @param matriz Matriz con el estado inicial.
+ * @param matriz2 Matriz para el estado siguiente, con los mismos bordes.
+ * @return true si se cargó la lámina, false en caso de error.
+ */
+bool mapear_matrices(const char* ruta, size_t* n_filas, size_t* n_columnas,
+  size_t* paso, double** matriz, double** matriz2);
+/**
+ * @brief Escribe todos los segmentos en el archivo con writev.
+ *
+ * Envía hasta IOV_MAX segmentos por llamada y continúa después de una
+ * escritura parcial o de una interrupción. Los segmentos se modifican.
+ *
+ * @param archivo Descriptor del archivo abierto para escritura.
+ * @param iov Segmentos a escribir.
+ * @param segmentos Cantidad de segmentos.
+ * @return true si se escribió todo, false en caso de error con errno.
+ */
+bool escribir_segmentos(int archivo, struct iovec* iov, size_t segmentos);
+/**
+ * @brief Crea o sobrescribe un archivo con los segmentos dados.
+ *
+ * Respeta SINCRONIZAR_ENTORNO y ESTADISTICAS_ENTORNO.
+ *
+ * @param ruta Ruta del archivo a crear o sobrescribir.
+ * @param iov Segmentos a escribir, se modifican.
+ * @param segmentos Cantidad de segmentos.
+ * @param bytes Total de bytes de los segmentos, para las estadísticas.
+ * @return true si se escribió completo, false en caso de error.
+ */
+bool escribir_archivo(const char* ruta, struct iovec* iov, size_t segmentos,
+  size_t bytes);
+/**
+ * @brief Escribe una matriz en el formato binario de lámina con writev.
+ *
+ * El encabezado y las filas, sin el relleno, se envían en una sola llamada
+ * por cada IOV_MAX segmentos en lugar de una por fila. Si el paso coincide
+ * con el número de columnas las celdas van en un único segmento. Se escribe
+ * con escribir_archivo().
+ *
+ * @param ruta Ruta del archivo a crear o sobrescribir.
+ * @param n_filas Número de filas de la matriz.
+ * @param n_columnas Número de columnas de la matriz.
+ * @param paso Paso de las filas de la matriz.
+ * @param matriz Matriz a escribir.
+ * @return true si se escribió completa, false en caso de error.
+ */
+bool escribir_matriz(const char* ruta, size_t n_filas, size_t n_columnas,
+  size_t paso, const double* matriz);
 /**
  * @brief Libera la memoria ocupada por una matriz.
  * 
  * @param matrix matriz a liberar.
- * @param n_filas Número de filas de la matriz.
  */
-void liberar_matriz(double** matrix, const size_t n_filas);
+void liberar_matriz(double* matrix);
 /**
  * @brief Elimina la extensión de un nombre de archivo y la guarda una cadena.
  * 
@@ -38,11 +283,28 @@ void liberar_matriz(double** matrix, const size_t n_filas);
  */
 void quitar_extension(const char *archivo, char *nombre_sin_ext);
 /**
- * @brief Intercambia los punteros de dos matrices bidimensionales.
+ * @brief Intercambia los punteros de dos matrices.
  * La matriz1 tomará el valor de la matriz2 y viceversa.
  *
  * @param matriz1 Puntero a la matriz1
  * @param matriz2 Puntero a la matriz2
  */
-void intercambiar_matriz(double*** matriz1, double*** matriz2);
+void intercambiar_matriz(double** matriz1, double** matriz2);
+/**
+ * @brief Lee el mapa de CPUs de AFINIDAD_ENTORNO.
+ *
+ * @param afinidad Mapa leído, vacío si la variable no está definida.
+ * @return true si la variable falta o es válida, false si es inválida, en
+ * cuyo caso el mapa queda vacío.
+ */
+bool leer_afinidad(afinidad_t* afinidad);
+/**
+ * @brief Fija el hilo que la invoca a la CPU que le corresponde en el mapa.
+ *
+ * Con el mapa vacío no hace nada. Si no se puede fijar solo lo avisa.
+ *
+ * @param afinidad Mapa leído con leer_afinidad().
+ * @param num_hilo Número del hilo de cálculo.
+ */
+void fijar_afinidad(const afinidad_t* afinidad, size_t num_hilo);
 #endif
@@ -0,0 +1,337 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include "punto_control.h"
+
+// Se pone en 1 al recibir SIGTERM, el punto se guarda en la siguiente
+// revisión
+static volatile sig_atomic_t terminar_solicitado = 0;
+
+static void recibir_terminar(int senal) {
+  (void) senal;
+  terminar_solicitado = 1;
+}
+
+// Continúa la suma FNV-1a de 64 bits con los bytes dados
+static uint64_t sumar_bytes(uint64_t suma, const void* datos, size_t bytes) {
+  const unsigned char* byte = (const unsigned char*) datos;
+  for (size_t indice = 0; indice < bytes; ++indice) {
+    suma ^= byte[indice];
+    suma *= 0x100000001B3ULL;
+  }
+  return suma;
+}
+
+// Suma del encabezado, las líneas y las filas sin relleno
+static uint64_t sumar_punto(encabezado_control_t encabezado,
+    const linea_control_t* lineas, const double* matriz, size_t paso) {
+  encabezado.suma = 0;
+  uint64_t suma = sumar_bytes(0xCBF29CE484222325ULL, &encabezado,
+    sizeof(encabezado));
+  suma = sumar_bytes(suma, lineas, encabezado.cantidad * sizeof(*lineas));
+  for (size_t fila = 0; fila < encabezado.n_filas; ++fila) {
+    suma = sumar_bytes(suma, matriz + fila * paso,
+      encabezado.n_columnas * sizeof(double));
+  }
+  return suma;
+}
+
+// Lee exactamente bytes del archivo
+static bool leer_todo(int archivo, void* datos, size_t bytes) {
+  char* destino = (char*) datos;
+  while (bytes > 0) {
+    const ssize_t leidos = read(archivo, destino, bytes);
+    if (leidos < 0 && errno == EINTR) {
+      continue;
+    }
+    if (leidos <= 0) {
+      return false;
+    }
+    destino += leidos;
+    bytes -= (size_t) leidos;
+  }
+  return true;
+}
+
+// Escribe el punto en la ruta temporal y lo renombra, el punto anterior
+// queda de respaldo
+static bool guardar_punto_control(punto_control_t* punto_control,
+    const lamina_t* lamina, double max_temp) {
+  // Las filas del TSV anteriores al grupo deben estar en el archivo
+  if (fflush(punto_control->archivo_salida) != 0) {
+    fprintf(stderr, "Error al vaciar el archivo de salida: %s\n",
+      strerror(errno));
+    return false;
+  }
+  const grupo_t* grupo = punto_control->grupo;
+  encabezado_control_t encabezado;
+  memset(&encabezado, 0, sizeof(encabezado));
+  encabezado.firma = PUNTO_CONTROL_FIRMA;
+  encabezado.linea = punto_control->linea;
+  encabezado.cantidad = grupo->cantidad;
+  encabezado.desplazamiento_salida = punto_control->desplazamiento_salida;
+  strcpy(encabezado.nombre, lamina->nombre);
+  encabezado.tiempo = lamina->tiempo;
+  encabezado.difusividad = lamina->difusividad;
+  encabezado.distancia = lamina->distancia;
+  encabezado.iteraciones = lamina->iteraciones;
+  encabezado.max_temp = max_temp;
+  encabezado.n_filas = lamina->n_filas;
+  encabezado.n_columnas = lamina->n_columnas;
+
+  // Un segmento para el encabezado, uno para las líneas y uno por fila, o
+  // uno para todas las filas si no hay relleno
+  const size_t filas_segmento = lamina->paso == lamina->n_columnas
+      ? lamina->n_filas : 1;
+  const size_t segmentos = 2
+      + (lamina->n_filas + filas_segmento - 1) / filas_segmento;
+  linea_control_t* lineas = (linea_control_t*) calloc(grupo->cantidad,
+    sizeof(linea_control_t));
+  struct iovec* iov = (struct iovec*) malloc(segmentos * sizeof(*iov));
+  if (lineas == NULL || iov == NULL) {
+    fprintf(stderr, "Error: no hay memoria para el punto de control\n");
+    free(lineas);
+    free(iov);
+    return false;
+  }
+  for (size_t linea = 0; linea < grupo->cantidad; ++linea) {
+    lineas[linea].epsilon = grupo->lineas[linea].epsilon;
+    lineas[linea].iteraciones = grupo->lineas[linea].iteraciones;
+  }
+  encabezado.suma = sumar_punto(encabezado, lineas, lamina->matriz,
+    lamina->paso);
+  iov[0].iov_base = &encabezado;
+  iov[0].iov_len = sizeof(encabezado);
+  iov[1].iov_base = lineas;
+  iov[1].iov_len = grupo->cantidad * sizeof(linea_control_t);
+  for (size_t k = 2; k < segmentos; ++k) {
+    iov[k].iov_base = lamina->matriz + (k - 2) * filas_segmento * lamina->paso;
+    iov[k].iov_len = filas_segmento * lamina->n_columnas * sizeof(double);
+  }
+
+  bool correcto = false;
+  const int archivo = open(punto_control->ruta_temporal,
+    O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (archivo >= 0) {
+    // Sincronizado antes de renombrar para que el punto nunca quede a medias
+    correcto = escribir_segmentos(archivo, iov, segmentos)
+        && fdatasync(archivo) == 0;
+    correcto = close(archivo) == 0 && correcto;
+  }
+  if (correcto && rename(punto_control->ruta,
+      punto_control->ruta_anterior) != 0 && errno != ENOENT) {
+    correcto = false;
+  }
+  correcto = correcto && rename(punto_control->ruta_temporal,
+    punto_control->ruta) == 0;
+  if (!correcto) {
+    fprintf(stderr, "Error al guardar el punto de control %s: %s\n",
+      punto_control->ruta, strerror(errno));
+  }
+  free(iov);
+  free(lineas);
+  return correcto;
+}
+
+// Lee y valida un archivo de punto de control
+static bool leer_archivo_control(const char* ruta,
+    reanudacion_t* reanudacion) {
+  const int archivo = open(ruta, O_RDONLY);
+  if (archivo < 0) {
+    return false;
+  }
+  encabezado_control_t* encabezado = &reanudacion->encabezado;
+  struct stat estado;
+  bool correcto = fstat(archivo, &estado) == 0
+      && leer_todo(archivo, encabezado, sizeof(*encabezado))
+      && encabezado->firma == PUNTO_CONTROL_FIRMA
+      && encabezado->cantidad > 0 && encabezado->n_filas > 0
+      && encabezado->n_columnas > 0
+      && memchr(encabezado->nombre, '\0', BUFFER_MAX) != NULL;
+  // El tamaño debe coincidir con el encabezado, sin desbordes
+  const size_t limite = SIZE_MAX / 2;
+  correcto = correcto
+      && encabezado->cantidad < limite / sizeof(linea_control_t)
+      && encabezado->n_columnas < limite / sizeof(double)
+      && encabezado->n_filas < limite / sizeof(double)
+        / encabezado->n_columnas;
+  correcto = correcto && (size_t) estado.st_size == sizeof(*encabezado)
+      + encabezado->cantidad * sizeof(linea_control_t)
+      + encabezado->n_filas * encabezado->n_columnas * sizeof(double);
+  if (correcto) {
+    reanudacion->lineas = (linea_control_t*) malloc(encabezado->cantidad
+      * sizeof(linea_control_t));
+    reanudacion->paso = calcular_paso(encabezado->n_columnas);
+    reanudacion->matriz = reservar_matriz(encabezado->n_filas,
+      reanudacion->paso);
+    correcto = reanudacion->lineas && reanudacion->matriz
+        && leer_todo(archivo, reanudacion->lineas,
+          encabezado->cantidad * sizeof(linea_control_t));
+  }
+  for (size_t fila = 0; correcto && fila < encabezado->n_filas; ++fila) {
+    double* destino = reanudacion->matriz + fila * reanudacion->paso;
+    correcto = leer_todo(archivo, destino,
+      encabezado->n_columnas * sizeof(double));
+    memset(destino + encabezado->n_columnas, 0,
+      (reanudacion->paso - encabezado->n_columnas) * sizeof(double));
+  }
+  close(archivo);
+  correcto = correcto && sumar_punto(*encabezado, reanudacion->lineas,
+    reanudacion->matriz, reanudacion->paso) == encabezado->suma;
+  if (!correcto) {
+    fprintf(stderr, "Punto de control inválido: %s\n", ruta);
+    liberar_reanudacion(reanudacion);
+  }
+  return correcto;
+}
+
+int iniciar_punto_control(punto_control_t* punto_control,
+    const archivos_t* archivos, const opciones_t* opciones) {
+  memset(punto_control, 0, sizeof(*punto_control));
+  if (snprintf(punto_control->ruta_anterior, BUFFER_MAX, "%s.anterior",
+      archivos->ruta_punto_control) >= (int) BUFFER_MAX
+      || snprintf(punto_control->ruta_temporal, BUFFER_MAX, "%s.tmp",
+      archivos->ruta_punto_control) >= (int) BUFFER_MAX) {
+    fprintf(stderr, "Error: ruta_punto_control truncada\n");
+    return EXIT_FAILURE;
+  }
+  strcpy(punto_control->ruta, archivos->ruta_punto_control);
+  punto_control->intervalo_iteraciones = opciones->control_iteraciones;
+  punto_control->intervalo_segundos = opciones->control_segundos;
+  punto_control->archivo_salida = archivos->archivo_salida;
+  // SIGTERM solo marca que hay que guardar y detenerse
+  struct sigaction accion;
+  memset(&accion, 0, sizeof(accion));
+  accion.sa_handler = recibir_terminar;
+  sigemptyset(&accion.sa_mask);
+  accion.sa_flags = SA_RESTART;
+  if (sigaction(SIGTERM, &accion, NULL) != 0) {
+    fprintf(stderr, "Error al instalar el manejador de SIGTERM: %s\n",
+      strerror(errno));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+void comenzar_grupo(punto_control_t* punto_control, const grupo_t* grupo,
+    size_t linea, size_t iteraciones) {
+  punto_control->grupo = grupo;
+  punto_control->linea = linea;
+  const long desplazamiento = ftell(punto_control->archivo_salida);
+  punto_control->desplazamiento_salida = desplazamiento > 0
+      ? (size_t) desplazamiento : 0;
+  punto_control->iteracion_guardada = iteraciones;
+  clock_gettime(CLOCK_MONOTONIC, &punto_control->guardado);
+}
+
+int revisar_punto_control(punto_control_t* punto_control,
+    const lamina_t* lamina, double max_temp) {
+  const bool terminar = terminar_solicitado != 0;
+  bool guardar = terminar || (punto_control->intervalo_iteraciones
+      && lamina->iteraciones - punto_control->iteracion_guardada
+        >= punto_control->intervalo_iteraciones);
+  struct timespec ahora;
+  if (!guardar && punto_control->intervalo_segundos) {
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    guardar = (size_t) (ahora.tv_sec - punto_control->guardado.tv_sec)
+        >= punto_control->intervalo_segundos;
+  }
+  if (guardar) {
+    const bool guardado = guardar_punto_control(punto_control, lamina,
+      max_temp);
+    punto_control->iteracion_guardada = lamina->iteraciones;
+    clock_gettime(CLOCK_MONOTONIC, &punto_control->guardado);
+    if (terminar) {
+      if (guardado) {
+        fprintf(stderr, "Simulación detenida por SIGTERM, se reanuda con "
+          "--restart=1 desde %s\n", punto_control->ruta);
+      }
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+int leer_punto_control(const archivos_t* archivos,
+    reanudacion_t* reanudacion) {
+  memset(reanudacion, 0, sizeof(*reanudacion));
+  // El más reciente primero, y si no es válido el anterior
+  char ruta_anterior[BUFFER_MAX];
+  if (snprintf(ruta_anterior, BUFFER_MAX, "%s.anterior",
+      archivos->ruta_punto_control) >= (int) BUFFER_MAX) {
+    fprintf(stderr, "Error: ruta_punto_control truncada\n");
+    return EXIT_FAILURE;
+  }
+  if (!leer_archivo_control(archivos->ruta_punto_control, reanudacion)
+      && !leer_archivo_control(ruta_anterior, reanudacion)) {
+    fprintf(stderr, "No hay un punto de control válido, se inicia desde "
+      "el principio\n");
+  }
+  // Las filas posteriores al grupo del punto se vuelven a escribir
+  const size_t desplazamiento = reanudacion->matriz
+      ? reanudacion->encabezado.desplazamiento_salida : 0;
+  FILE* salida = archivos->archivo_salida;
+  struct stat estado;
+  if (fflush(salida) != 0 || fstat(fileno(salida), &estado) != 0
+      || (size_t) estado.st_size < desplazamiento
+      || ftruncate(fileno(salida), (off_t) desplazamiento) != 0
+      || fseek(salida, 0, SEEK_END) != 0) {
+    fprintf(stderr, "Error: el archivo de salida no corresponde al punto de "
+      "control\n");
+    liberar_reanudacion(reanudacion);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+bool reanudar_grupo(reanudacion_t* reanudacion, grupo_t* grupo,
+    lamina_t* lamina) {
+  const encabezado_control_t* encabezado = &reanudacion->encabezado;
+  const lamina_t* primera = &grupo->lineas[0];
+  bool mismo = grupo->cantidad == encabezado->cantidad
+      && strcmp(primera->nombre, encabezado->nombre) == 0
+      && primera->tiempo == encabezado->tiempo
+      && primera->difusividad == encabezado->difusividad
+      && primera->distancia == encabezado->distancia;
+  for (size_t linea = 0; mismo && linea < grupo->cantidad; ++linea) {
+    mismo = grupo->lineas[linea].epsilon == reanudacion->lineas[linea].epsilon;
+  }
+  if (!mismo) {
+    fprintf(stderr, "Error: el punto de control no corresponde a la línea "
+      "%zu del archivo de trabajo\n", encabezado->linea + 1);
+    return false;
+  }
+  lamina->n_filas = encabezado->n_filas;
+  lamina->n_columnas = encabezado->n_columnas;
+  lamina->paso = reanudacion->paso;
+  lamina->matriz2 = crear_matriz_bordes(reanudacion->matriz, lamina->n_filas,
+    lamina->n_columnas, lamina->paso);
+  if (lamina->matriz2 == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", lamina->nombre);
+    return false;
+  }
+  lamina->matriz = reanudacion->matriz;
+  reanudacion->matriz = NULL;
+  lamina->iteraciones = encabezado->iteraciones;
+  for (size_t linea = 0; linea < grupo->cantidad; ++linea) {
+    grupo->lineas[linea].iteraciones = reanudacion->lineas[linea].iteraciones;
+  }
+  grupo->max_temp = encabezado->max_temp;
+  fprintf(stderr, "Reanudando %s desde la iteración %zu\n", lamina->nombre,
+    lamina->iteraciones);
+  return true;
+}
+
+void liberar_reanudacion(reanudacion_t* reanudacion) {
+  free(reanudacion->lineas);
+  reanudacion->lineas = NULL;
+  liberar_matriz(reanudacion->matriz);
+  reanudacion->matriz = NULL;
+}
+
+void borrar_punto_control(punto_control_t* punto_control) {
+  unlink(punto_control->ruta);
+  unlink(punto_control->ruta_anterior);
+  unlink(punto_control->ruta_temporal);
+}
@@ -0,0 +1,232 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef PUNTO_CONTROL_H
+#define PUNTO_CONTROL_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "grupo.h"
+#include "simul.h"
+/**
+ * @brief Primeros bytes de un archivo de punto de control, "LAMCTRL1"
+ */
+#define PUNTO_CONTROL_FIRMA 0x314C5254434D414CULL
+/**
+ * @brief Encabezado del archivo de punto de control. Le siguen cantidad
+ * linea_control_t y las n_filas * n_columnas celdas de la matriz, sin
+ * relleno
+ */
+typedef struct {
+  /**
+   * @brief PUNTO_CONTROL_FIRMA
+   */
+  uint64_t firma;
+  /**
+   * @brief FNV-1a de todo el archivo, calculada con este campo en 0
+   */
+  uint64_t suma;
+  /**
+   * @brief Índice de la primera línea del grupo en el archivo de trabajo
+   */
+  size_t linea;
+  /**
+   * @brief Cantidad de líneas del grupo
+   */
+  size_t cantidad;
+  /**
+   * @brief Bytes del archivo de salida hasta la fila de la primera línea
+   */
+  size_t desplazamiento_salida;
+  /**
+   * @brief Nombre de la lámina del grupo
+   */
+  char nombre[BUFFER_MAX];
+  /**
+   * @brief Tiempo de cada iteración
+   */
+  size_t tiempo;
+  /**
+   * @brief Difusividad del grupo
+   */
+  double difusividad;
+  /**
+   * @brief Distancia del grupo
+   */
+  double distancia;
+  /**
+   * @brief Iteraciones que tiene la matriz
+   */
+  size_t iteraciones;
+  /**
+   * @brief Mayor cambio de la última iteración
+   */
+  double max_temp;
+  /**
+   * @brief Número de filas de la matriz
+   */
+  size_t n_filas;
+  /**
+   * @brief Número de columnas de la matriz
+   */
+  size_t n_columnas;
+} encabezado_control_t;
+/**
+ * @brief Estado de una línea del grupo en el punto de control
+ */
+typedef struct {
+  /**
+   * @brief Epsilon de la línea
+   */
+  double epsilon;
+  /**
+   * @brief Iteraciones con que se entregó la línea, 0 si aún no
+   */
+  size_t iteraciones;
+} linea_control_t;
+/**
+ * @brief Puntos de control de la simulación secuencial.
+ *
+ * Se guarda uno cada control_iteraciones iteraciones o control_segundos
+ * segundos, y al recibir SIGTERM. Cada punto se escribe en un archivo
+ * temporal que se renombra sobre el anterior, el cual se conserva como
+ * respaldo, así siempre queda al menos un punto completo.
+ */
+struct punto_control {
+  /**
+   * @brief Ruta del punto de control más reciente
+   */
+  char ruta[BUFFER_MAX];
+  /**
+   * @brief Ruta del punto de control anterior
+   */
+  char ruta_anterior[BUFFER_MAX];
+  /**
+   * @brief Ruta donde se escribe el punto antes de renombrarlo
+   */
+  char ruta_temporal[BUFFER_MAX];
+  /**
+   * @brief Iteraciones entre puntos de control, 0 si no se usan
+   */
+  size_t intervalo_iteraciones;
+  /**
+   * @brief Segundos entre puntos de control, 0 si no se usan
+   */
+  size_t intervalo_segundos;
+  /**
+   * @brief Archivo de salida, se vacía antes de cada punto
+   */
+  FILE* archivo_salida;
+  /**
+   * @brief Grupo que se está simulando
+   */
+  const grupo_t* grupo;
+  /**
+   * @brief Índice de la primera línea del grupo
+   */
+  size_t linea;
+  /**
+   * @brief Bytes del archivo de salida al iniciar el grupo
+   */
+  size_t desplazamiento_salida;
+  /**
+   * @brief Iteraciones de la lámina en el último punto o al iniciar el grupo
+   */
+  size_t iteracion_guardada;
+  /**
+   * @brief Momento del último punto o del inicio del grupo
+   */
+  struct timespec guardado;
+};
+/**
+ * @brief Punto de control leído para reanudar la simulación
+ */
+typedef struct {
+  /**
+   * @brief Encabezado del punto
+   */
+  encabezado_control_t encabezado;
+  /**
+   * @brief Estado de cada línea del grupo
+   */
+  linea_control_t* lineas;
+  /**
+   * @brief Matriz del punto, NULL si no hay punto o si ya se usó
+   */
+  double* matriz;
+  /**
+   * @brief Paso de las filas de matriz
+   */
+  size_t paso;
+} reanudacion_t;
+/**
+ * @brief Prepara los puntos de control e instala el manejador de SIGTERM.
+ *
+ * @param punto_control Punto de control a preparar.
+ * @param archivos Archivos de la simulación.
+ * @param opciones Opciones con los intervalos.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int iniciar_punto_control(punto_control_t* punto_control,
+  const archivos_t* archivos, const opciones_t* opciones);
+/**
+ * @brief Indica el grupo que empieza a simularse.
+ *
+ * @param punto_control Punto de control.
+ * @param grupo Grupo que se simulará.
+ * @param linea Índice de la primera línea del grupo.
+ * @param iteraciones Iteraciones con que inicia la lámina.
+ */
+void comenzar_grupo(punto_control_t* punto_control, const grupo_t* grupo,
+  size_t linea, size_t iteraciones);
+/**
+ * @brief Guarda un punto de control si se cumplió un intervalo o se recibió
+ * SIGTERM.
+ *
+ * Un error al guardar por intervalo solo se avisa y la simulación sigue.
+ *
+ * @param punto_control Punto de control.
+ * @param lamina Lámina con el estado actual en matriz.
+ * @param max_temp Mayor cambio de la última iteración.
+ * @return EXIT_SUCCESS o EXIT_FAILURE si se recibió SIGTERM.
+ */
+int revisar_punto_control(punto_control_t* punto_control,
+  const lamina_t* lamina, double max_temp);
+/**
+ * @brief Lee el punto de control más reciente que sea válido y recorta el
+ * archivo de salida hasta donde lo tenía.
+ *
+ * Si no hay un punto válido la simulación inicia desde el principio y el
+ * archivo de salida queda vacío.
+ *
+ * @param archivos Archivos de la simulación.
+ * @param reanudacion Punto leído, con matriz en NULL si no había.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int leer_punto_control(const archivos_t* archivos,
+  reanudacion_t* reanudacion);
+/**
+ * @brief Restaura el grupo del punto de control.
+ *
+ * Verifica que el grupo sea el mismo del punto, pasa la matriz del punto a
+ * la lámina y restaura las iteraciones de la lámina y de las líneas.
+ *
+ * @param reanudacion Punto leído con leer_punto_control().
+ * @param grupo Grupo que inicia en la línea del punto.
+ * @param lamina Lámina donde quedan las matrices.
+ * @return true si se restauró, false si el punto no corresponde al grupo.
+ */
+bool reanudar_grupo(reanudacion_t* reanudacion, grupo_t* grupo,
+  lamina_t* lamina);
+/**
+ * @brief Libera lo que quede del punto leído.
+ *
+ * @param reanudacion Punto leído.
+ */
+void liberar_reanudacion(reanudacion_t* reanudacion);
+/**
+ * @brief Borra los puntos de control al terminar el trabajo.
+ *
+ * @param punto_control Punto de control.
+ */
+void borrar_punto_control(punto_control_t* punto_control);
+#endif
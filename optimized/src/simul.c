@@ -1,54 +1,177 @@
 // Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <math.h>
 #include "simul.h"
+#include "concurrente.h"
+#include "estrategia.h"
+#include "grupo.h"
+#include "lote.h"
+#include "punto_control.h"
+#include "tuberia.h"
 
 int iniciar_simul(int argc, char* argv[]) {
+  // Lee las opciones antes de abrir archivos
+  opciones_t opciones;
+  if (leer_opciones(argc, argv, &opciones) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  // Lee la CPU a la que se fija cada hilo, si el usuario las indicó
+  if (!leer_afinidad(&opciones.afinidad)) {
+    return EXIT_FAILURE;
+  }
   // Crea struct para los archivos de la simulacion
   archivos_t archivos;
   // Prepara los archivos segun los argumentos enviados por el usuario
-  if (preparar_archivos(argc, argv, &archivos)!= EXIT_SUCCESS) {
+  if (preparar_archivos(argc, argv, &archivos, opciones.reanudar != 0)
+      != EXIT_SUCCESS) {
     return EXIT_FAILURE;
   }
+  // Elige la implementación del estencil según el procesador
+  seleccionar_estencil();
   // Obtiene el número de hilos que indica el usuario
   size_t hilos_usuario = sysconf(_SC_NPROCESSORS_ONLN);
-  if (sscanf(argv[2], "%zu", &hilos_usuario) == 1) {
+  if (sscanf(argv[2], "%zu", &hilos_usuario) == 1 && hilos_usuario > 0) {
   } else {
     fprintf(stderr, "Error: invalid thread count\n");
     return EXIT_FAILURE;
   }
+  // Las matrices de una línea se reutilizan en las siguientes
+  arena_t arena;
+  crear_arena(&arena, opciones.arena_mb * 1024 * 1024);
+  // Las láminas que se repiten en el trabajo se cargan una sola vez
+  cache_t cache;
+  crear_cache(&cache, opciones.cache_mb * 1024 * 1024, &arena);
+  int error = 0;
+  if (opciones.lote > 1) {
+    // Las láminas pequeñas se simulan juntas, en carriles
+    error = simular_lotes(&archivos, &opciones, hilos_usuario, &cache);
+  } else if (opciones.laminas_concurrentes > 1) {
+    // Varias láminas a la vez, cada una con su parte de los hilos
+    error = simular_concurrente(&archivos, &opciones, hilos_usuario, &cache);
+  } else if (opciones.tuberia && !opciones.control_iteraciones
+      && !opciones.control_segundos && !opciones.reanudar) {
+    // La carga y la escritura se solapan con el cálculo. Los puntos de
+    // control necesitan el reporte al día, así que usan la secuencial
+    error = simular_tuberia(&archivos, &opciones, hilos_usuario, &cache);
+  } else {
+    error = simular_secuencial(&archivos, &opciones, hilos_usuario, &cache);
+  }
+  destruir_cache(&cache);
+  destruir_arena(&arena);
+  // Cierra los archivos abiertos
+  fclose(archivos.archivo_trabajo);
+  fclose(archivos.archivo_salida);
+  return error;
+}
+
+int guardar_linea(void* contexto, size_t linea, const lamina_t* lamina) {
+  (void) linea;
+  guardado_t* guardado = (guardado_t*) contexto;
+  mem_comp_t* mem_comp = guardado->mem_comp;
+  return guardar_lamina(guardado->archivos->prefijo_ruta_trabajo, lamina,
+    mem_comp->opciones->comprimir != 0, &mem_comp->equipo,
+    mem_comp->equipo.hilos_totales);
+}
+
+int simular_secuencial(archivos_t* archivos, const opciones_t* opciones,
+    size_t hilos_usuario, cache_t* cache) {
   // Crea el struct de la lamina
   lamina_t lamina;
 
   mem_comp_t mem_comp;
   mem_comp.lamina = &lamina;
-  mem_comp.hilos_totales = hilos_usuario;
+  mem_comp.opciones = opciones;
+  mem_comp.punto_control = NULL;
+  // Puntos de control y reanudación, solo si se pidieron
+  punto_control_t punto_control;
+  reanudacion_t reanudacion = {0};
+  if (opciones->control_iteraciones || opciones->control_segundos
+      || opciones->reanudar) {
+    if (iniciar_punto_control(&punto_control, archivos, opciones)
+        != EXIT_SUCCESS) {
+      return EXIT_FAILURE;
+    }
+    mem_comp.punto_control = &punto_control;
+  }
+  if (opciones->reanudar
+      && leer_punto_control(archivos, &reanudacion) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  // El equipo se crea una vez y queda estacionado entre láminas
+  if (crear_hilos(&mem_comp, hilos_usuario, 0) != EXIT_SUCCESS) {
+    liberar_reanudacion(&reanudacion);
+    return EXIT_FAILURE;
+  }
 
+  lector_t lector;
+  iniciar_lector(&lector, archivos);
+  guardado_t guardado = {archivos, &mem_comp};
+  grupo_t grupo = {NULL, 0, 0, DBL_MAX};
+  char ruta_lamina[BUFFER_MAX];
+  size_t siguiente_linea = 0;
   int error = 0;
-  bool hay_laminas = true;
-  // Hasta que se procesen todas las láminas
-  while (hay_laminas) {
-    hay_laminas = cargar_lamina(&lamina, archivos.archivo_trabajo,
-          archivos.prefijo_ruta_trabajo);
-    if (hay_laminas) {
-        error = procesar_lamina(&lamina, &mem_comp);
-        if (error != 0) {
-            break;
-        }
-        error = reportar_lamina(archivos.archivo_salida,
-            archivos.prefijo_ruta_trabajo, &lamina);
-        if (error != 0) {
-            break;
-        }
-        liberar_matriz(lamina.matriz, lamina.n_filas);
-        liberar_matriz(lamina.matriz2, lamina.n_filas);
+  // Hasta que se procesen todas las láminas, un grupo de líneas a la vez
+  while (leer_grupo(&lector, &grupo, ruta_lamina,
+      opciones->agrupar_epsilon != 0)) {
+    const size_t primera_linea = siguiente_linea;
+    siguiente_linea += grupo.cantidad;
+    lamina = grupo.lineas[0];
+    if (reanudacion.matriz
+        && primera_linea != reanudacion.encabezado.linea) {
+      // Los grupos anteriores al punto de control ya se reportaron
+      if (siguiente_linea <= reanudacion.encabezado.linea) {
+        continue;
+      }
+      fprintf(stderr, "Error: el punto de control no corresponde a la línea "
+        "%zu del archivo de trabajo\n", reanudacion.encabezado.linea + 1);
+      error = EXIT_FAILURE;
+      break;
+    }
+    if (reanudacion.matriz) {
+      // El grupo continúa desde el punto de control
+      if (!reanudar_grupo(&reanudacion, &grupo, &lamina)) {
+        error = EXIT_FAILURE;
+        break;
+      }
+    } else if (!cargar_de_cache(cache, ruta_lamina, &lamina.n_filas,
+        &lamina.n_columnas, &lamina.paso, &lamina.matriz, &lamina.matriz2,
+        &mem_comp.equipo, mem_comp.equipo.hilos_totales)) {
+      // Crea las matrices para el estado actual y el siguiente desde la
+      // caché o desde el archivo mapeado, con el equipo estacionado
+      break;
+    }
+    if (mem_comp.punto_control) {
+      comenzar_grupo(mem_comp.punto_control, &grupo, primera_linea,
+        lamina.iteraciones);
+    }
+    // Las láminas se guardan al alcanzar cada epsilon y las filas se
+    // reportan después en el orden del archivo de trabajo
+    error = procesar_grupo(&grupo, &mem_comp, guardar_linea, &guardado);
+    devolver_matriz(cache->arena, lamina.matriz);
+    devolver_matriz(cache->arena, lamina.matriz2);
+    if (error != 0) {
+      break;
+    }
+    for (size_t linea = 0; linea < grupo.cantidad; ++linea) {
+      reportar_fila(archivos->archivo_salida, &grupo.lineas[linea]);
     }
   }
-  // Cierra los archivos abiertos
-  fclose(archivos.archivo_trabajo);
-  fclose(archivos.archivo_salida);
+  if (error == 0 && reanudacion.matriz) {
+    fprintf(stderr, "Error: el archivo de trabajo no llega a la línea %zu "
+      "del punto de control\n", reanudacion.encabezado.linea + 1);
+    error = EXIT_FAILURE;
+  }
+  // El trabajo terminó, ya no hace falta reanudarlo
+  if (error == 0 && mem_comp.punto_control) {
+    borrar_punto_control(mem_comp.punto_control);
+  }
+  liberar_reanudacion(&reanudacion);
+  liberar_grupo(&grupo);
+  liberar_hilos(&mem_comp);
   return error;
 }
 
-int preparar_archivos(int argc, char* argv[], archivos_t* archivos) {
+int preparar_archivos(int argc, char* argv[], archivos_t* archivos,
+    bool reanudar) {
   // Verifica que el número de argumentos sea el adecuado
   if (argc < 4) {
       fprintf(stderr, "Error, argumentos insuficientes\n");
@@ -77,6 +200,13 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos) {
       fprintf(stderr, "Error: ruta_salida truncada\n");
       return EXIT_FAILURE;
   }
+  // Construye la ruta del punto de control
+  if (snprintf(archivos->ruta_punto_control, BUFFER_MAX, "%s/%s.checkpoint",
+      archivos->prefijo_ruta_trabajo, nombre_trabajo_no_ext) >=
+          (int)BUFFER_MAX) {
+      fprintf(stderr, "Error: ruta_punto_control truncada\n");
+      return EXIT_FAILURE;
+  }
   // Abre el archivo de trabajo para lectura
   archivos->archivo_trabajo = fopen(ruta_trabajo, "r");
   if (archivos->archivo_trabajo == NULL) {
@@ -84,8 +214,12 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos) {
           ruta_trabajo, strerror(errno));
       return EXIT_FAILURE;
   }
-  // Abre el archivo de salida para escritura
-  archivos->archivo_salida = fopen(ruta_salida, "w");
+  // Abre el archivo de salida para escritura. Al reanudar se conserva lo
+  // que ya tiene, si existe
+  archivos->archivo_salida = reanudar ? fopen(ruta_salida, "r+") : NULL;
+  if (archivos->archivo_salida == NULL) {
+      archivos->archivo_salida = fopen(ruta_salida, "w");
+  }
   if (archivos->archivo_salida == NULL) {
       fprintf(stderr, "Error al abrir archivo: %s: %s\n",
           ruta_salida, strerror(errno));
@@ -95,66 +229,112 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos) {
   return EXIT_SUCCESS;
 }
 
-bool cargar_lamina(lamina_t* lamina, FILE* archivo_trabajo,
-  char* prefijo_ruta_trabajo) {
-  char ruta_lamina[BUFFER_MAX];
-  if (!leer_datos_lamina(lamina, archivo_trabajo, prefijo_ruta_trabajo,
-      ruta_lamina)) {
-    return false;
-  }
-  FILE* archivo_lamina = fopen(ruta_lamina, "rb");
-  if (archivo_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta_lamina,
-        strerror(errno));
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee el número de filas y columnas de la matriz de la lámina
-  if (fread(&lamina->n_filas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de filas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  if (fread(&lamina->n_columnas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de columnas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
+int leer_opciones(int argc, char* argv[], opciones_t* opciones) {
+  // Valores por omisión
+  opciones->bloque_temporal = 0;
+  opciones->laminas_concurrentes = 1;
+  opciones->cache_mb = CACHE_MB_OMISION;
+  opciones->arena_mb = ARENA_MB_OMISION;
+  opciones->agrupar_epsilon = 1;
+  opciones->control_iteraciones = 0;
+  opciones->control_segundos = 0;
+  opciones->reanudar = 0;
+  opciones->almacenamiento_simple = 0;
+  opciones->estrategia = buscar_estrategia("static-block");
+  opciones->equilibrio = 0;
+  opciones->comprimir = 0;
+  opciones->tuberia = 1;
+  opciones->omitir_quietas = 1;
+  opciones->lote = 0;
+  // Las opciones siguen al archivo de trabajo, los hilos y el prefijo
+  for (int indice = 4; indice < argc; ++indice) {
+    const char* opcion = argv[indice];
+    if (sscanf(opcion, "--time-block=%zu", &opciones->bloque_temporal) == 1) {
+      if (opciones->bloque_temporal > BLOQUE_TEMPORAL_MAX) {
+        opciones->bloque_temporal = BLOQUE_TEMPORAL_MAX;
+      }
+    } else if (sscanf(opcion, "--concurrent-plates=%zu",
+        &opciones->laminas_concurrentes) == 1) {
+      if (opciones->laminas_concurrentes == 0) {
+        opciones->laminas_concurrentes = 1;
+      }
+    } else if (sscanf(opcion, "--plate-cache=%zu", &opciones->cache_mb) == 1) {
+      // Cualquier valor es válido, 0 desactiva la caché
+    } else if (sscanf(opcion, "--buffer-arena=%zu", &opciones->arena_mb)
+        == 1) {
+      // Cualquier valor es válido, 0 desactiva la arena
+    } else if (sscanf(opcion, "--group-epsilon=%zu",
+        &opciones->agrupar_epsilon) == 1) {
+      // Cualquier valor distinto de 0 agrupa
+    } else if (sscanf(opcion, "--checkpoint-every=%zu",
+        &opciones->control_iteraciones) == 1) {
+    } else if (sscanf(opcion, "--checkpoint-seconds=%zu",
+        &opciones->control_segundos) == 1) {
+    } else if (sscanf(opcion, "--restart=%zu", &opciones->reanudar) == 1) {
+    } else if (sscanf(opcion, "--float-storage=%zu",
+        &opciones->almacenamiento_simple) == 1) {
+    } else if (strncmp(opcion, "--strategy=", strlen("--strategy=")) == 0) {
+      const char* nombre = opcion + strlen("--strategy=");
+      opciones->estrategia = buscar_estrategia(nombre);
+      if (opciones->estrategia == NULL && strcmp(nombre, "auto") != 0) {
+        fprintf(stderr, "Error: estrategia desconocida: %s\n", nombre);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(opcion, "--solver=stepping") == 0) {
+      opciones->equilibrio = 0;
+    } else if (strcmp(opcion, "--solver=equilibrium") == 0) {
+      opciones->equilibrio = 1;
+    } else if (sscanf(opcion, "--pipeline=%zu", &opciones->tuberia) == 1) {
+    } else if (sscanf(opcion, "--skip-quiescent=%zu",
+        &opciones->omitir_quietas) == 1) {
+    } else if (sscanf(opcion, "--batch-plates=%zu", &opciones->lote) == 1) {
+    } else if (strcmp(opcion, "--plate-format=raw") == 0) {
+      opciones->comprimir = 0;
+    } else if (strcmp(opcion, "--plate-format=compressed") == 0) {
+      opciones->comprimir = 1;
+    } else {
+      fprintf(stderr, "Error: opción desconocida: %s\n", opcion);
+      return EXIT_FAILURE;
+    }
   }
-  // Crea las matrices para el estado actual y el siguiente
-  lamina->matriz = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz == NULL) {
-    fprintf(stderr, "Error al crear la matriz 1");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
+  // Los puntos de control siguen una sola lámina a la vez
+  if (opciones->laminas_concurrentes > 1 && (opciones->control_iteraciones
+      || opciones->control_segundos || opciones->reanudar)) {
+    fprintf(stderr, "Error: los puntos de control requieren "
+      "--concurrent-plates=1\n");
+    return EXIT_FAILURE;
   }
-  lamina->matriz2 = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz2 == NULL) {
-    fprintf(stderr, "Error al crear la matriz 2");
-    liberar_matriz(lamina->matriz, lamina->n_filas);
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
+  // Los puntos de control guardan las matrices en double
+  if (opciones->almacenamiento_simple && (opciones->control_iteraciones
+      || opciones->control_segundos || opciones->reanudar)) {
+    fprintf(stderr, "Error: --float-storage no admite puntos de control\n");
+    return EXIT_FAILURE;
   }
-  // Lee los valores de la matriz
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    if (fread(lamina->matriz[i], sizeof(double), lamina->n_columnas,
-        archivo_lamina) == 0) {
-      fprintf(stderr, "Error: al leer valores de la matriz");
-      liberar_matriz(lamina->matriz, lamina->n_filas);
-      liberar_matriz(lamina->matriz2, lamina->n_filas);
-      fclose(archivo_lamina);
-      fclose(archivo_trabajo);
-      return false;
+  if (opciones->equilibrio) {
+    // El equilibrio se resuelve en segundos, no hace falta reanudarlo
+    if (opciones->control_iteraciones || opciones->control_segundos
+        || opciones->reanudar || opciones->almacenamiento_simple) {
+      fprintf(stderr, "Error: --solver=equilibrium no admite puntos de "
+        "control ni --float-storage\n");
+      return EXIT_FAILURE;
     }
-    // Copiar los datos de matriz a matriz2
-    memcpy(lamina->matriz2[i], lamina->matriz[i], sizeof(double) *
-      lamina->n_columnas);
+    // Cada línea se resuelve desde la lámina del archivo, así su resultado
+    // no depende de las líneas vecinas
+    opciones->agrupar_epsilon = 0;
   }
-  // Cierra el archivo de la lámina
-  fclose(archivo_lamina);
-  return true;
+  // Los carriles simulan paso a paso en double y varias láminas a la vez
+  // en un solo equipo
+  if (opciones->lote > 1 && (opciones->control_iteraciones
+      || opciones->control_segundos || opciones->reanudar
+      || opciones->almacenamiento_simple || opciones->equilibrio
+      || opciones->laminas_concurrentes > 1)) {
+    fprintf(stderr, "Error: --batch-plates no admite puntos de control, "
+      "--float-storage, --solver=equilibrium ni --concurrent-plates\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
 }
+
 bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   char* prefijo_ruta_trabajo, char* ruta_lamina) {
   // Verifica si el nombre de la lamina existe
@@ -165,13 +345,14 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   // Lee los datos de la lámina (tiempo, difusividad, distancia, epsilon)
   if (fscanf(archivo_trabajo, "%zu %lf %lf %lf", &lamina->tiempo,
         &lamina->difusividad, &lamina->distancia, &lamina->epsilon) < 4) {
-    liberar_matriz(lamina->matriz, lamina->n_filas);
+    liberar_matriz(lamina->matriz);
     fclose(archivo_trabajo);
     fprintf(stderr, "Error al leer datos de la lamina: %s\n",
       strerror(errno));
     return false;
   }
   lamina->iteraciones = 0;
+  lamina->residuo = -1.0;
   // Construye la ruta de la lamina
   if (snprintf(ruta_lamina, BUFFER_MAX, "%s/%s",
     prefijo_ruta_trabajo, lamina->nombre) >= (int) BUFFER_MAX) {
@@ -181,89 +362,341 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   return true;
 }
 int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp) {
+  const size_t pasos_bloque = preparar_lamina(lamina, mem_comp);
+  if (pasos_bloque == 0) {
+    return EXIT_FAILURE;
+  }
+  return avanzar_lamina(lamina, mem_comp, pasos_bloque);
+}
+
+// Copia la matriz de la lámina a las dos matrices en float, con el relleno
+// en cero, y calcula la resolución de float para sus valores
+static bool preparar_simple(const lamina_t* lamina, mem_comp_t* mem_comp) {
+  const size_t flotantes_linea = LINEA_CACHE / sizeof(float);
+  const size_t paso = (lamina->n_columnas + flotantes_linea - 1)
+      / flotantes_linea * flotantes_linea;
+  const size_t celdas = lamina->n_filas * paso;
+  if (mem_comp->capacidad_simple < celdas) {
+    for (size_t k = 0; k < 2; ++k) {
+      free(mem_comp->simple[k]);
+      mem_comp->simple[k] = (float*) aligned_alloc(LINEA_CACHE,
+        celdas * sizeof(float));
+    }
+    mem_comp->capacidad_simple = celdas;
+    if (mem_comp->simple[0] == NULL || mem_comp->simple[1] == NULL) {
+      fprintf(stderr, "Error: no hay memoria para las matrices en float de "
+        "%s\n", lamina->nombre);
+      free(mem_comp->simple[0]);
+      free(mem_comp->simple[1]);
+      mem_comp->simple[0] = mem_comp->simple[1] = NULL;
+      mem_comp->capacidad_simple = 0;
+      return false;
+    }
+  }
+  mem_comp->paso_simple = paso;
+  double mayor = 0.0;
+  for (size_t i = 0; i < lamina->n_filas; ++i) {
+    const double* fila = lamina->matriz + i * lamina->paso;
+    float* destino = mem_comp->simple[0] + i * paso;
+    for (size_t j = 0; j < lamina->n_columnas; ++j) {
+      destino[j] = (float) fila[j];
+      mayor = fabs(fila[j]) > mayor ? fabs(fila[j]) : mayor;
+    }
+    memset(destino + lamina->n_columnas, 0,
+      (paso - lamina->n_columnas) * sizeof(float));
+  }
+  // Los bordes de ambas matrices son los mismos
+  memcpy(mem_comp->simple[1], mem_comp->simple[0], celdas * sizeof(float));
+  mem_comp->resolucion_simple = mayor * FLT_EPSILON;
+  return true;
+}
+
+// Copia el estado en float a la matriz de la lámina. Los bordes no cambian
+// y conservan su valor en double
+static void devolver_simple(lamina_t* lamina, const mem_comp_t* mem_comp) {
+  for (size_t i = 1; i < lamina->n_filas - 1; ++i) {
+    double* destino = lamina->matriz + i * lamina->paso;
+    const float* origen = mem_comp->simple[0] + i * mem_comp->paso_simple;
+    for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
+      destino[j] = origen[j];
+    }
+  }
+}
+
+size_t tamano_cache_l2(void) {
+  long cache = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+  if (cache <= 0) {
+    cache = CACHE_L2_OMISION;
+  }
+  return (size_t) cache;
+}
+
+size_t preparar_lamina(lamina_t* lamina, mem_comp_t* mem_comp) {
   // Suponemos que la lámina no está en equilibrio
-  double max_temp = lamina->epsilon + 1;
-  // Actualizar filas internas e hilos según los datos de la lamina
-  mem_comp->filas_internas = lamina->n_filas - 2;
-  mem_comp->hilos_totales = mem_comp->hilos_totales < mem_comp->filas_internas
-      ? mem_comp->hilos_totales : mem_comp->filas_internas;
+  mem_comp->max_temp = DBL_MAX;
+  // Actualizar filas internas e hilos según los datos de la lamina, sin
+  // modificar el equipo. Una lámina de menos de 3 filas no tiene interior
+  mem_comp->filas_internas = lamina->n_filas > 2 ? lamina->n_filas - 2 : 0;
+  const size_t hilos_lamina = mem_comp->hilos_lamina
+      < mem_comp->equipo.hilos_totales ? mem_comp->hilos_lamina
+      : mem_comp->equipo.hilos_totales;
+  mem_comp->coeficiente = (lamina->tiempo * lamina->difusividad)
+      /(lamina->distancia * lamina->distancia);
+  // La estrategia reparte la lámina entre los hilos, en auto entre los que
+  // elige el modelo de costo
+  size_t hilos = hilos_lamina;
+  mem_comp->estrategia = elegir_estrategia(mem_comp, lamina, &hilos);
+  mem_comp->estrategia->repartir(lamina, mem_comp, hilos);
+  registrar_hilos(&mem_comp->costo, lamina->nombre, mem_comp->filas_internas
+    * (lamina->n_columnas > 2 ? lamina->n_columnas - 2 : 0),
+    mem_comp->estrategia->nombre, mem_comp->hilos_totales);
+  if (mem_comp->opciones->almacenamiento_simple
+      && !preparar_simple(lamina, mem_comp)) {
+    return 0;
+  }
+  // Pasos que avanza cada bloque temporal, 1 si no se usan bloques
+  const size_t pasos_bloque = preparar_bloque_temporal(lamina, mem_comp);
+  // Las teselas se siguen de una iteración a la siguiente, no dentro de un
+  // bloque temporal. Una lámina sin interior no tiene teselas
+  mem_comp->teselas.activas = false;
+  if (pasos_bloque == 1 && mem_comp->opciones->omitir_quietas
+      && mem_comp->estrategia->teselas && mem_comp->hilos_totales > 0
+      && lamina->n_filas > 2 && lamina->n_columnas > 2) {
+    mem_comp->teselas.activas = preparar_teselas(lamina, mem_comp);
+    if (!mem_comp->teselas.activas) {
+      fprintf(stderr, "Error: no hay memoria para las teselas\n");
+    }
+  }
+  return pasos_bloque;
+}
+
+int avanzar_lamina(lamina_t* lamina, mem_comp_t* mem_comp,
+    size_t pasos_bloque) {
   // Punteros a las matrices
-  double **matriz = lamina->matriz;
-  double **matriz2 = lamina->matriz2;
-  int error = 0;
+  double *matriz = lamina->matriz;
+  double *matriz2 = lamina->matriz2;
+  const double epsilon = lamina->epsilon;
+  const bool simple = mem_comp->opciones->almacenamiento_simple != 0;
+  // En float los cambios menores a la resolución se pierden al redondear
+  if (simple && epsilon < mem_comp->resolucion_simple) {
+    fprintf(stderr, "Error: epsilon %lg de %s es menor que la resolución "
+      "de float %lg\n", epsilon, lamina->nombre,
+      mem_comp->resolucion_simple);
+    return EXIT_FAILURE;
+  }
   // Hasta que se equilibre.
-  while (max_temp > lamina->epsilon) {
-    double max_temp_iter = 0.0;
-    // Crear los hilos
-    error = crear_hilos(mem_comp);
-    // llenar la matriz de lamina_2 segun la relación,ignorando bordes
-    for (size_t i = 1; i < lamina->n_filas - 1; i++) {
-      for (size_t j = 1; j < lamina->n_columnas - 1; j++) {
-        double cambio_temp = lamina->matriz[i][j]-lamina->matriz2[i][j];
-        cambio_temp = (cambio_temp < 0.0) ? -cambio_temp : cambio_temp;
-        // tomar el maximo cambio de la iteracion
-        if (max_temp_iter < cambio_temp) {
-          max_temp_iter = cambio_temp;
+  while (mem_comp->max_temp > epsilon) {
+    size_t avance = 1;
+    if (pasos_bloque > 1) {
+      avance = avanzar_bloque(mem_comp, pasos_bloque);
+    } else {
+      // Despertar al equipo, cada hilo calcula su parte según la estrategia
+      // y su cambio máximo. El despacho ordena la escritura de fila_libre
+      atomic_store_explicit(&mem_comp->fila_libre, 1, memory_order_relaxed);
+      if (mem_comp->teselas.activas) {
+        ejecutar_hilos(mem_comp, calculo_teselas);
+        alternar_teselas(&mem_comp->teselas);
+      } else {
+        ejecutar_hilos(mem_comp, mem_comp->estrategia->calcular);
+      }
+      // Combinar los máximos de los hilos. Solo importa si alguno supera
+      // epsilon, por lo que se deja de comparar con el primero que lo haga
+      mem_comp->max_temp = 0.0;
+      for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
+          && mem_comp->max_temp <= epsilon; ++num_hilo) {
+        if (mem_comp->mem_priv[num_hilo].p_max_temp > mem_comp->max_temp) {
+          mem_comp->max_temp = mem_comp->mem_priv[num_hilo].p_max_temp;
         }
       }
     }
   intercambiar_matriz(&matriz, &matriz2);
+  if (simple) {
+    float* siguiente = mem_comp->simple[1];
+    mem_comp->simple[1] = mem_comp->simple[0];
+    mem_comp->simple[0] = siguiente;
+  }
   lamina->matriz = matriz;
   lamina->matriz2 = matriz2;
-  max_temp = max_temp_iter;
-  lamina->iteraciones++;
+  lamina->iteraciones += avance;
+  if (mem_comp->punto_control && revisar_punto_control(
+      mem_comp->punto_control, lamina, mem_comp->max_temp) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
   }
-  return error;
+  }
+  if (simple) {
+    devolver_simple(lamina, mem_comp);
+  }
+  return EXIT_SUCCESS;
+}
+
+void ejecutar_hilos(mem_comp_t* mem_comp, void* (*rutina)(void*)) {
+  if (mem_comp->hilos_totales <= 1) {
+    rutina(&mem_comp->mem_priv[0]);
+  } else {
+    despachar_equipo(&mem_comp->equipo, rutina, mem_comp->mem_priv,
+      sizeof(mem_priv_t), mem_comp->hilos_totales);
+  }
+}
+
+size_t preparar_bloque_temporal(lamina_t* lamina, mem_comp_t* mem_comp) {
+  size_t pasos = mem_comp->opciones->bloque_temporal;
+  // Los bloques temporales trabajan sobre las matrices en double y sobre
+  // bloques de filas completas
+  if (pasos < 2 || mem_comp->hilos_totales == 0
+      || !mem_comp->estrategia->bloques_temporales
+      || mem_comp->hilos_columnas > 1
+      || mem_comp->opciones->almacenamiento_simple) {
+    return 1;
+  }
+  // Las dos matrices auxiliares de cada hilo deben caber en la mitad de L2
+  const size_t filas_cache = tamano_cache_l2() / 2
+      / (2 * lamina->paso * sizeof(double));
+  // El halo agrega 2 * pasos filas, se reducen los pasos hasta que el bloque
+  // tenga al menos el doble de filas propias que de halo
+  while (pasos > 1 && filas_cache < 4 * pasos) {
+    pasos /= 2;
+  }
+  if (pasos < 2) {
+    return 1;
+  }
+  // No hace falta que el bloque sea más alto que las filas de un hilo
+  size_t alto = filas_cache - 2 * pasos;
+  const size_t filas_hilo = mem_comp->mem_priv[0].fila_final
+      - mem_comp->mem_priv[0].fila_inicio;
+  alto = alto < filas_hilo ? alto : filas_hilo;
+  mem_comp->alto_bloque = alto;
+  // Cada hilo conserva su memoria auxiliar si ya alcanza
+  const size_t filas_auxiliar = 2 * (alto + 2 * pasos);
+  for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales; ++num_hilo) {
+    mem_priv_t* mem_priv = &mem_comp->mem_priv[num_hilo];
+    if (mem_priv->capacidad_auxiliar < filas_auxiliar * lamina->paso) {
+      liberar_matriz(mem_priv->auxiliar);
+      mem_priv->capacidad_auxiliar = 0;
+      mem_priv->auxiliar = crear_matriz(filas_auxiliar, lamina->paso);
+      if (mem_priv->auxiliar == NULL) {
+        fprintf(stderr, "Error: no hay memoria para bloques temporales\n");
+        return 1;
+      }
+      mem_priv->capacidad_auxiliar = filas_auxiliar * lamina->paso;
+    }
+  }
+  return pasos;
 }
 
-void* calculo_matriz(void* mem) {
-  // punteros a structs de memoria privada y compartida, y a la lamina
+size_t avanzar_bloque(mem_comp_t* mem_comp, size_t pasos) {
+  const double epsilon = mem_comp->lamina->epsilon;
+  mem_comp->pasos_bloque = pasos;
+  ejecutar_hilos(mem_comp, calculo_bloque);
+  // Buscar el primer paso del bloque en el que se llegó al equilibrio,
+  // igual que si cada paso fuera una iteración
+  size_t avance = pasos;
+  for (size_t paso = 0; paso < pasos; ++paso) {
+    mem_comp->max_temp = 0.0;
+    for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
+        && mem_comp->max_temp <= epsilon; ++num_hilo) {
+      const double p_max = mem_comp->mem_priv[num_hilo].p_max_bloque[paso];
+      if (p_max > mem_comp->max_temp) {
+        mem_comp->max_temp = p_max;
+      }
+    }
+    if (mem_comp->max_temp <= epsilon) {
+      avance = paso + 1;
+      break;
+    }
+  }
+  // matriz aún tiene el estado del inicio del bloque, se repite el bloque
+  // solo hasta el paso de equilibrio para que matriz2 quede en ese estado
+  if (avance < pasos) {
+    mem_comp->pasos_bloque = avance;
+    ejecutar_hilos(mem_comp, calculo_bloque);
+  }
+  return avance;
+}
+
+void* calculo_bloque(void* mem) {
   mem_priv_t* mem_priv = (mem_priv_t*) mem;
   mem_comp_t* mem_comp = mem_priv->mem_comp;
   lamina_t* lamina = mem_comp->lamina;
-  // coeficiente de difusión térmica
-  double coeficiente = (lamina->tiempo * lamina->difusividad)
-      /(lamina->distancia * lamina->distancia);
-
-  // distribución de filas entre los hilos
-  size_t filas_por_hilo = mem_comp->filas_internas / mem_comp->hilos_totales;
-  size_t extra = mem_comp->filas_internas % mem_comp->hilos_totales;
-
-  // filas que debe tomar el hilo actual
-  size_t fila_inicio = mem_priv->num_hilo * filas_por_hilo +
-      (mem_priv->num_hilo < extra ? mem_priv->num_hilo : extra) + 1;
-  size_t fila_final = fila_inicio + filas_por_hilo +
-      (mem_priv->num_hilo  < extra ? 1 : 0);
-  // llenar la matriz de lamina_2 segun la relación,ignorando bordes
-  for (size_t i = fila_inicio; i < fila_final; i++) {
-    for (size_t j = 1; j < lamina->n_columnas-1; j++) {
-      lamina->matriz2[i][j] =  lamina->matriz[i][j] + (coeficiente
-        *(lamina->matriz[i - 1][j]+ lamina->matriz[i][j + 1]
-        + lamina->matriz[i + 1][j]+ lamina->matriz[i][j - 1]
-        - (4 * lamina->matriz[i][j])));
+  const size_t pasos = mem_comp->pasos_bloque;
+  const size_t paso = lamina->paso;
+  const size_t n_filas = lamina->n_filas;
+  for (size_t k = 0; k < pasos; ++k) {
+    mem_priv->p_max_bloque[k] = 0.0;
+  }
+  for (size_t inicio = mem_priv->fila_inicio; inicio < mem_priv->fila_final;
+      inicio += mem_comp->alto_bloque) {
+    const size_t final = inicio + mem_comp->alto_bloque < mem_priv->fila_final
+        ? inicio + mem_comp->alto_bloque : mem_priv->fila_final;
+    // Filas del bloque más un halo de pasos filas por lado, sin salir de la
+    // lámina. Los bordes de la lámina no cambian
+    const size_t primera = inicio > pasos ? inicio - pasos : 0;
+    const size_t ultima = final + pasos < n_filas ? final + pasos : n_filas;
+    const size_t filas = ultima - primera;
+    double* origen = mem_priv->auxiliar;
+    double* destino = origen + filas * paso;
+    memcpy(origen, lamina->matriz + primera * paso,
+      filas * paso * sizeof(double));
+    memcpy(destino, origen, filas * paso * sizeof(double));
+    for (size_t k = 1; k <= pasos; ++k) {
+      // Filas que aún tienen vecinos válidos en el paso anterior. Todas son
+      // valores exactos del paso k, así que su cambio cuenta para el máximo
+      const size_t desde = inicio + k > pasos + 1 ? inicio + k - pasos : 1;
+      const size_t hasta = final + pasos - k < n_filas - 1
+          ? final + pasos - k : n_filas - 1;
+      const double cambio_temp = calcular_filas(origen, destino, paso,
+        lamina->n_columnas, desde - primera, hasta - primera,
+        mem_comp->coeficiente);
+      if (cambio_temp > mem_priv->p_max_bloque[k - 1]) {
+        mem_priv->p_max_bloque[k - 1] = cambio_temp;
+      }
+      intercambiar_matriz(&origen, &destino);
     }
+    // Las filas propias quedan en matriz2 con el estado del último paso
+    memcpy(lamina->matriz2 + inicio * paso, origen + (inicio - primera) * paso,
+      (final - inicio) * paso * sizeof(double));
   }
   return NULL;
 }
 
 int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
-    lamina_t* lamina) {
+    lamina_t* lamina, bool comprimir) {
+  reportar_fila(archivo_salida, lamina);
+  return guardar_lamina(prefijo_ruta_trabajo, lamina, comprimir, NULL, 1);
+}
+
+void reportar_fila(FILE* archivo_salida, const lamina_t* lamina) {
   // Guarda el tiempo de la simulación
   char duracion[BUFFER_MAX] = {0};
   format_time(lamina->tiempo * lamina->iteraciones, duracion);
+  if (lamina->residuo >= 0.0) {
+    // El equilibrio no tiene duración: se reportan las iteraciones del
+    // solucionador y el residuo
+    fprintf(archivo_salida, "%s\t%zu\t%lg\t%lg\t%lg\tequilibrium\t%zu\t%lg\n",
+        lamina->nombre, lamina->tiempo, lamina->difusividad,
+        lamina->distancia, lamina->epsilon, lamina->iteraciones,
+        lamina->residuo);
+    return;
+  }
 
   // Escribe los datos de la lámina en el archivo de salida
   fprintf(archivo_salida, "%s\t%zu\t%lg\t%lg\t%lg\t%zu\t%s\n",
       lamina->nombre, lamina->tiempo, lamina->difusividad,
       lamina->distancia, lamina->epsilon, lamina->iteraciones, duracion);
-  fflush(archivo_salida);
+}
+
+int guardar_lamina(char* prefijo_ruta_trabajo, const lamina_t* lamina,
+    bool comprimir, equipo_t* equipo, size_t hilos) {
   // nombre del archivo sin extensión
   char nombre_reporte_lamina[BUFFER_MAX] = {0};
   quitar_extension(lamina->nombre, nombre_reporte_lamina);
 
   // Genera el nombre del archivo binario con el número de iteraciones
   char r_lamina_bin[BUFFER_MAX] = {0};
-  if (snprintf(r_lamina_bin, BUFFER_MAX, "%s-%zu.bin", nombre_reporte_lamina,
+  if (snprintf(r_lamina_bin, BUFFER_MAX, lamina->residuo >= 0.0
+      ? "%s-equilibrium-%zu.bin" : "%s-%zu.bin", nombre_reporte_lamina,
       lamina->iteraciones) >= (int) sizeof(r_lamina_bin)) {
     fprintf(stderr, "Error: r_lamina_bin truncada\n");
     return false;
@@ -277,65 +710,54 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
     return false;
     }
 
-  // Abre el archivo binario para escritura
-  FILE* archivo_bin_lamina = fopen(ruta_r_lamina, "wb");
-  if (archivo_bin_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n",
-      ruta_r_lamina, strerror(errno));
+  // Escribe el encabezado y las filas, sin el relleno, en bloque, o los
+  // bloques comprimidos por el equipo
+  if (!escribir_lamina(ruta_r_lamina, lamina->n_filas, lamina->n_columnas,
+      lamina->paso, lamina->matriz, comprimir, equipo, hilos)) {
     return EXIT_FAILURE;
   }
-  // Escribe el número de filas y columnas en el archivo binario
-  fwrite(&lamina->n_filas, sizeof(size_t), 1, archivo_bin_lamina);
-  fwrite(&lamina->n_columnas, sizeof(size_t), 1, archivo_bin_lamina);
-  // Escribe los valores de la matriz en el archivo binario
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    for (size_t j = 0; j < lamina->n_columnas; ++j) {
-      fwrite(&lamina->matriz[i][j], sizeof(double), 1, archivo_bin_lamina);
-    }
-  }
-
-  // Cierra el archivo binario
-  fclose(archivo_bin_lamina);
 
   return EXIT_SUCCESS;
 }
-int crear_hilos(mem_comp_t* mem_comp) {
-  int error = EXIT_SUCCESS;
-  // Reservar memoria para estructuras de los hilos
-  pthread_t* hilos = (pthread_t*)
-    malloc(mem_comp->hilos_totales * sizeof(pthread_t));
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales,
+    size_t primer_hilo) {
   // Memoria privada de cada hilo
-  mem_priv_t* mem_priv = (mem_priv_t*)
-    calloc(mem_comp->hilos_totales, sizeof(mem_priv_t));
-  if (hilos && mem_priv) {
-    // Inicializar atributos privados
-    for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
-        ; ++num_hilo) {
-      mem_priv[num_hilo].num_hilo = num_hilo;
-      mem_priv[num_hilo].mem_comp = mem_comp;
-      // crea los hilos que ejecutaran la rutina del cambio de temperatura.
-      error = pthread_create(&hilos[num_hilo], /*attr*/ NULL, calculo_matriz
-        , /*arg*/ &mem_priv[num_hilo]);
-      if (error == EXIT_SUCCESS) {
-      } else {
-        fprintf(stderr, "Error: could not create secondary thread\n");
-        error = 1;
-        break;
-      }
-    }
-    // Esperar a que todos los hilos terminen su ejecución
-    for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
-        ; ++num_hilo) {
-      pthread_join(hilos[num_hilo], /*value_ptr*/ NULL);
-    }
-    // Liberar memoria reservada
-    free(mem_priv);
-    free(hilos);
-  } else {
-    fprintf(stderr, "Error: could not allocate %zu hilos\n"
-      , mem_comp->hilos_totales);
-    error = 1;
+  mem_comp->mem_priv = (mem_priv_t*) calloc(hilos_totales, sizeof(mem_priv_t));
+  if (mem_comp->mem_priv == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu hilos\n", hilos_totales);
+    return EXIT_FAILURE;
   }
-
-  return error;
+  // Inicializar atributos privados
+  for (size_t num_hilo = 0; num_hilo < hilos_totales; ++num_hilo) {
+    mem_comp->mem_priv[num_hilo].num_hilo = num_hilo;
+    mem_comp->mem_priv[num_hilo].mem_comp = mem_comp;
+  }
+  // Crea los hilos, quedan esperando a que se les despache trabajo
+  if (crear_equipo(&mem_comp->equipo, hilos_totales,
+      &mem_comp->opciones->afinidad, primer_hilo) != EXIT_SUCCESS) {
+    free(mem_comp->mem_priv);
+    return EXIT_FAILURE;
+  }
+  // El costo del estencil y de despertar al equipo se mide una vez
+  medir_costo(&mem_comp->costo, &mem_comp->equipo);
+  // Por omisión cada lámina puede usar todo el equipo
+  mem_comp->hilos_lamina = hilos_totales;
+  mem_comp->estrategia = NULL;
+  atomic_init(&mem_comp->fila_libre, 1);
+  // Las matrices en float se reservan con la primera lámina que las use
+  mem_comp->simple[0] = mem_comp->simple[1] = NULL;
+  mem_comp->capacidad_simple = 0;
+  iniciar_teselas(&mem_comp->teselas);
+  return EXIT_SUCCESS;
+}
+void liberar_hilos(mem_comp_t* mem_comp) {
+  for (size_t num_hilo = 0; num_hilo < mem_comp->equipo.hilos_totales;
+      ++num_hilo) {
+    liberar_matriz(mem_comp->mem_priv[num_hilo].auxiliar);
+  }
+  destruir_equipo(&mem_comp->equipo);
+  free(mem_comp->mem_priv);
+  free(mem_comp->simple[0]);
+  free(mem_comp->simple[1]);
+  liberar_teselas(&mem_comp->teselas);
 }
@@ -5,8 +5,14 @@
 #include <errno.h>
 #include <float.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <unistd.h>
+#include "cache.h"
+#include "costo.h"
+#include "equipo.h"
+#include "estencil.h"
 #include "miscelaneos.h"
+#include "teselas.h"
 /**
  * @brief Estructura de datos que representa una lámina de material para
  * almacenar la información relevante.
@@ -27,13 +33,19 @@ typedef struct {
    */
   size_t n_columnas;
   /**
-   * @brief La matriz con el estado actual de lámina
+   * @brief Cantidad de doubles entre el inicio de dos filas consecutivas,
+   * múltiplo de la línea de caché
    */
-  double** matriz;
+  size_t paso;
+  /**
+   * @brief La matriz con el estado actual de lámina, la celda (i, j) está en
+   * matriz[i * paso + j]. Las filas y columnas del borde sirven de halo
+   */
+  double* matriz;
   /**
    * @brief La matriz con el estado siguiente
    */
-  double** matriz2;
+  double* matriz2;
   /**
    * @brief Punto de equilibrio, cuando el cambio de cada una las celdas en
    * una iteración es menor al punto de equilibrio, termina la simulación
@@ -56,7 +68,113 @@ typedef struct {
    */
   //
   size_t iteraciones;
+  /**
+   * @brief Con --solver=equilibrium, mayor diferencia entre una celda interna
+   * y el promedio de sus vecinas en la lámina resultante. Negativo si la
+   * lámina se simuló paso a paso
+   */
+  double residuo;
 } lamina_t;
+/**
+ * @brief Máximo de pasos de tiempo que puede avanzar un bloque temporal
+ */
+#define BLOQUE_TEMPORAL_MAX 64
+/**
+ * @brief Tamaño de la caché L2 que se supone si el sistema no lo reporta
+ */
+#define CACHE_L2_OMISION (1024L * 1024L)
+typedef struct estrategia estrategia_t;
+/**
+ * @brief Opciones opcionales de la línea de comandos, de la forma
+ * --nombre=valor después de los tres argumentos obligatorios.
+ */
+typedef struct {
+  /**
+   * @brief Pasos de tiempo que avanza cada bloque de filas mientras está en
+   * la caché L2 (--time-block=N). Con 0 o 1 cada iteración recorre toda la
+   * lámina
+   */
+  size_t bloque_temporal;
+  /**
+   * @brief Láminas del archivo de trabajo que se simulan a la vez
+   * (--concurrent-plates=N), a lo sumo la cantidad de hilos. Con 0 o 1 se
+   * simulan una tras otra
+   */
+  size_t laminas_concurrentes;
+  /**
+   * @brief Megabytes que puede ocupar la caché de láminas iniciales
+   * (--plate-cache=MB), 0 la desactiva
+   */
+  size_t cache_mb;
+  /**
+   * @brief Megabytes de matrices libres que conserva la arena para las
+   * líneas siguientes (--buffer-arena=MB), 0 la desactiva
+   */
+  size_t arena_mb;
+  /**
+   * @brief Si no es 0, las líneas consecutivas que solo difieren en epsilon
+   * se simulan una sola vez (--group-epsilon=0|1). Por omisión 1
+   */
+  size_t agrupar_epsilon;
+  /**
+   * @brief Iteraciones entre puntos de control (--checkpoint-every=N), 0 no
+   * los guarda por iteraciones
+   */
+  size_t control_iteraciones;
+  /**
+   * @brief Segundos entre puntos de control (--checkpoint-seconds=S), 0 no
+   * los guarda por tiempo
+   */
+  size_t control_segundos;
+  /**
+   * @brief Si no es 0, continúa desde el último punto de control válido
+   * (--restart=0|1)
+   */
+  size_t reanudar;
+  /**
+   * @brief Si no es 0, las matrices de trabajo se guardan en float y cada
+   * celda se calcula en double (--float-storage=0|1)
+   */
+  size_t almacenamiento_simple;
+  /**
+   * @brief Estrategia con que se reparte cada lámina entre los hilos
+   * (--strategy=nombre), NULL para elegirla según la lámina (auto)
+   */
+  const estrategia_t* estrategia;
+  /**
+   * @brief Si no es 0, cada línea resuelve directamente el estado de
+   * equilibrio en vez de simular paso a paso (--solver=equilibrium)
+   */
+  size_t equilibrio;
+  /**
+   * @brief Si no es 0, las láminas resultantes se escriben comprimidas
+   * (--plate-format=compressed)
+   */
+  size_t comprimir;
+  /**
+   * @brief Si no es 0, la carga, el cálculo y la escritura de una lámina a
+   * la vez corren en hilos distintos (--pipeline=0|1)
+   */
+  size_t tuberia;
+  /**
+   * @brief Si no es 0, las teselas que no pueden cambiar no se calculan
+   * (--skip-quiescent=0|1). Por omisión 1
+   */
+  size_t omitir_quietas;
+  /**
+   * @brief Líneas consecutivas con láminas pequeñas que se acumulan para
+   * simularlas juntas en carriles (--batch-plates=N). Con 0 o 1 cada lámina
+   * se simula sola
+   */
+  size_t lote;
+  /**
+   * @brief CPU a la que se fija cada hilo de los equipos, leídas de
+   * AFINIDAD_ENTORNO
+   */
+  afinidad_t afinidad;
+} opciones_t;
+typedef struct mem_priv mem_priv_t;
+typedef struct punto_control punto_control_t;
 /**
  * @brief Estructura de datos qque representa la memoria compartida entre
  * los hilos creados
@@ -71,24 +189,172 @@ typedef struct {
    */
   size_t filas_internas;
   /**
-  * @brief Número de hilos que ejecutaran los cálculos
+  * @brief Número de hilos que ejecutaran los cálculos en la lámina actual,
+  * según la estrategia, a lo sumo hilos_lamina
   */
   size_t hilos_totales;
+  /**
+  * @brief Bloques en que se dividen las filas internas de la lámina actual.
+  * En cyclic y dynamic es hilos_totales
+  */
+  size_t hilos_filas;
+  /**
+  * @brief Bloques en que se dividen las columnas internas de la lámina
+  * actual, más de uno solo en static-block si hay menos filas internas que
+  * hilos
+  */
+  size_t hilos_columnas;
+  /**
+  * @brief Columnas de cada franja en que un hilo recorre su bloque, para
+  * que las filas que lee y escribe el estencil quepan en L2
+  */
+  size_t ancho_franja;
+  /**
+  * @brief Estrategia de la lámina actual
+  */
+  const estrategia_t* estrategia;
+  /**
+  * @brief Primera fila que aún no toma ningún hilo en la iteración actual,
+  * para la estrategia dynamic
+  */
+  atomic_size_t fila_libre;
+  /**
+  * @brief Filas mínimas de cada trozo de la estrategia dynamic
+  */
+  size_t trozo_minimo;
+  /**
+  * @brief Hilos del equipo que puede usar la lámina actual, los demás siguen
+  * estacionados
+  */
+  size_t hilos_lamina;
+  /**
+  * @brief Costos medidos al crear el equipo, con los que auto elige los
+  * hilos de cada lámina
+  */
+  costo_t costo;
+  /**
+  * @brief Coeficiente de difusión térmica de la lámina actual
+  */
+  double coeficiente;
+  /**
+  * @brief Pasos de tiempo que avanza el despacho actual de calculo_bloque()
+  */
+  size_t pasos_bloque;
+  /**
+  * @brief Filas propias de cada bloque temporal, sin contar el halo
+  */
+  size_t alto_bloque;
+  /**
+  * @brief Opciones de la línea de comandos
+  */
+  const opciones_t* opciones;
+  /**
+  * @brief Equipo de hilos creado una vez para todas las láminas
+  */
+  equipo_t equipo;
+  /**
+  * @brief Memoria privada de cada hilo del equipo
+  */
+  mem_priv_t* mem_priv;
+  /**
+  * @brief Mayor cambio de temperatura de la última iteración. Si es mayor a
+  * epsilon puede ser solo el de un hilo, basta para saber que no se llegó al
+  * equilibrio
+  */
+  double max_temp;
+  /**
+  * @brief Puntos de control de la simulación secuencial, NULL si no se
+  * guardan
+  */
+  punto_control_t* punto_control;
+  /**
+  * @brief Estado actual y siguiente en float con --float-storage, crecen
+  * según las láminas y se reutilizan
+  */
+  float* simple[2];
+  /**
+  * @brief Cantidad de float reservados en cada matriz de simple
+  */
+  size_t capacidad_simple;
+  /**
+  * @brief Paso de las filas de las matrices de simple
+  */
+  size_t paso_simple;
+  /**
+  * @brief Menor epsilon que se puede alcanzar en float: el mayor valor
+  * absoluto de la lámina por FLT_EPSILON
+  */
+  double resolucion_simple;
+  /**
+  * @brief Teselas de la lámina actual con --skip-quiescent, su memoria
+  * crece según las láminas y se reutiliza
+  */
+  teselas_t teselas;
 } mem_comp_t;
 /**
  * @brief Estructura de datos qque representa la memoria privada de cada
  * hilo
  */
-typedef struct {
+struct mem_priv {
   /**
   * @brief Identificador del hilo
   */
   size_t num_hilo;
   /**
+  * @brief Primera fila que calcula el hilo en la lámina actual
+  */
+  size_t fila_inicio;
+  /**
+  * @brief Fila siguiente a la última que calcula el hilo
+  */
+  size_t fila_final;
+  /**
+  * @brief Primera columna que calcula el hilo en la lámina actual
+  */
+  size_t columna_inicio;
+  /**
+  * @brief Columna siguiente a la última que calcula el hilo
+  */
+  size_t columna_final;
+  /**
+  * @brief Primera fila de teselas del bloque del hilo
+  */
+  size_t tesela_fila_inicio;
+  /**
+  * @brief Fila de teselas siguiente a la última del bloque del hilo
+  */
+  size_t tesela_fila_final;
+  /**
+  * @brief Primera columna de teselas del bloque del hilo
+  */
+  size_t tesela_columna_inicio;
+  /**
+  * @brief Columna de teselas siguiente a la última del bloque del hilo
+  */
+  size_t tesela_columna_final;
+  /**
+  * @brief Mayor cambio de temperatura en las filas del hilo
+  */
+  double p_max_temp;
+  /**
+  * @brief Mayor cambio de temperatura del hilo en cada paso del último
+  * bloque temporal
+  */
+  double p_max_bloque[BLOQUE_TEMPORAL_MAX];
+  /**
+  * @brief Dos matrices auxiliares donde el hilo avanza cada bloque
+  * temporal, crece según las láminas y se reutiliza
+  */
+  double* auxiliar;
+  /**
+  * @brief Cantidad de doubles reservados en auxiliar
+  */
+  size_t capacidad_auxiliar;
+  /**
   * @brief Puntero al registro de la memoria compartida
   */
   mem_comp_t* mem_comp;
-} mem_priv_t;
+};
 /**
  * @brief Estructura que contiene las rutas y archivos para la simulación.
  *
@@ -108,6 +374,10 @@ typedef struct {
    * @brief Puntero al archivo de salida
    */
   FILE* archivo_salida;
+  /**
+   * @brief Ruta del punto de control del trabajo
+   */
+  char ruta_punto_control[BUFFER_MAX];
 } archivos_t;
 /**
  * @brief Función principal que inicia la simulacion.
@@ -124,6 +394,43 @@ typedef struct {
  * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
  */
 int iniciar_simul(int argc, char* argv[]);
+/**
+ * @brief Simula las láminas del archivo de trabajo una tras otra.
+ *
+ * Un solo equipo de hilos_usuario hilos calcula cada grupo de líneas (ver
+ * leer_grupo()) y el reporte se escribe apenas termina.
+ *
+ * @param archivos Archivos de trabajo y de salida ya abiertos.
+ * @param opciones Opciones de la línea de comandos.
+ * @param hilos_usuario Hilos que indicó el usuario.
+ * @param cache Caché de láminas iniciales.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int simular_secuencial(archivos_t* archivos, const opciones_t* opciones,
+  size_t hilos_usuario, cache_t* cache);
+/**
+ * @brief Contexto con que guardar_linea() guarda cada línea de un grupo
+ */
+typedef struct {
+  /**
+   * @brief Archivos de la simulación
+   */
+  archivos_t* archivos;
+  /**
+   * @brief Su equipo, estacionado mientras se guarda, comprime la lámina
+   */
+  mem_comp_t* mem_comp;
+} guardado_t;
+/**
+ * @brief Guarda el resultado de una línea de un grupo al alcanzar su
+ * epsilon, ver procesar_grupo().
+ *
+ * @param contexto Un guardado_t.
+ * @param linea Posición de la línea en el grupo.
+ * @param lamina Lámina en equilibrio para la línea.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int guardar_linea(void* contexto, size_t linea, const lamina_t* lamina);
 /**
  * @brief Función que analiza los argumentos de linea de comando y abre los
  * archivos de entrada y salida.
@@ -131,9 +438,22 @@ int iniciar_simul(int argc, char* argv[]);
  * @param argc Número de argumentos de la línea de comandos.
  * @param argv Arreglo que contiene los argumentos.
  * @param archivos Puntero al struct de los archivos
+ * @param reanudar Si es verdadero el archivo de salida no se trunca, el
+ * punto de control indica hasta dónde es válido.
  * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
  */
-int preparar_archivos(int argc, char* argv[], archivos_t* archivos);
+int preparar_archivos(int argc, char* argv[], archivos_t* archivos,
+  bool reanudar);
+/**
+ * @brief Lee las opciones que siguen a los argumentos obligatorios.
+ *
+ * @param argc Número de argumentos de la línea de comandos.
+ * @param argv Arreglo que contiene los argumentos.
+ * @param opciones Opciones a llenar, las ausentes quedan con su valor por
+ * omisión.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int leer_opciones(int argc, char* argv[], opciones_t* opciones);
 /**
  * @brief Se encarga de tomar los datos del archivo de trabajo que se necesitaran para la simulación
  * 
@@ -145,23 +465,18 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos);
  */
 
 /**
-* @brief Función para actualizar la temperatura de la fila 
-* de la lamina asignada a un hilo.
+* @brief Función para avanzar varios pasos de tiempo las filas de un hilo.
+*
+* Las filas del hilo se dividen en bloques de alto_bloque filas. Cada bloque
+* se copia con un halo de pasos_bloque filas a la memoria auxiliar del hilo,
+* que cabe en la caché L2, y ahí avanza pasos_bloque pasos; el halo se
+* reduce una fila por lado en cada paso. Las filas propias del bloque se
+* escriben en matriz2, que queda con el estado pasos_bloque pasos después
+* del de matriz. El mayor cambio de cada paso queda en p_max_bloque.
 * @param mem Puntero a la estructura de memoria privada del hilo
 * @return void* Hay que retornar algo, en este caso NULL
 **/
-void* calculo_matriz(void* mem);
-/**
- * @brief Se encarga de tomar los datos del archivo de trabajo que se necesitaran para la simulación
- * 
- * Lee la información de una lámina desde el archivo de trabajo y la almacena en la estructura lámina.
- * @param lamina Puntero a la lamina que se va a cargar
- * @param job_file Archivo de trabajo con los datos de la lamina
- * @param prefijo_ruta_trabajo Nombre de carpeta donde se encuentran todos los archivos
- * @return true si la lámina se cargó, false si no.
- */
-bool cargar_lamina(lamina_t* lamina, FILE* archivo_trabajo,
-  char* prefijo_ruta_trabajo);
+void* calculo_bloque(void* mem);
 /**
  * @brief Se encarga de aleer los datos de la lamina y guardarlos en el struct
  * 
@@ -184,7 +499,78 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
  * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
  */
 int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp);
+/**
+ * @brief Prepara la memoria compartida y privada para simular una lámina.
+ *
+ * Divide el interior en un bloque por hilo, calcula el coeficiente y los
+ * bloques temporales, y supone que la lámina no está en equilibrio. Con
+ * --float-storage copia la lámina a las matrices en float.
+ *
+ * @param lamina Lámina ya cargada.
+ * @param mem_comp Memoria compartida de los hilos.
+ * @return Pasos que avanza cada bloque temporal, 1 si no se usan bloques, o 0
+ * si no hay memoria para las matrices en float.
+ */
+size_t preparar_lamina(lamina_t* lamina, mem_comp_t* mem_comp);
+/**
+ * @brief Avanza la lámina hasta que el mayor cambio no supere su epsilon.
+ *
+ * Continúa desde el estado e iteraciones actuales, así se puede llamar de
+ * nuevo con un epsilon menor. Si la última iteración ya cumple con epsilon
+ * no avanza. Después de cada avance revisa el punto de control, si lo hay.
+ * Con almacenamiento en float simula en mem_comp->simple y al terminar copia
+ * el estado a matriz.
+ *
+ * @param lamina Lámina preparada con preparar_lamina().
+ * @param mem_comp Memoria compartida de los hilos.
+ * @param pasos_bloque Valor que retornó preparar_lamina().
+ * @return EXIT_SUCCESS o EXIT_FAILURE si la simulación se detuvo por SIGTERM
+ * o si epsilon es menor a la resolución de float.
+ */
+int avanzar_lamina(lamina_t* lamina, mem_comp_t* mem_comp,
+  size_t pasos_bloque);
+/**
+ * @brief Ejecuta una rutina en los hilos de la lámina actual y espera a que
+ * terminen.
+ *
+ * Si la lámina usa un solo hilo, la rutina la ejecuta el hilo que llama,
+ * sin despertar al equipo.
+ *
+ * @param mem_comp Puntero a la memoria compartida.
+ * @param rutina La rutina de la estrategia o calculo_bloque().
+ */
+void ejecutar_hilos(mem_comp_t* mem_comp, void* (*rutina)(void*));
 
+/**
+ * @brief Prepara los bloques temporales de la lámina actual.
+ *
+ * Ajusta los pasos pedidos con --time-block y el alto de los bloques para
+ * que las matrices auxiliares de cada hilo quepan en la caché L2, y
+ * reserva esas matrices si las que tiene el hilo no alcanzan.
+ *
+ * @param lamina Lámina que se va a procesar.
+ * @param mem_comp Memoria compartida con las filas de cada hilo.
+ * @return Pasos que avanza cada bloque, 1 si no se usan bloques temporales.
+ */
+size_t preparar_bloque_temporal(lamina_t* lamina, mem_comp_t* mem_comp);
+/**
+ * @brief Avanza la lámina un bloque temporal con todo el equipo.
+ *
+ * Si el equilibrio se alcanza en un paso intermedio del bloque, repite el
+ * bloque solo hasta ese paso, así las iteraciones y la lámina final son
+ * las mismas que al avanzar de un paso a la vez.
+ *
+ * @param mem_comp Memoria compartida de los hilos.
+ * @param pasos Pasos de tiempo del bloque.
+ * @return Pasos que avanzó la lámina, quedan en matriz2.
+ */
+size_t avanzar_bloque(mem_comp_t* mem_comp, size_t pasos);
+/**
+ * @brief Tamaño de la caché L2 que reporta el sistema.
+ *
+ * @return Bytes de L2, o CACHE_L2_OMISION si el sistema no lo reporta.
+ */
+size_t tamano_cache_l2(void);
 /**
  * @brief Reporta los resultados de la simulación de la lámina.
  * 
@@ -192,16 +578,47 @@ int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp);
  * @param archivo_salida Archivo donde se escribirán los resultados.
  * @param prefijo_ruta_trabajo Nombre de carpeta donde se encuentran todos los archivos
  * @param lamina struct lamina
+ * @param comprimir true para escribir la lámina comprimida.
  * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
  */
 int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
-  lamina_t* lamina);
+  lamina_t* lamina, bool comprimir);
+/**
+ * @brief Escribe la fila de la lámina en el archivo de salida .tsv
+ *
+ * @param archivo_salida Archivo donde se escribirán los resultados.
+ * @param lamina struct lamina
+ */
+void reportar_fila(FILE* archivo_salida, const lamina_t* lamina);
 /**
-* @brief función para crear y gestionar hilos. 
-* Le asigna la informacion privada a cada hilo y los manda a ejecutar 
-* la rutina calculo_matriz()
+ * @brief Escribe el estado actual de la lámina en plateNNN-iteraciones.bin
+ *
+ * @param prefijo_ruta_trabajo Nombre de carpeta donde se encuentran todos los archivos
+ * @param lamina struct lamina
+ * @param comprimir true para escribirla comprimida, ver escribir_lamina().
+ * @param equipo Equipo estacionado que la comprime, NULL para comprimirla
+ * en el hilo que invoca.
+ * @param hilos Hilos del equipo que participan.
+ * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
+ */
+int guardar_lamina(char* prefijo_ruta_trabajo, const lamina_t* lamina,
+  bool comprimir, equipo_t* equipo, size_t hilos);
+/**
+* @brief función para crear el equipo de hilos y su memoria privada. 
+* Los hilos quedan estacionados hasta que procesar_lamina() les despache
+* la rutina calculo_matriz(), y se reutilizan en todas las láminas. Mide
+* con medir_costo() el estencil y el despacho de este equipo.
 * @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+* @param hilos_totales Cantidad de hilos del equipo.
+* @param primer_hilo Posición en el mapa de afinidad de las opciones del
+* hilo 0 del equipo, para que equipos simultáneos usen CPUs distintas.
 * @return int error: 0 Success : 1 Failure
 */
-int crear_hilos(mem_comp_t* mem_comp);
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales,
+  size_t primer_hilo);
+/**
+* @brief Termina el equipo de hilos y libera su memoria privada.
+* @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+*/
+void liberar_hilos(mem_comp_t* mem_comp);
 #endif
@@ -0,0 +1,76 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <stdlib.h>
+#include <string.h>
+#include "teselas.h"
+
+// Hace crecer un arreglo a cantidad elementos si no alcanza, sin conservar
+// su contenido
+static bool asegurar_arreglo(void** arreglo, size_t* capacidad,
+    size_t cantidad, size_t tamano) {
+  if (*capacidad >= cantidad) {
+    return true;
+  }
+  free(*arreglo);
+  *arreglo = malloc(cantidad * tamano);
+  *capacidad = *arreglo ? cantidad : 0;
+  return *arreglo != NULL;
+}
+
+void iniciar_teselas(teselas_t* teselas) {
+  teselas->cortes_filas = teselas->cortes_columnas = NULL;
+  teselas->cambios[0] = teselas->cambios[1] = NULL;
+  teselas->teselas_filas = teselas->teselas_columnas = 0;
+  teselas->capacidad_filas = teselas->capacidad_columnas = 0;
+  teselas->capacidad_cambios = 0;
+  teselas->anterior = 0;
+  teselas->activas = false;
+}
+
+bool reservar_teselas(teselas_t* teselas, size_t teselas_filas,
+    size_t teselas_columnas) {
+  const size_t cantidad = teselas_filas * teselas_columnas;
+  // Los dos arreglos de indicadores comparten una sola reserva
+  if (!asegurar_arreglo((void**) &teselas->cortes_filas,
+      &teselas->capacidad_filas, teselas_filas + 1, sizeof(size_t))
+      || !asegurar_arreglo((void**) &teselas->cortes_columnas,
+      &teselas->capacidad_columnas, teselas_columnas + 1, sizeof(size_t))
+      || !asegurar_arreglo((void**) &teselas->cambios[0],
+      &teselas->capacidad_cambios, 2 * cantidad, 1)) {
+    return false;
+  }
+  teselas->cambios[1] = teselas->cambios[0] + cantidad;
+  return true;
+}
+
+void reiniciar_teselas(teselas_t* teselas) {
+  memset(teselas->cambios[teselas->anterior], 1,
+    teselas->teselas_filas * teselas->teselas_columnas);
+}
+
+bool tesela_quieta(const teselas_t* teselas, size_t fila, size_t columna) {
+  const unsigned char* cambios = teselas->cambios[teselas->anterior];
+  const size_t columnas = teselas->teselas_columnas;
+  const size_t indice = fila * columnas + columna;
+  return !cambios[indice]
+      && (fila == 0 || !cambios[indice - columnas])
+      && (fila + 1 == teselas->teselas_filas || !cambios[indice + columnas])
+      && (columna == 0 || !cambios[indice - 1])
+      && (columna + 1 == columnas || !cambios[indice + 1]);
+}
+
+void marcar_tesela(teselas_t* teselas, size_t fila, size_t columna,
+    bool cambio) {
+  teselas->cambios[1 - teselas->anterior][fila * teselas->teselas_columnas
+    + columna] = cambio;
+}
+
+void alternar_teselas(teselas_t* teselas) {
+  teselas->anterior = 1 - teselas->anterior;
+}
+
+void liberar_teselas(teselas_t* teselas) {
+  free(teselas->cortes_filas);
+  free(teselas->cortes_columnas);
+  free(teselas->cambios[0]);
+  iniciar_teselas(teselas);
+}
@@ -0,0 +1,130 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef TESELAS_H
+#define TESELAS_H
+#include <stdbool.h>
+#include <stddef.h>
+/**
+ * @brief Filas de cada tesela, la última de cada bloque de hilo puede tener
+ * menos
+ */
+#define ALTO_TESELA 32
+/**
+ * @brief Columnas de cada tesela, la última de cada bloque de hilo puede
+ * tener menos
+ */
+#define ANCHO_TESELA 256
+/**
+ * @brief Actividad de las teselas en que se divide el interior de la lámina.
+ *
+ * Una celda cuyo estado y el de sus cuatro vecinas no cambió en la última
+ * iteración tampoco cambia en la siguiente, porque se calcula con los
+ * mismos valores. Por eso una tesela que no cambió y cuyas vecinas tampoco
+ * cambiaron queda igual: no se calcula, y matriz2, que tiene el estado
+ * anterior, ya tiene su estado siguiente. Cada tesela pertenece a un solo
+ * hilo, y los cortes de las teselas incluyen los de los bloques de hilos.
+ */
+typedef struct {
+  /**
+   * @brief Fila inicial de cada fila de teselas, más la fila del borde
+   * inferior al final
+   */
+  size_t* cortes_filas;
+  /**
+   * @brief Cantidad de filas de teselas
+   */
+  size_t teselas_filas;
+  /**
+   * @brief Columna inicial de cada columna de teselas, más la columna del
+   * borde derecho al final
+   */
+  size_t* cortes_columnas;
+  /**
+   * @brief Cantidad de columnas de teselas
+   */
+  size_t teselas_columnas;
+  /**
+   * @brief Indicadores de cambio de cada tesela, por filas de teselas. Uno
+   * es el de la iteración anterior y el otro el de la actual. cambios[0] es
+   * dueño de la memoria de ambos
+   */
+  unsigned char* cambios[2];
+  /**
+   * @brief Índice en cambios de los indicadores de la iteración anterior
+   */
+  size_t anterior;
+  /**
+   * @brief Cantidad de cortes de filas que caben en cortes_filas
+   */
+  size_t capacidad_filas;
+  /**
+   * @brief Cantidad de cortes de columnas que caben en cortes_columnas
+   */
+  size_t capacidad_columnas;
+  /**
+   * @brief Cantidad de indicadores que caben en la memoria de cambios
+   */
+  size_t capacidad_cambios;
+  /**
+   * @brief Indica si la lámina actual se calcula por teselas
+   */
+  bool activas;
+} teselas_t;
+/**
+ * @brief Inicializa las teselas sin memoria reservada e inactivas.
+ *
+ * @param teselas Teselas a inicializar.
+ */
+void iniciar_teselas(teselas_t* teselas);
+/**
+ * @brief Asegura espacio para una cuadrícula de teselas. La memoria crece
+ * según las láminas y se reutiliza.
+ *
+ * @param teselas Teselas inicializadas con iniciar_teselas().
+ * @param teselas_filas Máximo de filas de teselas.
+ * @param teselas_columnas Máximo de columnas de teselas.
+ * @return true si hay espacio, false si no hay memoria.
+ */
+bool reservar_teselas(teselas_t* teselas, size_t teselas_filas,
+  size_t teselas_columnas);
+/**
+ * @brief Marca todas las teselas como cambiadas en la iteración anterior,
+ * así la siguiente las calcula todas. Se llama al iniciar una lámina, cuando
+ * matriz2 aún no tiene un estado válido.
+ *
+ * @param teselas Teselas con los cortes ya asignados.
+ */
+void reiniciar_teselas(teselas_t* teselas);
+/**
+ * @brief Indica si una tesela y sus cuatro vecinas no cambiaron en la
+ * iteración anterior. Los bordes de la lámina nunca cambian.
+ *
+ * @param teselas Teselas de la lámina.
+ * @param fila Fila de la tesela en la cuadrícula.
+ * @param columna Columna de la tesela en la cuadrícula.
+ * @return true si la tesela queda igual en la iteración actual.
+ */
+bool tesela_quieta(const teselas_t* teselas, size_t fila, size_t columna);
+/**
+ * @brief Registra si una tesela cambió en la iteración actual.
+ *
+ * @param teselas Teselas de la lámina.
+ * @param fila Fila de la tesela en la cuadrícula.
+ * @param columna Columna de la tesela en la cuadrícula.
+ * @param cambio true si alguna celda de la tesela cambió.
+ */
+void marcar_tesela(teselas_t* teselas, size_t fila, size_t columna,
+  bool cambio);
+/**
+ * @brief Al terminar una iteración, sus indicadores pasan a ser los de la
+ * iteración anterior.
+ *
+ * @param teselas Teselas de la lámina.
+ */
+void alternar_teselas(teselas_t* teselas);
+/**
+ * @brief Libera la memoria de las teselas.
+ *
+ * @param teselas Teselas inicializadas con iniciar_teselas().
+ */
+void liberar_teselas(teselas_t* teselas);
+#endif
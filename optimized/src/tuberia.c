@@ -0,0 +1,284 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include "tuberia.h"
+
+// Libera un grupo cargado que no se va a simular
+static void liberar_carga(tuberia_t* tuberia, carga_t* carga) {
+  devolver_matriz(tuberia->cache->arena, carga->lamina.matriz);
+  devolver_matriz(tuberia->cache->arena, carga->lamina.matriz2);
+  liberar_grupo(&carga->grupo);
+  free(carga);
+}
+
+// Agrega un trabajo al final de la cola del escritor
+static void encolar_escritura(tuberia_t* tuberia, escritura_t* escritura) {
+  pthread_mutex_lock(&tuberia->mutex);
+  escritura->siguiente = NULL;
+  if (tuberia->escrituras) {
+    tuberia->ultima_escritura->siguiente = escritura;
+  } else {
+    tuberia->escrituras = escritura;
+  }
+  tuberia->ultima_escritura = escritura;
+  if (escritura->lamina.matriz) {
+    ++tuberia->laminas_pendientes;
+  }
+  pthread_cond_broadcast(&tuberia->cambio);
+  pthread_mutex_unlock(&tuberia->mutex);
+}
+
+// Rutina del cargador: lee y carga grupos hasta que no haya más o se
+// detenga el cálculo
+static void* cargar_grupos(void* datos) {
+  tuberia_t* tuberia = (tuberia_t*) datos;
+  const bool agrupar = tuberia->opciones->agrupar_epsilon != 0;
+  while (true) {
+    pthread_mutex_lock(&tuberia->mutex);
+    while (tuberia->cantidad_cargas >= CARGAS_ANTICIPADAS
+        && !tuberia->detener) {
+      pthread_cond_wait(&tuberia->cambio, &tuberia->mutex);
+    }
+    const bool detener = tuberia->detener;
+    pthread_mutex_unlock(&tuberia->mutex);
+    if (detener) {
+      break;
+    }
+    carga_t* carga = (carga_t*) calloc(1, sizeof(carga_t));
+    if (carga == NULL) {
+      fprintf(stderr, "Error: no hay memoria para cargar el siguiente "
+        "grupo\n");
+      pthread_mutex_lock(&tuberia->mutex);
+      tuberia->error = EXIT_FAILURE;
+      tuberia->fin_cargas = true;
+      pthread_cond_broadcast(&tuberia->cambio);
+      pthread_mutex_unlock(&tuberia->mutex);
+      break;
+    }
+    carga->grupo.max_temp = DBL_MAX;
+    // El equipo está calculando, la lámina se carga en este hilo
+    char ruta_lamina[BUFFER_MAX];
+    bool hay_lamina = leer_grupo(&tuberia->lector, &carga->grupo,
+      ruta_lamina, agrupar);
+    if (hay_lamina) {
+      carga->lamina = carga->grupo.lineas[0];
+      hay_lamina = cargar_de_cache(tuberia->cache, ruta_lamina,
+        &carga->lamina.n_filas, &carga->lamina.n_columnas,
+        &carga->lamina.paso, &carga->lamina.matriz, &carga->lamina.matriz2,
+        NULL, 1);
+      if (!hay_lamina) {
+        carga->lamina.matriz = carga->lamina.matriz2 = NULL;
+      }
+    }
+    pthread_mutex_lock(&tuberia->mutex);
+    if (hay_lamina) {
+      if (tuberia->cargas) {
+        tuberia->ultima_carga->siguiente = carga;
+      } else {
+        tuberia->cargas = carga;
+      }
+      tuberia->ultima_carga = carga;
+      ++tuberia->cantidad_cargas;
+    } else {
+      // Igual que en la simulación secuencial, la primera lámina que no se
+      // puede cargar termina el trabajo
+      tuberia->fin_cargas = true;
+    }
+    pthread_cond_broadcast(&tuberia->cambio);
+    pthread_mutex_unlock(&tuberia->mutex);
+    if (!hay_lamina) {
+      liberar_carga(tuberia, carga);
+      break;
+    }
+  }
+  return NULL;
+}
+
+// Rutina del escritor: guarda láminas y escribe reportes en el orden en que
+// se entregaron, hasta que el cálculo termine y la cola quede vacía
+static void* escribir_resultados(void* datos) {
+  tuberia_t* tuberia = (tuberia_t*) datos;
+  archivos_t* archivos = tuberia->archivos;
+  while (true) {
+    pthread_mutex_lock(&tuberia->mutex);
+    while (tuberia->escrituras == NULL && !tuberia->detener) {
+      pthread_cond_wait(&tuberia->cambio, &tuberia->mutex);
+    }
+    escritura_t* escritura = tuberia->escrituras;
+    if (escritura) {
+      tuberia->escrituras = escritura->siguiente;
+    }
+    // Después de un error solo se vacía la cola
+    const bool escribir = tuberia->error == 0;
+    pthread_mutex_unlock(&tuberia->mutex);
+    if (escritura == NULL) {
+      break;
+    }
+    int error = EXIT_SUCCESS;
+    if (escribir && escritura->lamina.matriz) {
+      error = guardar_lamina(archivos->prefijo_ruta_trabajo,
+        &escritura->lamina, tuberia->opciones->comprimir != 0, NULL, 1);
+    } else if (escribir) {
+      for (size_t linea = 0; linea < escritura->grupo.cantidad; ++linea) {
+        reportar_fila(archivos->archivo_salida,
+          &escritura->grupo.lineas[linea]);
+      }
+    }
+    pthread_mutex_lock(&tuberia->mutex);
+    if (escritura->lamina.matriz) {
+      --tuberia->laminas_pendientes;
+    }
+    if (error != EXIT_SUCCESS && tuberia->error == 0) {
+      tuberia->error = error;
+    }
+    pthread_cond_broadcast(&tuberia->cambio);
+    pthread_mutex_unlock(&tuberia->mutex);
+    devolver_matriz(tuberia->cache->arena, escritura->lamina.matriz);
+    liberar_grupo(&escritura->grupo);
+    free(escritura);
+  }
+  return NULL;
+}
+
+// Entrega al escritor una copia de la lámina al alcanzar el epsilon de una
+// línea. Espera si ya tiene ESCRITURAS_PENDIENTES_MAX láminas
+static int entregar_copia(void* contexto, size_t linea,
+    const lamina_t* lamina) {
+  (void) linea;
+  tuberia_t* tuberia = (tuberia_t*) contexto;
+  pthread_mutex_lock(&tuberia->mutex);
+  while (tuberia->laminas_pendientes >= ESCRITURAS_PENDIENTES_MAX
+      && tuberia->error == 0) {
+    pthread_cond_wait(&tuberia->cambio, &tuberia->mutex);
+  }
+  const int error = tuberia->error;
+  pthread_mutex_unlock(&tuberia->mutex);
+  if (error != 0) {
+    return error;
+  }
+  escritura_t* escritura = (escritura_t*) calloc(1, sizeof(escritura_t));
+  double* copia = tomar_matriz(tuberia->cache->arena, lamina->n_filas,
+    lamina->paso);
+  if (escritura == NULL || copia == NULL) {
+    fprintf(stderr, "Error: no hay memoria para el reporte de %s\n",
+      lamina->nombre);
+    free(escritura);
+    devolver_matriz(tuberia->cache->arena, copia);
+    return EXIT_FAILURE;
+  }
+  memcpy(copia, lamina->matriz, lamina->n_filas * lamina->paso
+    * sizeof(double));
+  escritura->lamina = *lamina;
+  escritura->lamina.matriz = copia;
+  escritura->lamina.matriz2 = NULL;
+  encolar_escritura(tuberia, escritura);
+  return EXIT_SUCCESS;
+}
+
+int simular_tuberia(archivos_t* archivos, const opciones_t* opciones,
+    size_t hilos_usuario, cache_t* cache) {
+  tuberia_t tuberia;
+  tuberia.archivos = archivos;
+  tuberia.opciones = opciones;
+  tuberia.cache = cache;
+  iniciar_lector(&tuberia.lector, archivos);
+  tuberia.cargas = tuberia.ultima_carga = NULL;
+  tuberia.cantidad_cargas = 0;
+  tuberia.fin_cargas = false;
+  tuberia.escrituras = tuberia.ultima_escritura = NULL;
+  tuberia.laminas_pendientes = 0;
+  tuberia.detener = false;
+  tuberia.error = 0;
+
+  lamina_t lamina;
+  mem_comp_t mem_comp;
+  mem_comp.lamina = &lamina;
+  mem_comp.opciones = opciones;
+  mem_comp.punto_control = NULL;
+  if (crear_hilos(&mem_comp, hilos_usuario, 0) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  pthread_mutex_init(&tuberia.mutex, NULL);
+  pthread_cond_init(&tuberia.cambio, NULL);
+  pthread_t cargador;
+  pthread_t escritor;
+  if (pthread_create(&cargador, NULL, cargar_grupos, &tuberia) != 0) {
+    fprintf(stderr, "Error: could not create secondary thread\n");
+    pthread_cond_destroy(&tuberia.cambio);
+    pthread_mutex_destroy(&tuberia.mutex);
+    liberar_hilos(&mem_comp);
+    return EXIT_FAILURE;
+  }
+  bool hay_escritor = pthread_create(&escritor, NULL, escribir_resultados,
+    &tuberia) == 0;
+  if (!hay_escritor) {
+    fprintf(stderr, "Error: could not create secondary thread\n");
+    tuberia.error = EXIT_FAILURE;
+  }
+
+  while (hay_escritor) {
+    // Tomar el siguiente grupo cargado
+    pthread_mutex_lock(&tuberia.mutex);
+    while (tuberia.cargas == NULL && !tuberia.fin_cargas
+        && tuberia.error == 0) {
+      pthread_cond_wait(&tuberia.cambio, &tuberia.mutex);
+    }
+    carga_t* carga = tuberia.error == 0 ? tuberia.cargas : NULL;
+    if (carga) {
+      tuberia.cargas = carga->siguiente;
+      --tuberia.cantidad_cargas;
+      pthread_cond_broadcast(&tuberia.cambio);
+    }
+    pthread_mutex_unlock(&tuberia.mutex);
+    if (carga == NULL) {
+      break;
+    }
+    lamina = carga->lamina;
+    int error = procesar_grupo(&carga->grupo, &mem_comp, entregar_copia,
+      &tuberia);
+    devolver_matriz(cache->arena, lamina.matriz);
+    devolver_matriz(cache->arena, lamina.matriz2);
+    escritura_t* reporte = error == EXIT_SUCCESS
+        ? (escritura_t*) calloc(1, sizeof(escritura_t)) : NULL;
+    if (error == EXIT_SUCCESS && reporte == NULL) {
+      fprintf(stderr, "Error: no hay memoria para el reporte de %s\n",
+        carga->grupo.lineas[0].nombre);
+      error = EXIT_FAILURE;
+    }
+    if (reporte) {
+      // Las filas se escriben después de las láminas del grupo, el grupo
+      // pasa al escritor
+      reporte->grupo = carga->grupo;
+      carga->grupo.lineas = NULL;
+      encolar_escritura(&tuberia, reporte);
+    }
+    carga->lamina.matriz = carga->lamina.matriz2 = NULL;
+    liberar_carga(&tuberia, carga);
+    if (error != EXIT_SUCCESS) {
+      pthread_mutex_lock(&tuberia.mutex);
+      if (tuberia.error == 0) {
+        tuberia.error = error;
+      }
+      pthread_mutex_unlock(&tuberia.mutex);
+      break;
+    }
+  }
+
+  // Detener al cargador y esperar a que el escritor vacíe su cola
+  pthread_mutex_lock(&tuberia.mutex);
+  tuberia.detener = true;
+  pthread_cond_broadcast(&tuberia.cambio);
+  pthread_mutex_unlock(&tuberia.mutex);
+  pthread_join(cargador, NULL);
+  if (hay_escritor) {
+    pthread_join(escritor, NULL);
+  }
+  // Grupos cargados que ya no se simulan
+  while (tuberia.cargas) {
+    carga_t* carga = tuberia.cargas;
+    tuberia.cargas = carga->siguiente;
+    liberar_carga(&tuberia, carga);
+  }
+  pthread_cond_destroy(&tuberia.cambio);
+  pthread_mutex_destroy(&tuberia.mutex);
+  liberar_hilos(&mem_comp);
+  return tuberia.error;
+}
@@ -0,0 +1,140 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef TUBERIA_H
+#define TUBERIA_H
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "grupo.h"
+#include "simul.h"
+/**
+ * @brief Grupos que el cargador deja listos antes de que se simulen
+ */
+#define CARGAS_ANTICIPADAS 1
+/**
+ * @brief Láminas resultantes copiadas que pueden esperar al escritor. Al
+ * llegar a este número el cálculo espera a que se escriba una
+ */
+#define ESCRITURAS_PENDIENTES_MAX 2
+/**
+ * @brief Grupo leído del archivo de trabajo con su lámina ya cargada
+ */
+typedef struct carga {
+  /**
+   * @brief Líneas del grupo
+   */
+  grupo_t grupo;
+  /**
+   * @brief Primera línea del grupo con sus dos matrices
+   */
+  lamina_t lamina;
+  /**
+   * @brief Siguiente grupo en la cola
+   */
+  struct carga* siguiente;
+} carga_t;
+/**
+ * @brief Trabajo del escritor: una lámina resultante o las filas del
+ * reporte de un grupo
+ */
+typedef struct escritura {
+  /**
+   * @brief Copia de la lámina a guardar, matriz es NULL si es un reporte
+   */
+  lamina_t lamina;
+  /**
+   * @brief Grupo cuyas filas se escriben en el reporte, sin líneas si es
+   * una lámina
+   */
+  grupo_t grupo;
+  /**
+   * @brief Siguiente trabajo en la cola
+   */
+  struct escritura* siguiente;
+} escritura_t;
+/**
+ * @brief Estado compartido por las tres etapas de la tubería
+ */
+typedef struct {
+  /**
+   * @brief Archivos de trabajo y de salida
+   */
+  archivos_t* archivos;
+  /**
+   * @brief Opciones de la línea de comandos
+   */
+  const opciones_t* opciones;
+  /**
+   * @brief Caché de láminas iniciales
+   */
+  cache_t* cache;
+  /**
+   * @brief Lee los grupos del archivo de trabajo, solo lo usa el cargador
+   */
+  lector_t lector;
+  /**
+   * @brief Protege las colas y los indicadores
+   */
+  pthread_mutex_t mutex;
+  /**
+   * @brief Avisa a las etapas de cualquier cambio en las colas
+   */
+  pthread_cond_t cambio;
+  /**
+   * @brief Grupos cargados en el orden del archivo de trabajo
+   */
+  carga_t* cargas;
+  /**
+   * @brief Último grupo de cargas, para agregar al final
+   */
+  carga_t* ultima_carga;
+  /**
+   * @brief Cantidad de grupos en cargas
+   */
+  size_t cantidad_cargas;
+  /**
+   * @brief El cargador terminó: no hay más líneas o no se pudo cargar una
+   * lámina
+   */
+  bool fin_cargas;
+  /**
+   * @brief Trabajos del escritor en el orden en que se entregaron
+   */
+  escritura_t* escrituras;
+  /**
+   * @brief Último trabajo de escrituras, para agregar al final
+   */
+  escritura_t* ultima_escritura;
+  /**
+   * @brief Láminas resultantes en escrituras, sin contar los reportes
+   */
+  size_t laminas_pendientes;
+  /**
+   * @brief El cálculo terminó, las etapas terminan al vaciar sus colas
+   */
+  bool detener;
+  /**
+   * @brief Primer error de una etapa, detiene a las demás
+   */
+  int error;
+} tuberia_t;
+/**
+ * @brief Simula el archivo de trabajo con la carga, el cálculo y la
+ * escritura en hilos distintos.
+ *
+ * Un hilo cargador lee el grupo siguiente y carga su lámina mientras el
+ * equipo calcula el actual, hasta CARGAS_ANTICIPADAS grupos adelante. Cada
+ * lámina resultante se copia y un hilo escritor la guarda, y luego escribe
+ * las filas del grupo en el reporte, en el orden del archivo de trabajo. El
+ * cálculo solo espera si el escritor tiene ESCRITURAS_PENDIENTES_MAX
+ * láminas sin guardar. Los archivos resultantes son los mismos que los de
+ * simular_secuencial().
+ *
+ * @param archivos Archivos de trabajo y de salida ya abiertos.
+ * @param opciones Opciones de la línea de comandos, sin puntos de control.
+ * @param hilos_usuario Hilos del equipo de cálculo.
+ * @param cache Caché de láminas iniciales.
+ * @return EXIT_SUCCESS en caso de éxito o en caso contrario EXIT_FAILURE.
+ */
+int simular_tuberia(archivos_t* archivos, const opciones_t* opciones,
+  size_t hilos_usuario, cache_t* cache);
+#endif
@@ -8,6 +8,8 @@ int iniciar_simul(int argc, char* argv[]) {
   if (preparar_archivos(argc, argv, &archivos)!= EXIT_SUCCESS) {
     return EXIT_FAILURE;
   }
+  // Elige la implementación del estencil según el procesador
+  seleccionar_estencil();
   // Obtiene el número de hilos que indica el usuario
   size_t hilos_usuario = sysconf(_SC_NPROCESSORS_ONLN);
   if (sscanf(argv[2], "%zu", &hilos_usuario) == 1) {
@@ -20,7 +22,20 @@ int iniciar_simul(int argc, char* argv[]) {
 
   mem_comp_t mem_comp;
   mem_comp.lamina = &lamina;
-  mem_comp.hilos_totales = hilos_usuario;
+  mem_comp.hilos_usuario = hilos_usuario;
+  // Lee la CPU a la que se fija cada hilo, si el usuario las indicó
+  if (!leer_afinidad(&mem_comp.afinidad)) {
+    fclose(archivos.archivo_trabajo);
+    fclose(archivos.archivo_salida);
+    return EXIT_FAILURE;
+  }
+  // El equipo se crea una vez y queda estacionado entre láminas: hasta
+  // hilos_usuario hilos calculan y uno más coordina cada iteración
+  if (crear_hilos(&mem_comp, hilos_usuario + 1) != EXIT_SUCCESS) {
+    fclose(archivos.archivo_trabajo);
+    fclose(archivos.archivo_salida);
+    return EXIT_FAILURE;
+  }
 
   int error = 0;
   bool hay_laminas = true;
@@ -38,10 +53,11 @@ int iniciar_simul(int argc, char* argv[]) {
         if (error != 0) {
             break;
         }
-        liberar_matriz(lamina.matriz, lamina.n_filas);
-        liberar_matriz(lamina.matriz2, lamina.n_filas);
+        liberar_matriz(lamina.matriz);
+        liberar_matriz(lamina.matriz2);
     }
   }
+  liberar_hilos(&mem_comp);
   // Cierra los archivos abiertos
   fclose(archivos.archivo_trabajo);
   fclose(archivos.archivo_salida);
@@ -102,57 +118,23 @@ bool cargar_lamina(lamina_t* lamina, FILE* archivo_trabajo,
       ruta_lamina)) {
     return false;
   }
-  FILE* archivo_lamina = fopen(ruta_lamina, "rb");
-  if (archivo_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta_lamina,
-        strerror(errno));
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee el número de filas y columnas de la matriz de la lámina
-  if (fread(&lamina->n_filas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de filas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  if (fread(&lamina->n_columnas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de columnas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  // Crea las matrices para el estado actual y el siguiente
-  lamina->matriz = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz == NULL) {
-    fprintf(stderr, "Error al crear la matriz 1");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
+  // Mapea la lámina y solo reserva las matrices para el estado actual y el
+  // siguiente, sin tocarlas. El archivo de trabajo lo cierra main
+  if (!abrir_lamina(ruta_lamina, &lamina->mapeo)) {
     return false;
   }
-  lamina->matriz2 = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz2 == NULL) {
-    fprintf(stderr, "Error al crear la matriz 2");
-    liberar_matriz(lamina->matriz, lamina->n_filas);
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
+  lamina->n_filas = lamina->mapeo.n_filas;
+  lamina->n_columnas = lamina->mapeo.n_columnas;
+  lamina->paso = calcular_paso(lamina->n_columnas);
+  lamina->matriz = reservar_matriz(lamina->n_filas, lamina->paso);
+  lamina->matriz2 = reservar_matriz(lamina->n_filas, lamina->paso);
+  if (lamina->matriz == NULL || lamina->matriz2 == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", ruta_lamina);
+    liberar_matriz(lamina->matriz);
+    liberar_matriz(lamina->matriz2);
+    cerrar_lamina(&lamina->mapeo);
     return false;
   }
-  // Lee los valores de la matriz
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    if (fread(lamina->matriz[i], sizeof(double), lamina->n_columnas,
-        archivo_lamina) == 0) {
-      fprintf(stderr, "Error: al leer valores de la matriz");
-      liberar_matriz(lamina->matriz, lamina->n_filas);
-      liberar_matriz(lamina->matriz2, lamina->n_filas);
-      fclose(archivo_lamina);
-      fclose(archivo_trabajo);
-      return false;
-    }
-    // Copiar los datos de matriz a matriz2
-    memcpy(lamina->matriz2[i], lamina->matriz[i], sizeof(double) *
-      lamina->n_columnas);
-  }
-  // Cierra el archivo de la lámina
-  fclose(archivo_lamina);
   return true;
 }
 bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
@@ -165,7 +147,7 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   // Lee los datos de la lámina (tiempo, difusividad, distancia, epsilon)
   if (fscanf(archivo_trabajo, "%zu %lf %lf %lf", &lamina->tiempo,
         &lamina->difusividad, &lamina->distancia, &lamina->epsilon) < 4) {
-    liberar_matriz(lamina->matriz, lamina->n_filas);
+    liberar_matriz(lamina->matriz);
     fclose(archivo_trabajo);
     fprintf(stderr, "Error al leer datos de la lamina: %s\n",
       strerror(errno));
@@ -180,61 +162,123 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   }
   return true;
 }
+// Simula en el hilo main una lámina sin filas internas, que no tiene
+// filas que repartir entre los hilos
+static int simular_serial(lamina_t* lamina) {
+  copiar_filas(&lamina->mapeo, lamina->matriz, lamina->paso, 0,
+    lamina->n_filas);
+  copiar_bordes(lamina->matriz, lamina->matriz2, lamina->n_filas,
+    lamina->n_columnas, lamina->paso, 0, lamina->n_filas);
+  cerrar_lamina(&lamina->mapeo);
+  const double coeficiente = (lamina->tiempo * lamina->difusividad)
+      /(lamina->distancia * lamina->distancia);
+  double* matriz = lamina->matriz;
+  double* matriz2 = lamina->matriz2;
+  size_t iteraciones = 0;
+  double max_temp = 0.0;
+  do {
+    max_temp = calcular_filas(matriz, matriz2, lamina->paso,
+      lamina->n_columnas, 1, lamina->n_filas - 1, coeficiente);
+    double* siguiente = matriz2;
+    matriz2 = matriz;
+    matriz = siguiente;
+    ++iteraciones;
+  } while (max_temp > lamina->epsilon);
+  lamina->matriz = matriz;
+  lamina->matriz2 = matriz2;
+  lamina->iteraciones = iteraciones;
+  return EXIT_SUCCESS;
+}
+/**
+ * @brief Coordina una lámina desde el hilo del equipo que no calcula: libera
+ * el mapeo cuando los hilos copiaron sus filas y reduce el máximo de cada
+ * iteración hasta el equilibrio.
+ * @param mem_comp Puntero a la memoria compartida de la lámina en curso.
+ */
+static void coordinar_lamina(mem_comp_t* mem_comp) {
+  lamina_t* lamina = mem_comp->lamina;
+  // Espera a que cada hilo copie sus filas para liberar el mapeo
+  pthread_barrier_wait(&mem_comp->barrier);
+  cerrar_lamina(&lamina->mapeo);
+
+  // Una sola barrera por iteración: mientras los hilos calculan la
+  // iteración k + 1 de forma especulativa, el coordinador reduce el máximo
+  // de la iteración k. Si k alcanzó el equilibrio, la iteración k + 1
+  // escribió en la otra matriz y simplemente se descarta.
+  size_t iteracion = 0;
+  while (true) {
+    pthread_barrier_wait(&mem_comp->barrier);
+    ++iteracion;
+    if (iteracion > 1 && mem_comp->equilibrio[(iteracion - 1) % 2]) {
+      --iteracion;
+      break;
+    }
+    double global_max = 0.0;
+    for (size_t i = 0; i < mem_comp->hilos_totales; ++i) {
+        if (mem_comp->mem_priv[i].local_max[iteracion % 2] > global_max) {
+            global_max = mem_comp->mem_priv[i].local_max[iteracion % 2];
+        }
+    }
+    mem_comp->max_temp = global_max;
+    mem_comp->equilibrio[iteracion % 2] = global_max <= lamina->epsilon;
+  }
+  // La última iteración válida quedó en matrices[iteracion % 2]
+  lamina->matriz = mem_comp->matrices[iteracion % 2];
+  lamina->matriz2 = mem_comp->matrices[(iteracion + 1) % 2];
+  lamina->iteraciones = iteracion;
+}
+
+/**
+ * @brief Rutina que se despacha al equipo por cada lámina: el hilo
+ * hilos_totales coordina y los anteriores calculan sus filas.
+ * @param mem Puntero a la memoria privada del hilo.
+ * @return NULL
+ */
+static void* trabajar_lamina(void* mem) {
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  if (mem_priv->num_hilo == mem_priv->mem_comp->hilos_totales) {
+    coordinar_lamina(mem_priv->mem_comp);
+    return NULL;
+  }
+  return calculo_matriz(mem);
+}
+
 int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp) {
   // Suponemos que la lámina no está en equilibrio
   double max_temp = lamina->epsilon + 1;
   mem_comp->max_temp = max_temp;
-  // Actualizar filas internas e hilos según los datos de la lamina
-  mem_comp->filas_internas = lamina->n_filas - 2;
-  mem_comp->hilos_totales = mem_comp->hilos_totales < mem_comp->filas_internas
-      ? mem_comp->hilos_totales : mem_comp->filas_internas;
+  // Actualizar filas internas e hilos según los datos de la lamina. A lo
+  // sumo un hilo por par de filas
+  mem_comp->filas_internas = lamina->n_filas > 2 ? lamina->n_filas - 2 : 0;
+  const size_t pares = (mem_comp->filas_internas + FILAS_POR_TURNO - 1)
+      / FILAS_POR_TURNO;
+  mem_comp->hilos_totales = mem_comp->hilos_usuario < pares
+      ? mem_comp->hilos_usuario : pares;
+  if (mem_comp->hilos_totales == 0) {
+    return simular_serial(lamina);
+  }
 
   if (pthread_barrier_init(&mem_comp->barrier, NULL,
       mem_comp->hilos_totales + 1) != 0) {
     fprintf(stderr, "Error: barrier initialization failed\n");
+    cerrar_lamina(&lamina->mapeo);
     //destroy_matrix(lamina->matriz2, lamina->n_filas);
     return EXIT_FAILURE;
   }
   pthread_mutex_init(&mem_comp->mutex, NULL);
-  // Punteros a las matrices
-  double **matriz = lamina->matriz;
-  double **matriz2 = lamina->matriz2;
+  // Las matrices se alternan según la paridad de la iteración
+  mem_comp->matrices[0] = lamina->matriz;
+  mem_comp->matrices[1] = lamina->matriz2;
+  mem_comp->equilibrio[0] = false;
+  mem_comp->equilibrio[1] = false;
 
-  int error = 0;
-  // Hasta que se equilibre.
-  pthread_t* hilos = NULL;
-  mem_priv_t* mem_priv = NULL;
-
-  error = crear_hilos(mem_comp, &hilos, &mem_priv);
-
-  while (mem_comp->max_temp > lamina->epsilon) {
-    pthread_barrier_wait(&mem_comp->barrier);
-    double global_max = 0.0;
-    for (size_t i = 0; i < mem_comp->hilos_totales; ++i) {
-        if (mem_priv[i].local_max > global_max) {
-            global_max = mem_priv[i].local_max;
-        }
-    }
-    mem_comp->max_temp = global_max;
-    //printf(" Esta es la temperatura %lf \n",global_max );
-    // Intercambiar matrices
-    intercambiar_matriz(&matriz, &matriz2);
-    lamina->matriz = matriz;
-    lamina->matriz2 = matriz2;
-    // Resetear máximo para nueva iteración
-    lamina->iteraciones++;
-    
-    // Sincronizar para nueva iteración (segunda barrera)
-    pthread_barrier_wait(&mem_comp->barrier);  
-  }  
-  for (size_t i = 0; i < mem_comp->hilos_totales; ++i) {
-    pthread_join(hilos[i], NULL);
-  }
+  // Despierta al equipo estacionado y espera a que la lámina se equilibre,
+  // sin crear ni unir hilos
+  despachar_equipo(&mem_comp->equipo, trabajar_lamina, mem_comp->mem_priv,
+    sizeof(mem_priv_t), mem_comp->hilos_totales + 1);
   pthread_barrier_destroy(&mem_comp->barrier);
   pthread_mutex_destroy(&mem_comp->mutex);
-  free(hilos);
-  free(mem_priv);
-  return error;
+  return EXIT_SUCCESS;
 }
 
 void* calculo_matriz(void* mem) {
@@ -249,31 +293,65 @@ void* calculo_matriz(void* mem) {
   // Get thread ID and total number of threads
   const int tid = mem_priv->num_hilo;
   const int num_threads = mem_comp->hilos_totales;
-  
-  while (lamina->epsilon < mem_comp->max_temp) {
+
+  // Fija el hilo a su CPU antes de tocar sus filas, así las páginas que
+  // escriba primero quedan en su nodo NUMA
+  fijar_afinidad(&mem_comp->afinidad, mem_priv->num_hilo);
+  // Copia sus filas del mapeo y sus bordes, el primer y el último hilo
+  // también copian los bordes superior e inferior
+  if (tid == 0) {
+    copiar_filas(&lamina->mapeo, mem_comp->matrices[0], lamina->paso, 0, 1);
+    copiar_bordes(mem_comp->matrices[0], mem_comp->matrices[1],
+      lamina->n_filas, lamina->n_columnas, lamina->paso, 0, 1);
+  }
+  // Cada turno toma FILAS_POR_TURNO filas vecinas, las mismas que el hilo
+  // calcula en cada iteración
+  const size_t borde = lamina->n_filas - 1;
+  const size_t salto = FILAS_POR_TURNO * (size_t) num_threads;
+  for (size_t i = 1 + FILAS_POR_TURNO * (size_t) tid; i < borde;
+      i += salto) {
+    const size_t fin = i + FILAS_POR_TURNO < borde ? i + FILAS_POR_TURNO
+        : borde;
+    copiar_filas(&lamina->mapeo, mem_comp->matrices[0], lamina->paso, i,
+      fin);
+    copiar_bordes(mem_comp->matrices[0], mem_comp->matrices[1],
+      lamina->n_filas, lamina->n_columnas, lamina->paso, i, fin);
+  }
+  if (tid == num_threads - 1) {
+    copiar_filas(&lamina->mapeo, mem_comp->matrices[0], lamina->paso,
+      lamina->n_filas - 1, lamina->n_filas);
+    copiar_bordes(mem_comp->matrices[0], mem_comp->matrices[1],
+      lamina->n_filas, lamina->n_columnas, lamina->paso, lamina->n_filas - 1,
+      lamina->n_filas);
+  }
+  // La primera iteración lee las filas vecinas de los otros hilos
+  pthread_barrier_wait(&mem_comp->barrier);
+
+  size_t iteracion = 0;
+  while (true) {
+    // La iteración siguiente lee la matriz que escribió la anterior
+    const double* matriz = mem_comp->matrices[iteracion % 2];
+    double* matriz2 = mem_comp->matrices[(iteracion + 1) % 2];
     double local_max = 0.0;
-    // Process assigned rows in round-robin fashion
-    for (size_t i = 1 + tid; i < lamina->n_filas - 1; i += num_threads) {
-      // Process each column in the row (excluding borders)
-      for (size_t j = 1; j < lamina->n_columnas - 1; ++j) {
-        // Compute the next state for the cell
-        double old_val = lamina->matriz[i][j];
-        const double suma_vecinos = lamina->matriz[i-1][j] + lamina->matriz[i][j+1] 
-        + lamina->matriz[i+1][j] + lamina->matriz[i][j-1];
-        const double nuevo_valor = lamina->matriz[i][j] + 
-        coeficiente * (suma_vecinos - 4 * lamina->matriz[i][j]);
-        lamina->matriz2[i][j] = nuevo_valor;
-        // Track local max
-        double cambio_temp = fabs(old_val - nuevo_valor);
-        if (cambio_temp > local_max) {
-            local_max = cambio_temp;
-        }
+    // Pares de filas vecinas en round-robin, ver FILAS_POR_TURNO
+    for (size_t i = 1 + FILAS_POR_TURNO * (size_t) tid; i < borde;
+        i += salto) {
+      const size_t fin = i + FILAS_POR_TURNO < borde ? i + FILAS_POR_TURNO
+          : borde;
+      double cambio_temp = calcular_filas(matriz, matriz2,
+        lamina->paso, lamina->n_columnas, i, fin, coeficiente);
+      if (cambio_temp > local_max) {
+          local_max = cambio_temp;
       }
     }
-    mem_priv->local_max = local_max;
+    mem_priv->local_max[(iteracion + 1) % 2] = local_max;
     // Sincronizar todos los hilos
     pthread_barrier_wait(&mem_comp->barrier);
-    pthread_barrier_wait(&mem_comp->barrier);
+    ++iteracion;
+    // Terminar si la iteración anterior a la recién calculada ya equilibró
+    if (iteracion > 1 && mem_comp->equilibrio[(iteracion - 1) % 2]) {
+      break;
+    }
   }
   return NULL;
 }
@@ -289,7 +367,6 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
   fprintf(archivo_salida, "%s\t%zu\t%lg\t%lg\t%lg\t%zu\t%s\n",
       lamina->nombre, lamina->tiempo, lamina->difusividad,
       lamina->distancia, lamina->epsilon, lamina->iteraciones, duracion);
-  fflush(archivo_salida);
   // nombre del archivo sin extensión
   char nombre_reporte_lamina[BUFFER_MAX] = {0};
   quitar_extension(lamina->nombre, nombre_reporte_lamina);
@@ -310,62 +387,34 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
     return false;
     }
 
-  // Abre el archivo binario para escritura
-  FILE* archivo_bin_lamina = fopen(ruta_r_lamina, "wb");
-  if (archivo_bin_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n",
-      ruta_r_lamina, strerror(errno));
+  // Escribe el encabezado y las filas, sin el relleno, en bloque
+  if (!escribir_matriz(ruta_r_lamina, lamina->n_filas, lamina->n_columnas,
+      lamina->paso, lamina->matriz)) {
     return EXIT_FAILURE;
   }
-  // Escribe el número de filas y columnas en el archivo binario
-  fwrite(&lamina->n_filas, sizeof(size_t), 1, archivo_bin_lamina);
-  fwrite(&lamina->n_columnas, sizeof(size_t), 1, archivo_bin_lamina);
-  // Escribe los valores de la matriz en el archivo binario
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    for (size_t j = 0; j < lamina->n_columnas; ++j) {
-      fwrite(&lamina->matriz[i][j], sizeof(double), 1, archivo_bin_lamina);
-    }
-  }
-
-  // Cierra el archivo binario
-  fclose(archivo_bin_lamina);
 
   return EXIT_SUCCESS;
 }
-int crear_hilos(mem_comp_t* mem_comp, pthread_t** hilos, mem_priv_t** mem_priv) {
-  int error = EXIT_SUCCESS;
-
-  // Reservar memoria para estructuras de los hilos
-  *hilos = (pthread_t*)malloc(mem_comp->hilos_totales * sizeof(pthread_t));
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales) {
   // Memoria privada de cada hilo
-  *mem_priv = (mem_priv_t*)calloc(mem_comp->hilos_totales, sizeof(mem_priv_t));
-
-  if (*hilos && *mem_priv) {
-    // Inicializar atributos privados
-    for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales; ++num_hilo) {
-      (*mem_priv)[num_hilo].num_hilo = num_hilo;
-      (*mem_priv)[num_hilo].mem_comp = mem_comp;
-      // Crea los hilos que ejecutarán la rutina del cambio de temperatura
-      error = pthread_create(&(*hilos)[num_hilo], NULL, calculo_matriz, &(*mem_priv)[num_hilo]);
-      if (error != EXIT_SUCCESS) {
-          return error; // Si ocurre un error en la creación de hilos, retorna el error
-      }
-    }
-  } else {
-    fprintf(stderr, "Error: could not allocate %zu hilos\n"
-      , mem_comp->hilos_totales);
-    error = 1;
+  mem_comp->mem_priv = (mem_priv_t*) calloc(hilos_totales, sizeof(mem_priv_t));
+  if (mem_comp->mem_priv == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu hilos\n", hilos_totales);
+    return EXIT_FAILURE;
   }
-  return error;
-}
-int liberar_memoria(mem_comp_t* mem_comp, mem_priv_t* mem_priv, pthread_t* hilos){
-  // Esperar a que todos los hilos terminen su ejecución
-  for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
-      ; ++num_hilo) {
-    pthread_join(hilos[num_hilo], /*value_ptr*/ NULL);
+  // Inicializar atributos privados
+  for (size_t num_hilo = 0; num_hilo < hilos_totales; ++num_hilo) {
+    mem_comp->mem_priv[num_hilo].num_hilo = num_hilo;
+    mem_comp->mem_priv[num_hilo].mem_comp = mem_comp;
+  }
+  // Crea los hilos, quedan esperando a que se les despache trabajo
+  if (crear_equipo(&mem_comp->equipo, hilos_totales) != EXIT_SUCCESS) {
+    free(mem_comp->mem_priv);
+    return EXIT_FAILURE;
   }
-  // Liberar memoria reservada
-  free(mem_priv);
-  free(hilos);
   return EXIT_SUCCESS;
 }
+void liberar_hilos(mem_comp_t* mem_comp) {
+  destruir_equipo(&mem_comp->equipo);
+  free(mem_comp->mem_priv);
+}
@@ -8,7 +8,15 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <math.h>
+#include "equipo.h"
+#include "estencil.h"
 #include "miscelaneos.h"
+/**
+ * @brief Filas vecinas que toma cada hilo en su turno del round-robin. El
+ * estencil recorre dos filas por pasada, así cada par carga una sola vez las
+ * filas centrales que comparte.
+ */
+#define FILAS_POR_TURNO 2
 /**
  * @brief Estructura de datos que representa una lámina de material para
  * almacenar la información relevante.
@@ -29,13 +37,19 @@ typedef struct {
    */
   size_t n_columnas;
   /**
-   * @brief La matriz con el estado actual de lámina
+   * @brief Cantidad de doubles entre el inicio de dos filas consecutivas,
+   * múltiplo de la línea de caché
+   */
+  size_t paso;
+  /**
+   * @brief La matriz con el estado actual de lámina, la celda (i, j) está en
+   * matriz[i * paso + j]. Las filas y columnas del borde sirven de halo
    */
-  double** matriz;
+  double* matriz;
   /**
    * @brief La matriz con el estado siguiente
    */
-  double** matriz2;
+  double* matriz2;
   /**
    * @brief Punto de equilibrio, cuando el cambio de cada una las celdas en
    * una iteración es menor al punto de equilibrio, termina la simulación
@@ -58,7 +72,13 @@ typedef struct {
    */
   //
   size_t iteraciones;
+  /**
+   * @brief Archivo mapeado de la lámina, abierto hasta que cada hilo copia
+   * sus filas a las matrices
+   */
+  mapeo_lamina_t mapeo;
 } lamina_t;
+typedef struct mem_priv mem_priv_t;
 /**
  * @brief Estructura de datos qque representa la memoria compartida entre
  * los hilos creados
@@ -73,19 +93,48 @@ typedef struct {
    */
   size_t filas_internas;
   /**
-  * @brief Número de hilos que ejecutaran los cálculos
+  * @brief Número de hilos que ejecutaran los cálculos en la lámina actual,
+  * 0 si la lámina no tiene filas internas y se calcula en el hilo main
   */
   size_t hilos_totales;
+  /**
+  * @brief Número de hilos que pidió el usuario
+  */
+  size_t hilos_usuario;
+  /**
+  * @brief Equipo de hilos_usuario + 1 hilos creado una vez para todas las
+  * láminas: los hilos_totales primeros calculan y el siguiente coordina
+  */
+  equipo_t equipo;
+  /**
+  * @brief Memoria privada de cada hilo del equipo
+  */
+  mem_priv_t* mem_priv;
   double max_temp;
   pthread_barrier_t barrier;  // Añadir barrera a la estructura
   double max_temp_global;     // Máximo global compartido
   pthread_mutex_t mutex; 
+  /**
+   * @brief Las dos matrices de la lámina, la iteración k lee matrices[(k-1)%2]
+   * y escribe matrices[k%2]
+   */
+  double* matrices[2];
+  /**
+   * @brief equilibrio[k%2] indica si la iteración k alcanzó el equilibrio.
+   * Se indexa por paridad para que el hilo coordinador escriba la decisión
+   * de una iteración mientras los hilos leen la de la anterior
+   */
+  bool equilibrio[2];
+  /**
+   * @brief CPU a la que se fija cada hilo, leídas de AFINIDAD_ENTORNO
+   */
+  afinidad_t afinidad;
 } mem_comp_t;
 /**
  * @brief Estructura de datos qque representa la memoria privada de cada
  * hilo
  */
-typedef struct {
+struct mem_priv {
   /**
   * @brief Identificador del hilo
   */
@@ -93,9 +142,9 @@ typedef struct {
   /**
   * @brief Puntero al registro de la memoria compartida
   */
-  double local_max;
+  double local_max[2];
   mem_comp_t* mem_comp;
-} mem_priv_t;
+};
 /**
  * @brief Estructura que contiene las rutas y archivos para la simulación.
  *
@@ -145,6 +194,8 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos);
  * @brief Se encarga de tomar los datos del archivo de trabajo que se necesitaran para la simulación
  * 
  * Lee la información de una lámina desde el archivo de trabajo y la almacena en la estructura lámina.
+ * Las matrices solo se reservan: cada hilo copia sus filas desde el mapeo
+ * al iniciar procesar_lamina(), así sus páginas quedan en su nodo NUMA.
  * @param lamina Puntero a la lamina que se va a cargar
  * @param job_file Archivo de trabajo con los datos de la lamina
  * @param prefijo_ruta_trabajo Nombre de carpeta donde se encuentran todos los archivos
@@ -162,6 +213,8 @@ void* calculo_matriz(void* mem);
  * @brief Se encarga de tomar los datos del archivo de trabajo que se necesitaran para la simulación
  * 
  * Lee la información de una lámina desde el archivo de trabajo y la almacena en la estructura lámina.
+ * Las matrices solo se reservan: cada hilo copia sus filas desde el mapeo
+ * al iniciar procesar_lamina(), así sus páginas quedan en su nodo NUMA.
  * @param lamina Puntero a la lamina que se va a cargar
  * @param job_file Archivo de trabajo con los datos de la lamina
  * @param prefijo_ruta_trabajo Nombre de carpeta donde se encuentran todos los archivos
@@ -185,7 +238,10 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
  * @brief Procesa los datos de una lámina
  * 
  * Realiza la simulación de la ditribución de calor siguiendo la fórmula
- * dada, hasta que la lámina este estabilizada
+ * dada, hasta que la lámina este estabilizada. La lámina se despacha al
+ * equipo creado en iniciar_simul(), donde un hilo más coordina las
+ * iteraciones, salvo si no tiene filas internas: esa se simula en el hilo
+ * main sin barreras
  * 
  * @param lamina struct lamina
  * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
@@ -204,12 +260,17 @@ int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp);
 int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
   lamina_t* lamina);
 /**
-* @brief función para crear y gestionar hilos. 
-* Le asigna la informacion privada a cada hilo y los manda a ejecutar 
-* la rutina calculo_matriz()
+* @brief función para crear el equipo de hilos y su memoria privada. 
+* Los hilos quedan estacionados hasta que procesar_lamina() les despache
+* una lámina, y se reutilizan en todas las láminas.
 * @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+* @param hilos_totales Cantidad de hilos del equipo.
 * @return int error: 0 Success : 1 Failure
 */
-int crear_hilos(mem_comp_t* mem_comp, pthread_t** hilos, mem_priv_t** mem_priv);
-int liberar_memoria(mem_comp_t* mem_comp, mem_priv_t* mem_priv, pthread_t* hilos);
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales);
+/**
+* @brief Termina el equipo de hilos y libera su memoria privada.
+* @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+*/
+void liberar_hilos(mem_comp_t* mem_comp);
 #endif
@@ -0,0 +1,61 @@
+// Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#ifndef ESTENCIL_H
+#define ESTENCIL_H
+#include <stddef.h>
+/**
+ * @brief Variable de entorno que permite forzar una implementación del
+ * estencil: escalar, sse2, avx2 o avx512.
+ */
+#define ESTENCIL_ENTORNO "ESTENCIL_ISA"
+/**
+ * @brief Firma común de las implementaciones del estencil de 5 puntos.
+ *
+ * Calcula matriz2 a partir de matriz para las filas [fila_inicio,
+ * fila_final) y las columnas internas, y en la misma pasada obtiene el
+ * mayor cambio absoluto de temperatura entre ambos estados.
+ *
+ * @param matriz Matriz con el estado actual.
+ * @param matriz2 Matriz donde se escribe el estado siguiente.
+ * @param paso Paso de las filas de ambas matrices.
+ * @param n_columnas Número de columnas de la lámina, incluidos bordes.
+ * @param fila_inicio Primera fila a calcular, debe ser mayor a 0.
+ * @param fila_final Fila siguiente a la última, a lo sumo n_filas - 1.
+ * @param coeficiente Coeficiente de difusión térmica.
+ * @return Mayor cambio de temperatura en las filas calculadas.
+ */
+typedef double (*estencil_t)(const double* matriz, double* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Elige la implementación más ancha que soporta el procesador.
+ *
+ * Si ESTENCIL_ISA está definida y el procesador soporta la implementación
+ * pedida, se usa esa. Debe llamarse antes de crear los hilos.
+ */
+void seleccionar_estencil(void);
+/**
+ * @brief Retorna el nombre de la implementación elegida.
+ *
+ * @return escalar, sse2, avx2 o avx512.
+ */
+const char* nombre_estencil(void);
+/**
+ * @brief Aplica la implementación elegida a un rango de filas.
+ *
+ * Todas las implementaciones suman en el mismo orden que la versión
+ * escalar, por lo que los resultados son idénticos bit a bit.
+ *
+ * @see estencil_t
+ */
+double calcular_filas(const double* matriz, double* matriz2, size_t paso,
+  size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+/**
+ * @brief Implementación escalar de referencia del estencil.
+ *
+ * @see estencil_t
+ */
+double calcular_filas_escalar(const double* matriz, double* matriz2,
+  size_t paso, size_t n_columnas, size_t fila_inicio, size_t fila_final,
+  double coeficiente);
+#endif
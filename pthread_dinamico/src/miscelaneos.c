@@ -1,8 +1,20 @@
 // Copyright 2025 Luis Arias <luisalfredo.arias@ucr.ac.cr> CC-BY 4.0
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include "miscelaneos.h"
+// Mínimo que garantiza POSIX, por si limits.h no lo expone
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 // Función para intercambiar dos matrices dinámicas
-void intercambiar_matriz(double*** matriz1, double*** matriz2) {
-  double** temp = *matriz1;
+void intercambiar_matriz(double** matriz1, double** matriz2) {
+  double* temp = *matriz1;
   *matriz1 = *matriz2;
   *matriz2 = temp;
 }
@@ -16,33 +28,261 @@ void format_time(const time_t seconds, char* duracion) {
       "%04d/%02d/%02d\t%02d:%02d:%02d", gmt->tm_year - 70, gmt->tm_mon,
       gmt->tm_mday - 1, gmt->tm_hour, gmt->tm_min, gmt->tm_sec);
 }
+// Función para calcular el paso de las filas alineado a la línea de caché
+size_t calcular_paso(const size_t n_columnas) {
+  const size_t doubles_por_linea = LINEA_CACHE / sizeof(double);
+  return (n_columnas + doubles_por_linea - 1) / doubles_por_linea
+      * doubles_por_linea;
+}
+// Función para reservar una matriz dinámica de tipo double sin inicializar
+double* reservar_matriz(const size_t n_filas, const size_t paso) {
+  // Un solo bloque para todas las filas, el paso es múltiplo de LINEA_CACHE
+  // por lo que el tamaño cumple lo que exige aligned_alloc
+  const size_t bytes = n_filas * paso * sizeof(double);
+  if (bytes < PAGINA_GRANDE) {
+    return (double*) aligned_alloc(LINEA_CACHE, bytes);
+  }
+  // Las matrices grandes se alinean a páginas de 2 MiB para que el kernel
+  // pueda respaldarlas con páginas grandes y usar menos entradas de TLB
+  const size_t redondeado = (bytes + PAGINA_GRANDE - 1) / PAGINA_GRANDE
+      * PAGINA_GRANDE;
+  double* matriz = (double*) aligned_alloc(PAGINA_GRANDE, redondeado);
+  if (matriz) {
+    // Solo es un consejo, sin soporte de páginas grandes se ignora
+    madvise(matriz, redondeado, MADV_HUGEPAGE);
+  }
+  return matriz;
+}
 // Función para crear una matriz dinámica de tipo double
-double** crear_matriz(const size_t n_filas, const size_t n_columnas) {
-  // Allocate the array of pointers to the rows.
-  double** matrix = (double**) calloc(n_filas, sizeof(double*));
+double* crear_matriz(const size_t n_filas, const size_t paso) {
+  double* matrix = reservar_matriz(n_filas, paso);
   if (matrix) {
-    for (size_t i = 0; i < n_filas; ++i) {
-      if ((matrix[i] = (double*) calloc(n_columnas, sizeof(double))) ==
-          NULL) {
-        // If allocation fails, free whatever had already been allocated.
-        liberar_matriz(matrix, n_filas);
-        return NULL;
-      }
-    }
+    // El relleno también queda en cero
+    memset(matrix, 0, n_filas * paso * sizeof(double));
   }
   return matrix;
 }
-// Función para liberar la memoria de una matriz dinámica
-void liberar_matriz(double** matrix, const size_t n_filas) {
-  if (matrix) {
-    // Free the rows.
-    for (size_t i = 0; i < n_filas; ++i) {
-      free(matrix[i]);
+// Función para mapear el archivo de una lámina y validar su encabezado
+bool abrir_lamina(const char* ruta, mapeo_lamina_t* mapeo) {
+  const int archivo = open(ruta, O_RDONLY);
+  if (archivo < 0) {
+    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta, strerror(errno));
+    return false;
+  }
+  struct stat estado;
+  if (fstat(archivo, &estado) != 0) {
+    fprintf(stderr, "Error al consultar archivo:%s: %s\n", ruta,
+        strerror(errno));
+    close(archivo);
+    return false;
+  }
+  const size_t encabezado = 2 * sizeof(size_t);
+  const size_t bytes = (size_t) estado.st_size;
+  if (bytes < encabezado) {
+    fprintf(stderr, "Error: %s no tiene encabezado de lámina\n", ruta);
+    close(archivo);
+    return false;
+  }
+  const char* datos = (const char*) mmap(NULL, bytes, PROT_READ, MAP_PRIVATE,
+      archivo, 0);
+  // El mapeo sigue siendo válido después de cerrar el descriptor
+  close(archivo);
+  if (datos == MAP_FAILED) {
+    fprintf(stderr, "Error al mapear archivo:%s: %s\n", ruta, strerror(errno));
+    return false;
+  }
+  // Se recorre una sola vez de inicio a fin
+  madvise((void*) datos, bytes, MADV_SEQUENTIAL);
+  madvise((void*) datos, bytes, MADV_WILLNEED);
+
+  // El encabezado debe describir exactamente el resto del archivo
+  size_t filas = 0;
+  size_t columnas = 0;
+  memcpy(&filas, datos, sizeof(size_t));
+  memcpy(&columnas, datos + sizeof(size_t), sizeof(size_t));
+  if (filas == 0 || columnas == 0
+      || filas > (SIZE_MAX - encabezado) / sizeof(double) / columnas
+      || encabezado + filas * columnas * sizeof(double) != bytes) {
+    fprintf(stderr, "Error: %s dice %zu x %zu celdas pero mide %zu bytes\n",
+        ruta, filas, columnas, bytes);
+    munmap((void*) datos, bytes);
+    return false;
+  }
+  mapeo->datos = datos;
+  mapeo->bytes = bytes;
+  mapeo->celdas = (const double*) (datos + encabezado);
+  mapeo->n_filas = filas;
+  mapeo->n_columnas = columnas;
+  return true;
+}
+// Función para copiar un rango de filas del mapeo a la matriz
+void copiar_filas(const mapeo_lamina_t* mapeo, double* matriz, size_t paso,
+    size_t fila_inicio, size_t fila_fin) {
+  const size_t columnas = mapeo->n_columnas;
+  const size_t relleno = (paso - columnas) * sizeof(double);
+  for (size_t i = fila_inicio; i < fila_fin; ++i) {
+    double* fila = matriz + i * paso;
+    memcpy(fila, mapeo->celdas + i * columnas, columnas * sizeof(double));
+    memset(fila + columnas, 0, relleno);
+  }
+}
+// Función para liberar el mapeo de una lámina
+void cerrar_lamina(mapeo_lamina_t* mapeo) {
+  if (mapeo->datos) {
+    munmap((void*) mapeo->datos, mapeo->bytes);
+    mapeo->datos = NULL;
+  }
+}
+// Función para cargar la matriz de una lámina desde su archivo mapeado
+bool mapear_matriz(const char* ruta, size_t* n_filas, size_t* n_columnas,
+    size_t* paso, double** matriz) {
+  mapeo_lamina_t mapeo;
+  if (!abrir_lamina(ruta, &mapeo)) {
+    return false;
+  }
+  *n_filas = mapeo.n_filas;
+  *n_columnas = mapeo.n_columnas;
+  *paso = calcular_paso(mapeo.n_columnas);
+  *matriz = reservar_matriz(mapeo.n_filas, *paso);
+  if (*matriz == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", ruta);
+    cerrar_lamina(&mapeo);
+    return false;
+  }
+  copiar_filas(&mapeo, *matriz, *paso, 0, mapeo.n_filas);
+  cerrar_lamina(&mapeo);
+  return true;
+}
+// Función para copiar los bordes de un rango de filas a la segunda matriz
+void copiar_bordes(const double* matriz, double* matriz2, size_t n_filas,
+    size_t n_columnas, size_t paso, size_t fila_inicio, size_t fila_fin) {
+  const size_t relleno = (paso - n_columnas) * sizeof(double);
+  for (size_t i = fila_inicio; i < fila_fin; ++i) {
+    const double* origen = matriz + i * paso;
+    double* fila2 = matriz2 + i * paso;
+    if (i == 0 || i == n_filas - 1) {
+      // Bordes superior e inferior completos
+      memcpy(fila2, origen, n_columnas * sizeof(double));
+    } else {
+      // Solo los bordes izquierdo y derecho
+      fila2[0] = origen[0];
+      fila2[n_columnas - 1] = origen[n_columnas - 1];
     }
-    // Free the pointers.
-    free(matrix);
+    memset(fila2 + n_columnas, 0, relleno);
   }
 }
+// Función para crear la segunda matriz de una lámina, solo con los bordes
+double* crear_matriz_bordes(const double* matriz, size_t n_filas,
+    size_t n_columnas, size_t paso) {
+  double* matriz2 = reservar_matriz(n_filas, paso);
+  if (matriz2 == NULL) {
+    return NULL;
+  }
+  copiar_bordes(matriz, matriz2, n_filas, n_columnas, paso, 0, n_filas);
+  return matriz2;
+}
+// Función para cargar las matrices de una lámina desde su archivo mapeado
+bool mapear_matrices(const char* ruta, size_t* n_filas, size_t* n_columnas,
+    size_t* paso, double** matriz, double** matriz2) {
+  if (!mapear_matriz(ruta, n_filas, n_columnas, paso, matriz)) {
+    return false;
+  }
+  *matriz2 = crear_matriz_bordes(*matriz, *n_filas, *n_columnas, *paso);
+  if (*matriz2 == NULL) {
+    fprintf(stderr, "Error al crear las matrices de %s\n", ruta);
+    liberar_matriz(*matriz);
+    return false;
+  }
+  return true;
+}
+// Indica si la variable de entorno vale 1
+static bool entorno_activo(const char* variable) {
+  const char* valor = getenv(variable);
+  return valor && strcmp(valor, "1") == 0;
+}
+// Función para escribir una matriz en formato de lámina con writev
+bool escribir_segmentos(int archivo, struct iovec* iov, size_t segmentos) {
+  size_t actual = 0;
+  while (actual < segmentos) {
+    const size_t lote = segmentos - actual < IOV_MAX
+        ? segmentos - actual : IOV_MAX;
+    ssize_t escritos = writev(archivo, iov + actual, (int) lote);
+    if (escritos < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    // Una escritura parcial puede terminar a la mitad de un segmento
+    while (actual < segmentos && (size_t) escritos >= iov[actual].iov_len) {
+      escritos -= (ssize_t) iov[actual].iov_len;
+      ++actual;
+    }
+    if (escritos > 0) {
+      iov[actual].iov_base = (char*) iov[actual].iov_base + escritos;
+      iov[actual].iov_len -= (size_t) escritos;
+    }
+  }
+  return true;
+}
+bool escribir_matriz(const char* ruta, size_t n_filas, size_t n_columnas,
+    size_t paso, const double* matriz) {
+  struct timespec inicio;
+  clock_gettime(CLOCK_MONOTONIC, &inicio);
+  // Un segmento para el encabezado y uno por fila, o uno solo para todas las
+  // filas si no hay relleno entre ellas
+  const size_t filas_segmento = paso == n_columnas ? n_filas : 1;
+  const size_t segmentos = 1 + (n_filas + filas_segmento - 1) / filas_segmento;
+  struct iovec* iov = (struct iovec*) malloc(segmentos * sizeof(struct iovec));
+  if (iov == NULL) {
+    fprintf(stderr, "Error al crear los segmentos de %s\n", ruta);
+    return false;
+  }
+  const size_t encabezado[2] = {n_filas, n_columnas};
+  iov[0].iov_base = (void*) encabezado;
+  iov[0].iov_len = sizeof(encabezado);
+  for (size_t k = 1; k < segmentos; ++k) {
+    iov[k].iov_base = (void*) (matriz + (k - 1) * filas_segmento * paso);
+    iov[k].iov_len = filas_segmento * n_columnas * sizeof(double);
+  }
+  const size_t bytes = sizeof(encabezado) + n_filas * n_columnas
+      * sizeof(double);
+
+  const int archivo = open(ruta, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (archivo < 0) {
+    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta, strerror(errno));
+    free(iov);
+    return false;
+  }
+  bool correcto = escribir_segmentos(archivo, iov, segmentos);
+  if (correcto && entorno_activo(SINCRONIZAR_ENTORNO)) {
+    correcto = fdatasync(archivo) == 0;
+  }
+  if (!correcto) {
+    fprintf(stderr, "Error al escribir archivo:%s: %s\n", ruta,
+        strerror(errno));
+  }
+  if (close(archivo) != 0 && correcto) {
+    fprintf(stderr, "Error al cerrar archivo:%s: %s\n", ruta,
+        strerror(errno));
+    correcto = false;
+  }
+  free(iov);
+
+  if (correcto && entorno_activo(ESTADISTICAS_ENTORNO)) {
+    struct timespec final;
+    clock_gettime(CLOCK_MONOTONIC, &final);
+    const double segundos = (double) (final.tv_sec - inicio.tv_sec)
+        + (double) (final.tv_nsec - inicio.tv_nsec) / 1e9;
+    fprintf(stderr, "%s\t%zu bytes\t%.6f s\t%.1f MB/s\n", ruta, bytes,
+        segundos, segundos > 0 ? bytes / segundos / 1e6 : 0.0);
+  }
+  return correcto;
+}
+// Función para liberar la memoria de una matriz dinámica
+void liberar_matriz(double* matrix) {
+  free(matrix);
+}
 // Función para eliminar la extensión de un archivo
 void quitar_extension(const char *archivo, char *nombre_sin_ext) {
   if (archivo == NULL || nombre_sin_ext == NULL) {
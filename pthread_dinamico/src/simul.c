@@ -8,6 +8,8 @@ int iniciar_simul(int argc, char* argv[]) {
   if (preparar_archivos(argc, argv, &archivos)!= EXIT_SUCCESS) {
     return EXIT_FAILURE;
   }
+  // Elige la implementación del estencil según el procesador
+  seleccionar_estencil();
   // Obtiene el número de hilos que indica el usuario
   size_t hilos_usuario = sysconf(_SC_NPROCESSORS_ONLN);
   if (sscanf(argv[2], "%zu", &hilos_usuario) == 1) {
@@ -20,7 +22,14 @@ int iniciar_simul(int argc, char* argv[]) {
 
   mem_comp_t mem_comp;
   mem_comp.lamina = &lamina;
-  mem_comp.hilos_totales = hilos_usuario;
+  mem_comp.hilos_usuario = hilos_usuario;
+  // El equipo se crea una vez y queda estacionado entre láminas: hasta
+  // hilos_usuario hilos calculan y uno más coordina cada iteración
+  if (crear_hilos(&mem_comp, hilos_usuario + 1) != EXIT_SUCCESS) {
+    fclose(archivos.archivo_trabajo);
+    fclose(archivos.archivo_salida);
+    return EXIT_FAILURE;
+  }
 
   int error = 0;
   bool hay_laminas = true;
@@ -38,10 +47,11 @@ int iniciar_simul(int argc, char* argv[]) {
         if (error != 0) {
             break;
         }
-        liberar_matriz(lamina.matriz, lamina.n_filas);
-        liberar_matriz(lamina.matriz2, lamina.n_filas);
+        liberar_matriz(lamina.matriz);
+        liberar_matriz(lamina.matriz2);
     }
   }
+  liberar_hilos(&mem_comp);
   // Cierra los archivos abiertos
   fclose(archivos.archivo_trabajo);
   fclose(archivos.archivo_salida);
@@ -102,58 +112,10 @@ bool cargar_lamina(lamina_t* lamina, FILE* archivo_trabajo,
       ruta_lamina)) {
     return false;
   }
-  FILE* archivo_lamina = fopen(ruta_lamina, "rb");
-  if (archivo_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta_lamina,
-        strerror(errno));
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee el número de filas y columnas de la matriz de la lámina
-  if (fread(&lamina->n_filas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de filas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  if (fread(&lamina->n_columnas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de columnas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  // Crea las matrices para el estado actual y el siguiente
-  lamina->matriz = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz == NULL) {
-    fprintf(stderr, "Error al crear la matriz 1");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
-  }
-  lamina->matriz2 = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz2 == NULL) {
-    fprintf(stderr, "Error al crear la matriz 2");
-    liberar_matriz(lamina->matriz, lamina->n_filas);
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee los valores de la matriz
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    if (fread(lamina->matriz[i], sizeof(double), lamina->n_columnas,
-        archivo_lamina) == 0) {
-      fprintf(stderr, "Error: al leer valores de la matriz");
-      liberar_matriz(lamina->matriz, lamina->n_filas);
-      liberar_matriz(lamina->matriz2, lamina->n_filas);
-      fclose(archivo_lamina);
-      fclose(archivo_trabajo);
-      return false;
-    }
-    // Copiar los datos de matriz a matriz2
-    memcpy(lamina->matriz2[i], lamina->matriz[i], sizeof(double) *
-      lamina->n_columnas);
-  }
-  // Cierra el archivo de la lámina
-  fclose(archivo_lamina);
-  return true;
+  // Mapea la lámina y crea las matrices para el estado actual y el
+  // siguiente directo desde el mapeo. El archivo de trabajo lo cierra main
+  return mapear_matrices(ruta_lamina, &lamina->n_filas, &lamina->n_columnas,
+      &lamina->paso, &lamina->matriz, &lamina->matriz2);
 }
 bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   char* prefijo_ruta_trabajo, char* ruta_lamina) {
@@ -165,7 +127,7 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   // Lee los datos de la lámina (tiempo, difusividad, distancia, epsilon)
   if (fscanf(archivo_trabajo, "%zu %lf %lf %lf", &lamina->tiempo,
         &lamina->difusividad, &lamina->distancia, &lamina->epsilon) < 4) {
-    liberar_matriz(lamina->matriz, lamina->n_filas);
+    liberar_matriz(lamina->matriz);
     fclose(archivo_trabajo);
     fprintf(stderr, "Error al leer datos de la lamina: %s\n",
       strerror(errno));
@@ -180,69 +142,126 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   }
   return true;
 }
+// Simula en el hilo main una lámina sin filas internas, que no tiene
+// filas que repartir entre los hilos. Las matrices ya están cargadas con
+// sus bordes
+static int simular_serial(lamina_t* lamina, double coeficiente) {
+  double* matriz = lamina->matriz;
+  double* matriz2 = lamina->matriz2;
+  size_t iteraciones = 0;
+  double max_temp = 0.0;
+  do {
+    max_temp = calcular_filas(matriz, matriz2, lamina->paso,
+      lamina->n_columnas, 1, lamina->n_filas - 1, coeficiente);
+    double* siguiente = matriz2;
+    matriz2 = matriz;
+    matriz = siguiente;
+    ++iteraciones;
+  } while (max_temp > lamina->epsilon);
+  lamina->matriz = matriz;
+  lamina->matriz2 = matriz2;
+  lamina->iteraciones = iteraciones;
+  return EXIT_SUCCESS;
+}
+/**
+ * @brief Coordina una lámina desde el hilo del equipo que no calcula:
+ * reinicia el contador de filas y reduce el máximo de cada iteración hasta
+ * el equilibrio.
+ * @param mem_comp Puntero a la memoria compartida de la lámina en curso.
+ */
+static void coordinar_lamina(mem_comp_t* mem_comp) {
+  lamina_t* lamina = mem_comp->lamina;
+  // Una sola barrera por iteración: mientras los hilos calculan la
+  // iteración k + 1 de forma especulativa, el coordinador reduce el máximo
+  // de la iteración k. Si k alcanzó el equilibrio, la iteración k + 1
+  // escribió en la otra matriz y simplemente se descarta.
+  size_t iteracion = 0;
+  while (true) {
+    pthread_barrier_wait(&mem_comp->barrier); // Esperar a que los hilos terminen
+    ++iteracion;
+    if (iteracion > 1 && mem_comp->equilibrio[(iteracion - 1) % 2]) {
+      --iteracion;
+      break;
+    }
+    // Reiniciar el contador de la iteración recién terminada para la
+    // iteración iteracion + 2. Los hilos usan el otro hasta la próxima
+    // barrera, que ordena la escritura
+    atomic_store_explicit(&mem_comp->current_row[iteracion % 2], 1,
+        memory_order_relaxed);
+
+    // Calcular máximo global y actualizar
+    double global_max = 0.0;
+    for (size_t i = 0; i < mem_comp->hilos_totales; ++i) {
+        if (mem_comp->mem_priv[i].p_max_temp[iteracion % 2] > global_max) {
+            global_max = mem_comp->mem_priv[i].p_max_temp[iteracion % 2];
+        }
+    }
+    mem_comp->max_temp = global_max;
+    mem_comp->equilibrio[iteracion % 2] = global_max <= lamina->epsilon;
+  }
+  // La última iteración válida quedó en matrices[iteracion % 2]
+  lamina->matriz = mem_comp->matrices[iteracion % 2];
+  lamina->matriz2 = mem_comp->matrices[(iteracion + 1) % 2];
+  lamina->iteraciones = iteracion;
+}
+
+/**
+ * @brief Rutina que se despacha al equipo por cada lámina: el hilo
+ * hilos_totales coordina y los anteriores calculan sus filas.
+ * @param mem Puntero a la memoria privada del hilo.
+ * @return NULL
+ */
+static void* trabajar_lamina(void* mem) {
+  mem_priv_t* mem_priv = (mem_priv_t*) mem;
+  if (mem_priv->num_hilo == mem_priv->mem_comp->hilos_totales) {
+    coordinar_lamina(mem_priv->mem_comp);
+    return NULL;
+  }
+  return calculo_matriz(mem);
+}
+
 int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp) {
   // Suponemos que la lámina no está en equilibrio
   mem_comp->max_temp = lamina->epsilon + 1;;
   
-  // Actualizar filas internas e hilos según los datos de la lamina
-  mem_comp->filas_internas = lamina->n_filas - 2;
-  mem_comp->hilos_totales = mem_comp->hilos_totales < mem_comp->filas_internas
-      ? mem_comp->hilos_totales : mem_comp->filas_internas;
-  size_t hilos_totales = mem_comp->hilos_totales;
-
   mem_comp->coeficiente = (lamina->tiempo * lamina->difusividad)
   /(lamina->distancia * lamina->distancia);
- //
-  double epsilon = lamina->epsilon;
 
+  // Actualizar filas internas e hilos según los datos de la lamina. A lo
+  // sumo un hilo por fila
+  mem_comp->filas_internas = lamina->n_filas > 2 ? lamina->n_filas - 2 : 0;
+  mem_comp->hilos_totales = mem_comp->hilos_usuario < mem_comp->filas_internas
+      ? mem_comp->hilos_usuario : mem_comp->filas_internas;
+  if (mem_comp->hilos_totales == 0) {
+    return simular_serial(lamina, mem_comp->coeficiente);
+  }
   if (pthread_barrier_init(&mem_comp->barrier, NULL,
       mem_comp->hilos_totales + 1) != 0) {
     fprintf(stderr, "Error: barrier initialization failed\n");
     //destroy_matrix(lamina->matriz2, lamina->n_filas);
     return EXIT_FAILURE;
   }
-  pthread_mutex_init(&mem_comp->mutex_row, NULL);
-
-  int error = 0;
-  // Hasta que se equilibre.
-  pthread_t* hilos = NULL;
-  mem_priv_t* mem_priv = NULL;
+  // Filas por trozo para que cada trozo tenga al menos CELDAS_TROZO celdas
+  mem_comp->trozo_minimo = CELDAS_TROZO / lamina->n_columnas;
+  if (mem_comp->trozo_minimo == 0) {
+    mem_comp->trozo_minimo = 1;
+  }
 
-  mem_comp->current_row = 1;
+  // Las matrices se alternan según la paridad de la iteración
+  mem_comp->matrices[0] = lamina->matriz;
+  mem_comp->matrices[1] = lamina->matriz2;
+  mem_comp->equilibrio[0] = false;
+  mem_comp->equilibrio[1] = false;
 
-  error = crear_hilos(mem_comp, &hilos, &mem_priv);
+  atomic_init(&mem_comp->current_row[0], 1);
+  atomic_init(&mem_comp->current_row[1], 1);
 
-  while (mem_comp->max_temp > epsilon) { 
-    pthread_barrier_wait(&mem_comp->barrier); // Esperar a que los hilos terminen
-    
-    // Calcular máximo global y actualizar
-    double global_max = 0.0;
-    for (size_t i = 0; i < hilos_totales; ++i) {
-        if (mem_priv[i].p_max_temp > global_max) global_max = mem_priv[i].p_max_temp;
-    }
-    mem_comp->max_temp = global_max;
-    //printf(" Esta es la temperatura %lf \n",global_max );
-    // Intercambiar matrices y reiniciar current_row
-    double **temp = lamina->matriz;
-    lamina->matriz = lamina->matriz2;
-    lamina->matriz2 = temp;
-    lamina->iteraciones++;
-    
-    // Reiniciar current_row para la próxima iteración
-    pthread_mutex_lock(&mem_comp->mutex_row);
-    mem_comp->current_row = 1; // Primera fila interna
-    pthread_mutex_unlock(&mem_comp->mutex_row);
-    
-    pthread_barrier_wait(&mem_comp->barrier); // Liberar hilos para nueva iteración
-} 
-  for (size_t i = 0; i < hilos_totales; ++i) {
-    pthread_join(hilos[i], NULL);
-  }
+  // Despierta al equipo estacionado y espera a que la lámina se equilibre,
+  // sin crear ni unir hilos
+  despachar_equipo(&mem_comp->equipo, trabajar_lamina, mem_comp->mem_priv,
+    sizeof(mem_priv_t), mem_comp->hilos_totales + 1);
   pthread_barrier_destroy(&mem_comp->barrier);
-  pthread_mutex_destroy(&mem_comp->mutex_row);
-  free(hilos);
-  free(mem_priv);
-  return error;
+  return EXIT_SUCCESS;
 }
 
 void* calculo_matriz(void* mem) {
@@ -250,46 +269,61 @@ void* calculo_matriz(void* mem) {
   mem_comp_t* mem_comp = mem_priv->mem_comp;
   lamina_t* lamina = mem_comp->lamina;
   double coeficiente = mem_comp->coeficiente;
-  double epsilon = lamina->epsilon;
   size_t n_columnas = lamina->n_columnas;
+  size_t paso = lamina->paso;
   double p_max_temp = 0.0;
 
-  while (mem_comp->max_temp > epsilon) { 
+  size_t iteracion = 0;
+  while (true) {
+      // La iteración siguiente lee la matriz que escribió la anterior
+      const double* matriz = mem_comp->matrices[iteracion % 2];
+      double* matriz2 = mem_comp->matrices[(iteracion + 1) % 2];
+      atomic_size_t* fila_libre = &mem_comp->current_row[(iteracion + 1) % 2];
       p_max_temp = 0.0;
-      // Mapeo dinámico: cada hilo toma una fila disponible
-      while (1) {
-          pthread_mutex_lock(&mem_comp->mutex_row);
-          size_t row = mem_comp->current_row;
-          if (row >= lamina->n_filas - 1) { // Fin de las filas internas
-              pthread_mutex_unlock(&mem_comp->mutex_row);
-              break;
-          }
-          mem_comp->current_row++; // Siguiente fila para otro hilo
-          pthread_mutex_unlock(&mem_comp->mutex_row);
-
-          // Procesar la fila obtenida (row)
-          for (size_t j = 1; j < n_columnas - 1; ++j) {
-              lamina->matriz2[row][j] = lamina->matriz[row][j] + coeficiente * 
-                  (lamina->matriz[row-1][j] + lamina->matriz[row][j+1] + 
-                   lamina->matriz[row+1][j] + lamina->matriz[row][j-1] - 
-                   4 * lamina->matriz[row][j]);
-              double cambio_temp = fabs(lamina->matriz[row][j] - lamina->matriz2[row][j]);
-              if (cambio_temp > p_max_temp) p_max_temp = cambio_temp;
-          }
+      // Mapeo dinámico: cada hilo toma un trozo de filas disponible
+      size_t row = 0;
+      size_t filas = 0;
+      while ((filas = tomar_trozo(mem_comp, fila_libre, lamina->n_filas - 1,
+          &row)) > 0) {
+          // Procesar las filas obtenidas [row, row + filas)
+          double cambio_temp = calcular_filas(matriz, matriz2, paso,
+              n_columnas, row, row + filas, coeficiente);
+          if (cambio_temp > p_max_temp) p_max_temp = cambio_temp;
       }
-      
-      mem_priv->p_max_temp = p_max_temp;
+
+      mem_priv->p_max_temp[(iteracion + 1) % 2] = p_max_temp;
       // Sincronizar para calcular el máximo global
       pthread_barrier_wait(&mem_comp->barrier);
-      // Esperar a que se actualicen matrices y max_temp
-      pthread_barrier_wait(&mem_comp->barrier);
-      
-      // Resetear current_row para la próxima iteración (gestión desde main)
+      ++iteracion;
+      // Terminar si la iteración anterior a la recién calculada ya equilibró
+      if (iteracion > 1 && mem_comp->equilibrio[(iteracion - 1) % 2]) {
+        break;
+      }
   }
   return NULL;
 }
 
 
+size_t tomar_trozo(mem_comp_t* mem_comp, atomic_size_t* fila_libre,
+    size_t fila_final, size_t* inicio) {
+  size_t actual = atomic_load_explicit(fila_libre, memory_order_relaxed);
+  size_t filas = 0;
+  do {
+    if (actual >= fila_final) { // Fin de las filas internas
+      return 0;
+    }
+    // Trozo guiado: grande al inicio y cada vez menor
+    const size_t restantes = fila_final - actual;
+    filas = restantes / (2 * mem_comp->hilos_totales);
+    if (filas < mem_comp->trozo_minimo) filas = mem_comp->trozo_minimo;
+    if (filas > restantes) filas = restantes;
+    // Si otro hilo tomó filas antes, actual se actualiza y se reintenta
+  } while (!atomic_compare_exchange_weak_explicit(fila_libre, &actual,
+      actual + filas, memory_order_relaxed, memory_order_relaxed));
+  *inicio = actual;
+  return filas;
+}
+
 int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
     lamina_t* lamina) {
   // Guarda el tiempo de la simulación
@@ -300,7 +334,6 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
   fprintf(archivo_salida, "%s\t%zu\t%lg\t%lg\t%lg\t%zu\t%s\n",
       lamina->nombre, lamina->tiempo, lamina->difusividad,
       lamina->distancia, lamina->epsilon, lamina->iteraciones, duracion);
-  fflush(archivo_salida);
   // nombre del archivo sin extensión
   char nombre_reporte_lamina[BUFFER_MAX] = {0};
   quitar_extension(lamina->nombre, nombre_reporte_lamina);
@@ -321,62 +354,34 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
     return false;
     }
 
-  // Abre el archivo binario para escritura
-  FILE* archivo_bin_lamina = fopen(ruta_r_lamina, "wb");
-  if (archivo_bin_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n",
-      ruta_r_lamina, strerror(errno));
+  // Escribe el encabezado y las filas, sin el relleno, en bloque
+  if (!escribir_matriz(ruta_r_lamina, lamina->n_filas, lamina->n_columnas,
+      lamina->paso, lamina->matriz)) {
     return EXIT_FAILURE;
   }
-  // Escribe el número de filas y columnas en el archivo binario
-  fwrite(&lamina->n_filas, sizeof(size_t), 1, archivo_bin_lamina);
-  fwrite(&lamina->n_columnas, sizeof(size_t), 1, archivo_bin_lamina);
-  // Escribe los valores de la matriz en el archivo binario
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    for (size_t j = 0; j < lamina->n_columnas; ++j) {
-      fwrite(&lamina->matriz[i][j], sizeof(double), 1, archivo_bin_lamina);
-    }
-  }
-
-  // Cierra el archivo binario
-  fclose(archivo_bin_lamina);
 
   return EXIT_SUCCESS;
 }
-int crear_hilos(mem_comp_t* mem_comp, pthread_t** hilos, mem_priv_t** mem_priv) {
-  int error = EXIT_SUCCESS;
-
-  // Reservar memoria para estructuras de los hilos
-  *hilos = (pthread_t*)malloc(mem_comp->hilos_totales * sizeof(pthread_t));
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales) {
   // Memoria privada de cada hilo
-  *mem_priv = (mem_priv_t*)calloc(mem_comp->hilos_totales, sizeof(mem_priv_t));
-
-  if (*hilos && *mem_priv) {
-    // Inicializar atributos privados
-    for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales; ++num_hilo) {
-      (*mem_priv)[num_hilo].num_hilo = num_hilo;
-      (*mem_priv)[num_hilo].mem_comp = mem_comp;
-      // Crea los hilos que ejecutarán la rutina del cambio de temperatura
-      error = pthread_create(&(*hilos)[num_hilo], NULL, calculo_matriz, &(*mem_priv)[num_hilo]);
-      if (error != EXIT_SUCCESS) {
-          return error; // Si ocurre un error en la creación de hilos, retorna el error
-      }
-    }
-  } else {
-    fprintf(stderr, "Error: could not allocate %zu hilos\n"
-      , mem_comp->hilos_totales);
-    error = 1;
+  mem_comp->mem_priv = (mem_priv_t*) calloc(hilos_totales, sizeof(mem_priv_t));
+  if (mem_comp->mem_priv == NULL) {
+    fprintf(stderr, "Error: could not allocate %zu hilos\n", hilos_totales);
+    return EXIT_FAILURE;
   }
-  return error;
-}
-int liberar_memoria(mem_comp_t* mem_comp, mem_priv_t* mem_priv, pthread_t* hilos){
-  // Esperar a que todos los hilos terminen su ejecución
-  for (size_t num_hilo = 0; num_hilo < mem_comp->hilos_totales
-      ; ++num_hilo) {
-    pthread_join(hilos[num_hilo], /*value_ptr*/ NULL);
+  // Inicializar atributos privados
+  for (size_t num_hilo = 0; num_hilo < hilos_totales; ++num_hilo) {
+    mem_comp->mem_priv[num_hilo].num_hilo = num_hilo;
+    mem_comp->mem_priv[num_hilo].mem_comp = mem_comp;
+  }
+  // Crea los hilos, quedan esperando a que se les despache trabajo
+  if (crear_equipo(&mem_comp->equipo, hilos_totales) != EXIT_SUCCESS) {
+    free(mem_comp->mem_priv);
+    return EXIT_FAILURE;
   }
-  // Liberar memoria reservada
-  free(mem_priv);
-  free(hilos);
   return EXIT_SUCCESS;
 }
+void liberar_hilos(mem_comp_t* mem_comp) {
+  destruir_equipo(&mem_comp->equipo);
+  free(mem_comp->mem_priv);
+}
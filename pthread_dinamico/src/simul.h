@@ -8,7 +8,14 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <math.h>
+#include <stdatomic.h>
+#include "equipo.h"
+#include "estencil.h"
 #include "miscelaneos.h"
+/**
+ * @brief Celdas mínimas que calcula un hilo cada vez que toma filas
+ */
+#define CELDAS_TROZO 4096
 /**
  * @brief Estructura de datos que representa una lámina de material para
  * almacenar la información relevante.
@@ -29,13 +36,19 @@ typedef struct {
    */
   size_t n_columnas;
   /**
-   * @brief La matriz con el estado actual de lámina
+   * @brief Cantidad de doubles entre el inicio de dos filas consecutivas,
+   * múltiplo de la línea de caché
+   */
+  size_t paso;
+  /**
+   * @brief La matriz con el estado actual de lámina, la celda (i, j) está en
+   * matriz[i * paso + j]. Las filas y columnas del borde sirven de halo
    */
-  double** matriz;
+  double* matriz;
   /**
    * @brief La matriz con el estado siguiente
    */
-  double** matriz2;
+  double* matriz2;
   /**
    * @brief Punto de equilibrio, cuando el cambio de cada una las celdas en
    * una iteración es menor al punto de equilibrio, termina la simulación
@@ -59,6 +72,7 @@ typedef struct {
   //
   size_t iteraciones;
 } lamina_t;
+typedef struct mem_priv mem_priv_t;
 /**
  * @brief Estructura de datos qque representa la memoria compartida entre
  * los hilos creados
@@ -73,21 +87,55 @@ typedef struct {
    */
   size_t filas_internas;
   /**
-  * @brief Número de hilos que ejecutaran los cálculos
+  * @brief Número de hilos que ejecutaran los cálculos en la lámina actual,
+  * 0 si la lámina no tiene filas internas y se calcula en el hilo main
   */
   size_t hilos_totales;
-  size_t current_row;
+  /**
+  * @brief Número de hilos que pidió el usuario
+  */
+  size_t hilos_usuario;
+  /**
+  * @brief Equipo de hilos_usuario + 1 hilos creado una vez para todas las
+  * láminas: los hilos_totales primeros calculan y el siguiente coordina
+  */
+  equipo_t equipo;
+  /**
+  * @brief Memoria privada de cada hilo del equipo
+  */
+  mem_priv_t* mem_priv;
+  /**
+  * @brief Siguiente fila sin asignar. Los hilos toman trozos con
+  * compare-and-swap, sin mutex. La iteración k usa current_row[k%2], así el
+  * hilo coordinador reinicia uno mientras los hilos consumen el otro
+  */
+  atomic_size_t current_row[2];
+  /**
+  * @brief Filas mínimas de un trozo, para que filas cortas no hagan que se
+  * compita más por current_row que lo que se calcula
+  */
+  size_t trozo_minimo;
   double max_temp;
   pthread_barrier_t barrier;  // Añadir barrera a la estructura
-  pthread_mutex_t mutex_row;
   double max_temp_global;     // Máximo global compartido
   double coeficiente;
+  /**
+   * @brief Las dos matrices de la lámina, la iteración k lee matrices[(k-1)%2]
+   * y escribe matrices[k%2]
+   */
+  double* matrices[2];
+  /**
+   * @brief equilibrio[k%2] indica si la iteración k alcanzó el equilibrio.
+   * Se indexa por paridad para que el hilo coordinador escriba la decisión
+   * de una iteración mientras los hilos leen la de la anterior
+   */
+  bool equilibrio[2];
 } mem_comp_t;
 /**
  * @brief Estructura de datos qque representa la memoria privada de cada
  * hilo
  */
-typedef struct {
+struct mem_priv {
   /**
   * @brief Identificador del hilo
   */
@@ -95,9 +143,9 @@ typedef struct {
   /**
   * @brief Puntero al registro de la memoria compartida
   */
-  double p_max_temp;
+  double p_max_temp[2];
   mem_comp_t* mem_comp;
-} mem_priv_t;
+};
 /**
  * @brief Estructura que contiene las rutas y archivos para la simulación.
  *
@@ -160,6 +208,20 @@ int preparar_archivos(int argc, char* argv[], archivos_t* archivos);
 * @return void* Hay que retornar algo, en este caso NULL
 **/
 void* calculo_matriz(void* mem);
+/**
+* @brief Toma el siguiente trozo de filas libres de la iteración actual.
+*
+* El trozo es guiado: una parte de las filas restantes proporcional a los
+* hilos, así empieza grande y se reduce al final del recorrido, nunca menor
+* a trozo_minimo.
+* @param mem_comp Puntero a la memoria compartida
+* @param fila_libre Contador de filas de la iteración actual
+* @param fila_final Fila siguiente a la última interna
+* @param inicio Primera fila del trozo tomado
+* @return Cantidad de filas del trozo, 0 si ya no quedan filas
+**/
+size_t tomar_trozo(mem_comp_t* mem_comp, atomic_size_t* fila_libre,
+  size_t fila_final, size_t* inicio);
 /**
  * @brief Se encarga de tomar los datos del archivo de trabajo que se necesitaran para la simulación
  * 
@@ -187,7 +249,10 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
  * @brief Procesa los datos de una lámina
  * 
  * Realiza la simulación de la ditribución de calor siguiendo la fórmula
- * dada, hasta que la lámina este estabilizada
+ * dada, hasta que la lámina este estabilizada. La lámina se despacha al
+ * equipo creado en iniciar_simul(), donde un hilo más coordina las
+ * iteraciones, salvo si no tiene filas internas: esa se simula en el hilo
+ * main sin barreras
  * 
  * @param lamina struct lamina
  * @return EXIT_SUCCESS o en caso contrario EXIT_FAILURE.
@@ -206,12 +271,17 @@ int procesar_lamina(lamina_t* lamina, mem_comp_t* mem_comp);
 int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
   lamina_t* lamina);
 /**
-* @brief función para crear y gestionar hilos. 
-* Le asigna la informacion privada a cada hilo y los manda a ejecutar 
-* la rutina calculo_matriz()
+* @brief función para crear el equipo de hilos y su memoria privada. 
+* Los hilos quedan estacionados hasta que procesar_lamina() les despache
+* una lámina, y se reutilizan en todas las láminas.
 * @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+* @param hilos_totales Cantidad de hilos del equipo.
 * @return int error: 0 Success : 1 Failure
 */
-int crear_hilos(mem_comp_t* mem_comp, pthread_t** hilos, mem_priv_t** mem_priv);
-int liberar_memoria(mem_comp_t* mem_comp, mem_priv_t* mem_priv, pthread_t* hilos);
+int crear_hilos(mem_comp_t* mem_comp, size_t hilos_totales);
+/**
+* @brief Termina el equipo de hilos y libera su memoria privada.
+* @param mem_comp Puntero a la estructura de memoria compartida entre los hilos.
+*/
+void liberar_hilos(mem_comp_t* mem_comp);
 #endif
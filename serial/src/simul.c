@@ -9,6 +9,8 @@ int iniciar_simul(int argc, char* argv[]) {
   if (preparar_archivos(argc, argv, &archivos)!= EXIT_SUCCESS) {
     return EXIT_FAILURE;
   }
+  // Elige la implementación del estencil según el procesador
+  seleccionar_estencil();
   // Crea el struct de la lamina
   lamina_t lamina;
   int error = 0;
@@ -27,8 +29,8 @@ int iniciar_simul(int argc, char* argv[]) {
         if (error != 0) {
             break;
         }
-        liberar_matriz(lamina.matriz, lamina.n_filas);
-        liberar_matriz(lamina.matriz2, lamina.n_filas);
+        liberar_matriz(lamina.matriz);
+        liberar_matriz(lamina.matriz2);
     }
   }
   // Cierra los archivos abiertos
@@ -91,58 +93,10 @@ bool cargar_lamina(lamina_t* lamina, FILE* archivo_trabajo,
       ruta_lamina)) {
     return false;
   }
-  FILE* archivo_lamina = fopen(ruta_lamina, "rb");
-  if (archivo_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n", ruta_lamina,
-        strerror(errno));
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee el número de filas y columnas de la matriz de la lámina
-  if (fread(&lamina->n_filas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de filas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  if (fread(&lamina->n_columnas, sizeof(size_t), 1, archivo_lamina) == 0) {
-    fprintf(stderr, "Error al leer el número de columnas");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-  }
-  // Crea las matrices para el estado actual y el siguiente
-  lamina->matriz = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz == NULL) {
-    fprintf(stderr, "Error al crear la matriz 1");
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
-  }
-  lamina->matriz2 = crear_matriz(lamina->n_filas, lamina->n_columnas);
-  if (lamina->matriz2 == NULL) {
-    fprintf(stderr, "Error al crear la matriz 2");
-    liberar_matriz(lamina->matriz, lamina->n_filas);
-    fclose(archivo_lamina);
-    fclose(archivo_trabajo);
-    return false;
-  }
-  // Lee los valores de la matriz
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    if (fread(lamina->matriz[i], sizeof(double), lamina->n_columnas,
-        archivo_lamina) == 0) {
-      fprintf(stderr, "Error: al leer valores de la matriz");
-      liberar_matriz(lamina->matriz, lamina->n_filas);
-      liberar_matriz(lamina->matriz2, lamina->n_filas);
-      fclose(archivo_lamina);
-      fclose(archivo_trabajo);
-      return false;
-    }
-    // Copiar los datos de matriz a matriz2
-    memcpy(lamina->matriz2[i], lamina->matriz[i], sizeof(double) *
-      lamina->n_columnas);
-  }
-  // Cierra el archivo de la lámina
-  fclose(archivo_lamina);
-  return true;
+  // Mapea la lámina y crea las matrices para el estado actual y el
+  // siguiente directo desde el mapeo. El archivo de trabajo lo cierra main
+  return mapear_matrices(ruta_lamina, &lamina->n_filas, &lamina->n_columnas,
+      &lamina->paso, &lamina->matriz, &lamina->matriz2);
 }
 bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   char* prefijo_ruta_trabajo, char* ruta_lamina) {
@@ -154,7 +108,7 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
   // Lee los datos de la lámina (tiempo, difusividad, distancia, epsilon)
   if (fscanf(archivo_trabajo, "%zu %lf %lf %lf", &lamina->tiempo,
         &lamina->difusividad, &lamina->distancia, &lamina->epsilon) < 4) {
-    liberar_matriz(lamina->matriz, lamina->n_filas);
+    liberar_matriz(lamina->matriz);
     fclose(archivo_trabajo);
     fprintf(stderr, "Error al leer datos de la lamina: %s\n",
       strerror(errno));
@@ -172,28 +126,19 @@ bool leer_datos_lamina(lamina_t* lamina, FILE* archivo_trabajo,
 int procesar_lamina(lamina_t* lamina) {
   double max_temp = lamina->epsilon + 1;
   double coeficiente = (lamina->tiempo * lamina->difusividad) / (lamina->distancia * lamina->distancia);
-  double **matriz = lamina->matriz;
-  double **matriz2 = lamina->matriz2;
+  double *matriz = lamina->matriz;
+  double *matriz2 = lamina->matriz2;
+  size_t paso = lamina->paso;
   double epsilon = lamina->epsilon;
   size_t filas = lamina->n_filas;
   size_t columnas = lamina->n_columnas;
 
   while (max_temp > epsilon) {
-    double max_temp_iter = 0.0;
-    for (size_t i = 1; i < filas - 1; ++i) {
-      for (size_t j = 1; j < columnas - 1; ++j) {
-        matriz2[i][j] =  matriz[i][j] + (coeficiente
-          *(matriz[i - 1][j]+ matriz[i][j + 1]
-          + matriz[i + 1][j]+ matriz[i][j - 1]
-          - (4 * matriz[i][j])));
-        double cambio_temp = fabs(matriz[i][j]-matriz2[i][j]);
-        if (cambio_temp > max_temp_iter) {
-          max_temp_iter = cambio_temp;
-        }
-      }
-    }
+    // Calcula las filas internas y el mayor cambio en la misma pasada
+    double max_temp_iter = calcular_filas(matriz, matriz2, paso, columnas,
+      1, filas - 1, coeficiente);
       // Intercambiar punteros de matrices
-    double **temp = matriz;
+    double *temp = matriz;
     matriz = matriz2;
     matriz2 = temp;
     max_temp = max_temp_iter;
@@ -214,7 +159,6 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
   fprintf(archivo_salida, "%s\t%zu\t%lg\t%lg\t%lg\t%zu\t%s\n",
       lamina->nombre, lamina->tiempo, lamina->difusividad,
       lamina->distancia, lamina->epsilon, lamina->iteraciones, duracion);
-  fflush(archivo_salida);
   // nombre del archivo sin extensión
   char nombre_reporte_lamina[BUFFER_MAX] = {0};
   quitar_extension(lamina->nombre, nombre_reporte_lamina);
@@ -235,25 +179,11 @@ int reportar_lamina(FILE* archivo_salida, char* prefijo_ruta_trabajo,
     return EXIT_FAILURE;
     }
 
-  // Abre el archivo binario para escritura
-  FILE* archivo_bin_lamina = fopen(ruta_r_lamina, "wb");
-  if (archivo_bin_lamina == NULL) {
-    fprintf(stderr, "Error al abrir archivo:%s: %s\n",
-      ruta_r_lamina, strerror(errno));
+  // Escribe el encabezado y las filas, sin el relleno, en bloque
+  if (!escribir_matriz(ruta_r_lamina, lamina->n_filas, lamina->n_columnas,
+      lamina->paso, lamina->matriz)) {
     return EXIT_FAILURE;
   }
-  // Escribe el número de filas y columnas en el archivo binario
-  fwrite(&lamina->n_filas, sizeof(size_t), 1, archivo_bin_lamina);
-  fwrite(&lamina->n_columnas, sizeof(size_t), 1, archivo_bin_lamina);
-  // Escribe los valores de la matriz en el archivo binario
-  for (size_t i = 0; i < lamina->n_filas; ++i) {
-    for (size_t j = 0; j < lamina->n_columnas; ++j) {
-      fwrite(&lamina->matriz[i][j], sizeof(double), 1, archivo_bin_lamina);
-    }
-  }
-
-  // Cierra el archivo binario
-  fclose(archivo_bin_lamina);
 
   return EXIT_SUCCESS;
 }
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <errno.h>
 #include <float.h>
+#include "estencil.h"
 #include "miscelaneos.h"
 /**
  * @brief Estructura de datos que representa una lámina de material para
@@ -25,13 +26,19 @@ typedef struct {
    */
   size_t n_columnas;
   /**
-   * @brief La matriz con el estado actual de lámina
+   * @brief Cantidad de doubles entre el inicio de dos filas consecutivas,
+   * múltiplo de la línea de caché
    */
-  double** matriz;
+  size_t paso;
+  /**
+   * @brief La matriz con el estado actual de lámina, la celda (i, j) está en
+   * matriz[i * paso + j]. Las filas y columnas del borde sirven de halo
+   */
+  double* matriz;
   /**
    * @brief La matriz con el estado siguiente
    */
-  double** matriz2;
+  double* matriz2;
   /**
    * @brief Punto de equilibrio, cuando el cambio de cada una las celdas en
    * una iteración es menor al punto de equilibrio, termina la simulación